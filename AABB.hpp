@@ -0,0 +1,19 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Axis-aligned bounding box in world space.
+struct AABB {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+    // Returns the i-th corner (bit 0 = x, bit 1 = y, bit 2 = z).
+    glm::vec3 corner(int i) const {
+        return glm::vec3((i & 1) ? max.x : min.x,
+                         (i & 2) ? max.y : min.y,
+                         (i & 4) ? max.z : min.z);
+    }
+};
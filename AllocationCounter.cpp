@@ -0,0 +1,113 @@
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+static std::atomic<uint64_t> g_totalAllocations{ 0 };
+static thread_local uint64_t t_threadAllocations = 0;
+static std::atomic<AllocationHook> g_allocationHook{ nullptr };
+
+uint64_t totalHeapAllocations() {
+    return g_totalAllocations.load(std::memory_order_relaxed);
+}
+
+uint64_t threadHeapAllocations() {
+    return t_threadAllocations;
+}
+
+void setAllocationHook(AllocationHook hook) {
+    g_allocationHook.store(hook, std::memory_order_relaxed);
+}
+
+uint64_t AllocationGuard::end(const char* what, uint64_t frame) {
+    uint64_t count = threadHeapAllocations() - m_start;
+    if (count != 0) {
+#ifdef ISLAND_STRICT_ALLOCATIONS
+        std::fprintf(stderr, "FATAL: %llu heap allocations in %s (frame %llu)\n",
+                     (unsigned long long)count, what, (unsigned long long)frame);
+        std::abort();
+#else
+        // Rate-limited: the first few offenders, then every 1000th.
+        if (m_reports < 5 || m_reports % 1000 == 0) {
+            std::fprintf(stderr, "WARNING: %llu heap allocations in %s (frame %llu)\n",
+                         (unsigned long long)count, what, (unsigned long long)frame);
+        }
+        m_reports++;
+#endif
+    }
+    return count;
+}
+
+static void countAllocation(size_t bytes) {
+    g_totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    t_threadAllocations++;
+    if (AllocationHook hook = g_allocationHook.load(std::memory_order_relaxed)) hook(bytes);
+}
+
+static void* allocateOrNull(size_t bytes) {
+    countAllocation(bytes);
+    return std::malloc(bytes ? bytes : 1);
+}
+
+static void* allocateAlignedOrNull(size_t bytes, size_t alignment) {
+    countAllocation(bytes);
+    bytes = (bytes + alignment - 1) & ~(alignment - 1);
+#ifdef _WIN32
+    return _aligned_malloc(bytes ? bytes : alignment, alignment);
+#else
+    return std::aligned_alloc(alignment, bytes ? bytes : alignment);
+#endif
+}
+
+static void freeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(size_t bytes) {
+    if (void* p = allocateOrNull(bytes)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t bytes) {
+    if (void* p = allocateOrNull(bytes)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+    return allocateOrNull(bytes);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept {
+    return allocateOrNull(bytes);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    if (void* p = allocateAlignedOrNull(bytes, static_cast<size_t>(alignment))) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment) {
+    if (void* p = allocateAlignedOrNull(bytes, static_cast<size_t>(alignment))) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { freeAligned(p); }
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Counts every call to the global operator new. The counters are maintained by replacement
+// operator new/delete in AllocationCounter.cpp, so they cover the standard library as well.
+
+// Allocations made by all threads since startup.
+uint64_t totalHeapAllocations();
+// Allocations made by the calling thread since startup.
+uint64_t threadHeapAllocations();
+
+// Optional callback invoked on every allocation (e.g. to set a breakpoint or log a stack).
+// It must not allocate itself.
+using AllocationHook = void (*)(size_t bytes);
+void setAllocationHook(AllocationHook hook);
+
+// Checks that the calling thread makes no heap allocations between begin() and end().
+// Used on the steady-state render loop; a non-zero count is reported, and is fatal when
+// built with ISLAND_STRICT_ALLOCATIONS.
+class AllocationGuard {
+public:
+    void begin() { m_start = threadHeapAllocations(); }
+    // Returns the number of allocations since begin().
+    uint64_t end(const char* what, uint64_t frame);
+
+private:
+    uint64_t m_start = 0;
+    uint64_t m_reports = 0;
+};
@@ -0,0 +1,354 @@
+#include "AntiAliasing.hpp"
+#include "ShaderUtils.hpp"
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <glm/gtc/type_ptr.hpp>
+
+// Fullscreen triangle generated from gl_VertexID; the viewport limits it to the rendered region.
+static const char* fullscreenVertexShaderSource = R"(
+#version 330 core
+
+void main()
+{
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// FXAA in the spirit of Lottes' original: find the edge direction from the luma of the four
+// diagonal neighbours, then average along it, falling back to the shorter blur when the longer
+// one overshoots the local luma range.
+static const char* fxaaFragmentShaderSource = R"(
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D scene;
+uniform vec2 texel;     // one texel of the target in UV units
+uniform vec2 uvClamp;   // last texel center inside the rendered region
+
+const float REDUCE_MIN = 1.0 / 128.0;
+const float REDUCE_MUL = 1.0 / 8.0;
+const float SPAN_MAX = 8.0;
+
+vec3 fetch(vec2 uv)
+{
+    return texture(scene, min(uv, uvClamp)).rgb;
+}
+
+float luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy * texel;
+    vec3 center = fetch(uv);
+    float lumaNW = luma(fetch(uv + vec2(-1.0, -1.0) * texel));
+    float lumaNE = luma(fetch(uv + vec2( 1.0, -1.0) * texel));
+    float lumaSW = luma(fetch(uv + vec2(-1.0,  1.0) * texel));
+    float lumaSE = luma(fetch(uv + vec2( 1.0,  1.0) * texel));
+    float lumaM = luma(center);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * REDUCE_MUL, REDUCE_MIN);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-SPAN_MAX), vec2(SPAN_MAX)) * texel;
+
+    vec3 rgbA = 0.5 * (fetch(uv + dir * (1.0 / 3.0 - 0.5)) + fetch(uv + dir * (2.0 / 3.0 - 0.5)));
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (fetch(uv - dir * 0.5) + fetch(uv + dir * 0.5));
+    float lumaB = luma(rgbB);
+    FragColor = vec4((lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB, 1.0);
+}
+)";
+
+// TAA resolve: reproject through depth, clamp the history to the neighbourhood, blend.
+static const char* taaFragmentShaderSource = R"(
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D scene;
+uniform sampler2D depth;
+uniform sampler2D history;
+uniform mat4 reprojection;   // previous view-projection * inverse(current view-projection), unjittered
+uniform vec2 renderSize;     // rendered region in pixels
+uniform vec2 jitter;         // this frame's jitter in NDC
+uniform vec2 historyScale;   // last frame's rendered size / target size
+uniform vec2 historyClamp;   // last texel center inside last frame's rendered region
+uniform float historyWeight; // 0 when there is no usable history
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 last = ivec2(renderSize) - 1;
+    vec3 current = texelFetch(scene, pixel, 0).rgb;
+
+    vec3 lo = current;
+    vec3 hi = current;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            vec3 neighbour = texelFetch(scene, clamp(pixel + ivec2(x, y), ivec2(0), last), 0).rgb;
+            lo = min(lo, neighbour);
+            hi = max(hi, neighbour);
+        }
+    }
+
+    // The pixel's position without this frame's jitter, carried into last frame's clip space.
+    float d = texelFetch(depth, pixel, 0).r;
+    vec2 ndc = gl_FragCoord.xy / renderSize * 2.0 - 1.0 - jitter;
+    vec4 previous = reprojection * vec4(ndc, d * 2.0 - 1.0, 1.0);
+    vec2 previousUV = previous.xy / previous.w * 0.5 + 0.5;
+
+    float weight = historyWeight;
+    if (previous.w <= 0.0 || any(lessThan(previousUV, vec2(0.0))) || any(greaterThan(previousUV, vec2(1.0)))) {
+        weight = 0.0;
+    }
+    vec3 past = texture(history, min(previousUV * historyScale, historyClamp)).rgb;
+    past = clamp(past, lo, hi);
+    FragColor = vec4(mix(current, past, weight), 1.0);
+}
+)";
+
+static constexpr float kHistoryWeight = 0.9f;
+
+// Radical inverse of index in the given base, in [0, 1).
+static float halton(uint32_t index, uint32_t base) {
+    float result = 0.0f;
+    float fraction = 1.0f / base;
+    while (index > 0) {
+        result += fraction * (index % base);
+        index /= base;
+        fraction /= base;
+    }
+    return result;
+}
+
+const char* antiAliasingModeName(AntiAliasingMode mode) {
+    switch (mode) {
+        case AntiAliasingMode::Fxaa: return "FXAA";
+        case AntiAliasingMode::Taa:  return "TAA";
+        default:                     return "off";
+    }
+}
+
+bool parseAntiAliasingMode(const char* name, AntiAliasingMode& mode) {
+    if (std::strcmp(name, "off") == 0 || std::strcmp(name, "none") == 0) {
+        mode = AntiAliasingMode::Off;
+    } else if (std::strcmp(name, "fxaa") == 0) {
+        mode = AntiAliasingMode::Fxaa;
+    } else if (std::strcmp(name, "taa") == 0) {
+        mode = AntiAliasingMode::Taa;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+AntiAliasing::AntiAliasing(AntiAliasingMode mode)
+    : m_mode(mode)
+{
+    m_fxaaProgram = GLProgram::adopt(createShaderProgram(fullscreenVertexShaderSource, fxaaFragmentShaderSource), "AntiAliasing");
+    if (!m_fxaaProgram) {
+        std::cerr << "Failed to create FXAA shader program." << std::endl;
+    } else {
+        m_fxaaSceneLoc = glGetUniformLocation(m_fxaaProgram.id(), "scene");
+        m_fxaaTexelLoc = glGetUniformLocation(m_fxaaProgram.id(), "texel");
+        m_fxaaUVClampLoc = glGetUniformLocation(m_fxaaProgram.id(), "uvClamp");
+    }
+
+    m_taaProgram = GLProgram::adopt(createShaderProgram(fullscreenVertexShaderSource, taaFragmentShaderSource), "AntiAliasing");
+    if (!m_taaProgram) {
+        std::cerr << "Failed to create TAA shader program." << std::endl;
+    } else {
+        m_taaSceneLoc = glGetUniformLocation(m_taaProgram.id(), "scene");
+        m_taaDepthLoc = glGetUniformLocation(m_taaProgram.id(), "depth");
+        m_taaHistoryLoc = glGetUniformLocation(m_taaProgram.id(), "history");
+        m_taaReprojectionLoc = glGetUniformLocation(m_taaProgram.id(), "reprojection");
+        m_taaRenderSizeLoc = glGetUniformLocation(m_taaProgram.id(), "renderSize");
+        m_taaJitterLoc = glGetUniformLocation(m_taaProgram.id(), "jitter");
+        m_taaHistoryScaleLoc = glGetUniformLocation(m_taaProgram.id(), "historyScale");
+        m_taaHistoryClampLoc = glGetUniformLocation(m_taaProgram.id(), "historyClamp");
+        m_taaHistoryWeightLoc = glGetUniformLocation(m_taaProgram.id(), "historyWeight");
+    }
+
+    m_emptyVAO = GLVertexArray::create("AntiAliasing");
+    std::cout << "Anti-aliasing: " << antiAliasingModeName(m_mode) << std::endl;
+}
+
+AntiAliasing::~AntiAliasing() = default;
+
+void AntiAliasing::setMode(AntiAliasingMode mode) {
+    if (mode == m_mode) return;
+    m_mode = mode;
+    m_historyValid = false;
+    std::cout << "Anti-aliasing: " << antiAliasingModeName(m_mode) << std::endl;
+}
+
+void AntiAliasing::cycleMode() {
+    setMode(static_cast<AntiAliasingMode>((static_cast<int>(m_mode) + 1) % kModeCount));
+}
+
+void AntiAliasing::allocate(Target& target, const char* what) {
+    target.framebuffer.reset();
+    target.texture = GLTexture::create("AntiAliasing");
+    glBindTexture(GL_TEXTURE_2D, target.texture.id());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_targetWidth, m_targetHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    target.texture.setStorage(glTextureBytes(GL_RGBA8, m_targetWidth, m_targetHeight), what);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    target.framebuffer = GLFramebuffer::create("AntiAliasing");
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer.id());
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture.id(), 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Anti-aliasing framebuffer is incomplete." << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void AntiAliasing::beginFrame(int targetWidth, int targetHeight) {
+    readTimings();
+
+    if (targetWidth != m_targetWidth || targetHeight != m_targetHeight) {
+        m_targetWidth = targetWidth;
+        m_targetHeight = targetHeight;
+        // Reallocated on first use at the new size.
+        m_history[0] = Target();
+        m_history[1] = Target();
+        m_historyValid = false;
+    }
+
+    // The history is only allocated once TAA gets used.
+    if (m_mode == AntiAliasingMode::Taa && !m_history[0].texture) {
+        allocate(m_history[0], "RGBA8 TAA history");
+        allocate(m_history[1], "RGBA8 TAA history");
+    }
+    m_historyIndex ^= 1;
+}
+
+glm::mat4 AntiAliasing::jitter(const glm::mat4& projection, int renderWidth, int renderHeight, bool hold) {
+    if (m_mode != AntiAliasingMode::Taa) {
+        m_jitterNdc = glm::vec2(0.0f);
+        return projection;
+    }
+    // Halton (2, 3) covers the pixel evenly in a few frames; the cycle restarts at 1 to skip (0, 0).
+    if (!hold) m_jitterIndex++;
+    uint32_t phase = m_jitterIndex % kJitterPhases + 1;
+    glm::vec2 pixelOffset(halton(phase, 2) - 0.5f, halton(phase, 3) - 0.5f);
+    m_jitterNdc = glm::vec2(pixelOffset.x * 2.0f / renderWidth, pixelOffset.y * 2.0f / renderHeight);
+
+    // Column 2 scales with view-space z and w = -z, so subtracting here shifts NDC by +jitter.
+    glm::mat4 jittered = projection;
+    jittered[2][0] -= m_jitterNdc.x;
+    jittered[2][1] -= m_jitterNdc.y;
+    return jittered;
+}
+
+GLuint AntiAliasing::outputTexture() const {
+    return m_mode == AntiAliasingMode::Taa ? m_history[m_historyIndex].texture.id() : 0;
+}
+
+GLuint AntiAliasing::outputFramebuffer() const {
+    return m_mode == AntiAliasingMode::Taa ? m_history[m_historyIndex].framebuffer.id() : 0;
+}
+
+void AntiAliasing::resolve(GLuint sceneColor, GLuint sceneDepth, int renderWidth, int renderHeight,
+                           const glm::mat4& viewProjection, GLuint fxaaOutput) {
+    if (m_mode == AntiAliasingMode::Off) return;
+
+    m_gpuTimer.begin();
+    glBindFramebuffer(GL_FRAMEBUFFER, m_mode == AntiAliasingMode::Fxaa ? fxaaOutput : outputFramebuffer());
+    glViewport(0, 0, renderWidth, renderHeight);
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(m_emptyVAO.id());
+    if (m_mode == AntiAliasingMode::Fxaa) {
+        resolveFxaa(sceneColor, renderWidth, renderHeight);
+    } else {
+        resolveTaa(sceneColor, sceneDepth, renderWidth, renderHeight, viewProjection);
+    }
+    glBindVertexArray(0);
+    glUseProgram(0);
+    glEnable(GL_DEPTH_TEST);
+    telemetry::countDraw(1);
+    telemetry::add(telemetry::Counter::StateChanges, 3);
+
+    m_gpuTimer.end(m_mode);
+}
+
+void AntiAliasing::resolveFxaa(GLuint sceneColor, int renderWidth, int renderHeight) {
+    if (!m_fxaaProgram) return;
+    glUseProgram(m_fxaaProgram.id());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sceneColor);
+    glUniform1i(m_fxaaSceneLoc, 0);
+    glUniform2f(m_fxaaTexelLoc, 1.0f / m_targetWidth, 1.0f / m_targetHeight);
+    glUniform2f(m_fxaaUVClampLoc, (renderWidth - 0.5f) / m_targetWidth, (renderHeight - 0.5f) / m_targetHeight);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    telemetry::add(telemetry::Counter::TextureBinds);
+}
+
+void AntiAliasing::resolveTaa(GLuint sceneColor, GLuint sceneDepth, int renderWidth, int renderHeight,
+                              const glm::mat4& viewProjection) {
+    if (!m_taaProgram) return;
+    const Target& history = m_history[m_historyIndex ^ 1];
+    glm::mat4 reprojection = m_previousViewProjection * glm::inverse(viewProjection);
+
+    glUseProgram(m_taaProgram.id());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sceneColor);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, sceneDepth);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, history.texture.id());
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(m_taaSceneLoc, 0);
+    glUniform1i(m_taaDepthLoc, 1);
+    glUniform1i(m_taaHistoryLoc, 2);
+    glUniformMatrix4fv(m_taaReprojectionLoc, 1, GL_FALSE, glm::value_ptr(reprojection));
+    glUniform2f(m_taaRenderSizeLoc, static_cast<float>(renderWidth), static_cast<float>(renderHeight));
+    glUniform2f(m_taaJitterLoc, m_jitterNdc.x, m_jitterNdc.y);
+    glUniform2f(m_taaHistoryScaleLoc, (float)m_previousRenderWidth / m_targetWidth, (float)m_previousRenderHeight / m_targetHeight);
+    glUniform2f(m_taaHistoryClampLoc, (m_previousRenderWidth - 0.5f) / m_targetWidth, (m_previousRenderHeight - 0.5f) / m_targetHeight);
+    glUniform1f(m_taaHistoryWeightLoc, m_historyValid ? kHistoryWeight : 0.0f);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    telemetry::add(telemetry::Counter::TextureBinds, 3);
+
+    m_previousViewProjection = viewProjection;
+    m_previousRenderWidth = renderWidth;
+    m_previousRenderHeight = renderHeight;
+    m_historyValid = true;
+}
+
+void AntiAliasing::readTimings() {
+    m_gpuTimer.poll([this](AntiAliasingMode mode, GLuint64 startNs, GLuint64 endNs) {
+        float ms = static_cast<float>((endNs - startNs) / 1.0e6);
+        ModeStats& stats = m_stats[static_cast<int>(mode)];
+        stats.frames++;
+        stats.totalMs += ms;
+        stats.maxMs = std::max(stats.maxMs, ms);
+    });
+}
+
+void AntiAliasing::printStats() const {
+    std::cout << std::fixed << std::setprecision(3) << "Anti-aliasing GPU cost:";
+    bool any = false;
+    for (int mode = 1; mode < kModeCount; ++mode) {
+        const ModeStats& stats = m_stats[mode];
+        if (stats.frames == 0) continue;
+        std::cout << (any ? "," : "") << " " << antiAliasingModeName(static_cast<AntiAliasingMode>(mode))
+                  << " avg " << (stats.totalMs / stats.frames) << " ms / max " << stats.maxMs << " ms over "
+                  << stats.frames << " frames";
+        any = true;
+    }
+    std::cout << (any ? "" : " no resolves timed") << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GLResource.hpp"
+#include "GpuTimer.hpp"
+
+enum class AntiAliasingMode : uint8_t { Off, Fxaa, Taa };
+
+const char* antiAliasingModeName(AntiAliasingMode mode);
+// Parses "off", "fxaa" or "taa"; false leaves mode alone.
+bool parseAntiAliasingMode(const char* name, AntiAliasingMode& mode);
+
+// Post-process anti-aliasing of the offscreen scene, as a cheaper alternative to MSAA.
+//
+// FXAA is a single pass that blurs along the luma edges it finds. TAA jitters the projection
+// by a sub-pixel Halton offset every frame, reprojects last frame's result through the depth
+// buffer and the previous view-projection, clamps it to the current pixel's 3x3 neighbourhood
+// (there are no motion vectors, so this is what keeps the windmill blades from ghosting) and
+// blends it in. Both work on the used part of the scene target and write a target of the same
+// size, so the upscale reads either interchangeably. FXAA writes into whatever the caller
+// provides (a render-graph transient); TAA owns its two history targets, which outlive the frame.
+//
+// Every resolve is timed with a GpuTimer and averaged per mode, so the modes can be compared
+// on each machine.
+class AntiAliasing {
+public:
+    explicit AntiAliasing(AntiAliasingMode mode = AntiAliasingMode::Fxaa);
+    ~AntiAliasing();
+
+    AntiAliasing(const AntiAliasing&) = delete;
+    AntiAliasing& operator=(const AntiAliasing&) = delete;
+
+    AntiAliasingMode mode() const { return m_mode; }
+    void setMode(AntiAliasingMode mode);
+    void cycleMode();
+
+    // Sizes the TAA history for this frame's target and picks the slot to write.
+    // outputTexture() and outputFramebuffer() are valid from here on; both are 0 unless TAA is on.
+    void beginFrame(int targetWidth, int targetHeight);
+    // The projection to render with: offset by this frame's sub-pixel jitter under TAA.
+    // hold repeats the previous frame's offset instead of advancing the sequence.
+    glm::mat4 jitter(const glm::mat4& projection, int renderWidth, int renderHeight, bool hold = false);
+    // Resolves the renderWidth x renderHeight corner of the scene target. FXAA writes into
+    // fxaaOutput; TAA writes outputFramebuffer() and ignores fxaaOutput.
+    // viewProjection is the unjittered one; TAA keeps it for next frame's reprojection.
+    void resolve(GLuint sceneColor, GLuint sceneDepth, int renderWidth, int renderHeight,
+                 const glm::mat4& viewProjection, GLuint fxaaOutput);
+
+    // This frame's TAA history slot.
+    GLuint outputTexture() const;
+    GLuint outputFramebuffer() const;
+
+    // Average and worst GPU time of every mode that has been used.
+    void printStats() const;
+
+private:
+    static constexpr int kModeCount = 3;
+    static constexpr int kJitterPhases = 8;
+
+    struct Target {
+        GLTexture texture;
+        GLFramebuffer framebuffer;
+    };
+
+    struct ModeStats {
+        uint64_t frames = 0;
+        double totalMs = 0.0;
+        float maxMs = 0.0f;
+    };
+
+    AntiAliasingMode m_mode;
+    int m_targetWidth = 0;
+    int m_targetHeight = 0;
+
+    Target m_history[2];
+    int m_historyIndex = 0;       // slot TAA writes this frame; the other holds last frame
+    bool m_historyValid = false;
+    glm::mat4 m_previousViewProjection{ 1.0f };
+    int m_previousRenderWidth = 0;
+    int m_previousRenderHeight = 0;
+    glm::vec2 m_jitterNdc{ 0.0f };
+    uint32_t m_jitterIndex = 0;
+
+    GLProgram m_fxaaProgram;
+    GLint m_fxaaSceneLoc = -1;
+    GLint m_fxaaTexelLoc = -1;
+    GLint m_fxaaUVClampLoc = -1;
+
+    GLProgram m_taaProgram;
+    GLint m_taaSceneLoc = -1;
+    GLint m_taaDepthLoc = -1;
+    GLint m_taaHistoryLoc = -1;
+    GLint m_taaReprojectionLoc = -1;
+    GLint m_taaRenderSizeLoc = -1;
+    GLint m_taaJitterLoc = -1;
+    GLint m_taaHistoryScaleLoc = -1;
+    GLint m_taaHistoryClampLoc = -1;
+    GLint m_taaHistoryWeightLoc = -1;
+
+    GLVertexArray m_emptyVAO;
+
+    GpuTimer<AntiAliasingMode> m_gpuTimer{ "AntiAliasing" };
+    ModeStats m_stats[kModeCount];
+
+    void allocate(Target& target, const char* what);
+    void resolveFxaa(GLuint sceneColor, int renderWidth, int renderHeight);
+    void resolveTaa(GLuint sceneColor, GLuint sceneDepth, int renderWidth, int renderHeight,
+                    const glm::mat4& viewProjection);
+    void readTimings();
+};
@@ -0,0 +1,150 @@
+#include "AssetBundle.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+// The one stb_image implementation in the program lives next to the loaders that use it.
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace bundle_format;
+
+AssetBundle& AssetBundle::instance() {
+    static AssetBundle bundle;
+    return bundle;
+}
+
+AssetBundle::~AssetBundle() {
+#ifndef _WIN32
+    if (m_base && m_fallback.empty()) {
+        munmap(const_cast<std::byte*>(m_base), m_size);
+    }
+#endif
+}
+
+bool AssetBundle::mount(const char* path) {
+    if (m_base) return true;
+
+    const std::byte* base = nullptr;
+    size_t size = 0;
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        size = static_cast<size_t>(info.st_size);
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) base = static_cast<const std::byte*>(mapping);
+    }
+    close(fd); // the mapping keeps the file alive
+#else
+    std::ifstream stream(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!stream.is_open()) return false;
+    m_fallback.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    stream.read(reinterpret_cast<char*>(m_fallback.data()), m_fallback.size());
+    base = m_fallback.data();
+    size = m_fallback.size();
+#endif
+    if (!base) {
+        std::cerr << "Failed to map asset bundle: " << path << std::endl;
+        return false;
+    }
+
+    // Validate everything find() relies on once, up front.
+    const BundleHeader* header = reinterpret_cast<const BundleHeader*>(base);
+    bool valid = size >= sizeof(BundleHeader) && std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 &&
+                 header->version == kVersion && header->fileSize == size && header->slotCount > 0 &&
+                 (header->slotCount & (header->slotCount - 1)) == 0 &&
+                 sizeof(BundleHeader) + static_cast<uint64_t>(header->slotCount) * sizeof(BundleSlot) <= size;
+    const BundleSlot* slots = reinterpret_cast<const BundleSlot*>(base + sizeof(BundleHeader));
+    for (uint32_t i = 0; valid && i < header->slotCount; ++i) {
+        const BundleSlot& slot = slots[i];
+        if (slot.hash == 0) continue;
+        valid = slot.offset + slot.size < size && static_cast<uint64_t>(slot.pathOffset) + slot.pathLength <= size;
+    }
+    if (!valid) {
+        std::cerr << "Asset bundle " << path << " is invalid or from another version, using loose files." << std::endl;
+#ifndef _WIN32
+        munmap(const_cast<std::byte*>(base), size);
+#endif
+        m_fallback.clear();
+        return false;
+    }
+
+    m_base = base;
+    m_size = size;
+    m_header = header;
+    m_slots = slots;
+    std::cout << "Asset bundle mounted: " << path << " (" << header->entryCount << " entries, "
+              << size / 1024 << " KiB)" << std::endl;
+    return true;
+}
+
+std::span<const std::byte> AssetBundle::find(std::string_view path) const {
+    if (!m_base) return {};
+
+    const uint64_t hash = hashPath(path);
+    const uint32_t mask = m_header->slotCount - 1;
+    for (uint32_t probe = 0; probe <= mask; ++probe) {
+        const BundleSlot& slot = m_slots[(hash + probe) & mask];
+        if (slot.hash == 0) break;
+        if (slot.hash == hash && slot.pathLength == path.size() &&
+            std::memcmp(m_base + slot.pathOffset, path.data(), path.size()) == 0) {
+            return { m_base + slot.offset, static_cast<size_t>(slot.size) };
+        }
+    }
+    return {};
+}
+
+void AssetBundle::prefetch(std::span<const char* const> paths) const {
+#ifndef _WIN32
+    if (!m_base || !m_fallback.empty()) return;
+    for (const char* path : paths) {
+        std::span<const std::byte> entry = find(path);
+        if (entry.empty()) continue;
+        // Entries start on page boundaries; the length may end mid-page.
+        madvise(const_cast<std::byte*>(entry.data()), entry.size(), MADV_WILLNEED);
+    }
+#else
+    (void)paths;
+#endif
+}
+
+
+unsigned char* loadImage(const char* path, int* width, int* height, int* channels, int desiredChannels,
+                         bool flipVertically) {
+    stbi_set_flip_vertically_on_load_thread(flipVertically);
+    std::span<const std::byte> entry = AssetBundle::instance().find(path);
+    if (entry.empty()) {
+        return stbi_load(path, width, height, channels, desiredChannels);
+    }
+    return stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(entry.data()), static_cast<int>(entry.size()),
+                                 width, height, channels, desiredChannels);
+}
+
+unsigned short* loadImage16(const char* path, int* width, int* height, int* channels, int desiredChannels,
+                            bool flipVertically) {
+    stbi_set_flip_vertically_on_load_thread(flipVertically);
+    std::span<const std::byte> entry = AssetBundle::instance().find(path);
+    if (entry.empty()) {
+        return stbi_load_16(path, width, height, channels, desiredChannels);
+    }
+    return stbi_load_16_from_memory(reinterpret_cast<const stbi_uc*>(entry.data()), static_cast<int>(entry.size()),
+                                    width, height, channels, desiredChannels);
+}
+
+bool isImage16Bit(const char* path) {
+    std::span<const std::byte> entry = AssetBundle::instance().find(path);
+    if (entry.empty()) {
+        return stbi_is_16_bit(path) != 0;
+    }
+    return stbi_is_16_bit_from_memory(reinterpret_cast<const stbi_uc*>(entry.data()), static_cast<int>(entry.size())) != 0;
+}
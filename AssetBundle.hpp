@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Hash.hpp"
+
+// On-disk layout of an asset bundle, shared by the runtime and the bundle_builder tool.
+//
+//   BundleHeader
+//   BundleSlot[slotCount]   open-addressed hash table keyed by the FNV-1a hash of the path
+//   path strings
+//   entry data, each entry starting on a kBundleAlignment boundary and followed by a NUL byte
+//
+// Paths are stored as the loaders ask for them, e.g. "assets/right.png" or "shaders/SimpleColor.vert".
+namespace bundle_format {
+
+constexpr char kMagic[8] = { 'I', 'S', 'L', 'P', 'A', 'K', '\0', '\0' };
+constexpr uint32_t kVersion = 1;
+// Page sized, so every entry can be prefetched or mapped on its own.
+constexpr uint64_t kBundleAlignment = 4096;
+
+struct BundleHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t slotCount;     // power of two
+    uint32_t reserved;
+    uint64_t fileSize;
+};
+
+struct BundleSlot {
+    uint64_t hash;          // 0 marks an empty slot
+    uint64_t offset;        // from the start of the file
+    uint64_t size;          // without the trailing NUL
+    uint32_t pathOffset;    // from the start of the file
+    uint32_t pathLength;
+};
+
+// Files in the order the program first reads them. bundle_builder packs them at the front of
+// the bundle and main() prefetches them, so both follow this one list.
+inline constexpr const char* kLoadOrder[] = {
+    "shaders/SimpleColor.vert", "shaders/SimpleColor.frag", "assets/bricks.jpg",
+    "assets/heightmap.png", "assets/sand.png", "assets/grass.png", "assets/rock.png",
+    "assets/right.png", "assets/left.png", "assets/top.png", "assets/bottom.png",
+    "assets/front.png", "assets/back.png",
+};
+
+// Where the entry after one at offset with size bytes starts: past its trailing NUL, on the
+// next alignment boundary.
+inline uint64_t nextEntryOffset(uint64_t offset, uint64_t size) {
+    return (offset + size + 1 + kBundleAlignment - 1) / kBundleAlignment * kBundleAlignment;
+}
+
+inline uint64_t hashPath(std::string_view path) {
+    uint64_t hash = fnv1a(path.data(), path.size());
+    return hash == 0 ? 1 : hash; // keep 0 free for empty slots
+}
+
+} // namespace bundle_format
+
+// Read-only view of a bundle mapped into memory once at startup.
+// Lookups return spans straight into the mapping, so loaders decode from it without copying
+// the file contents; the mapping stays valid until the program exits.
+class AssetBundle {
+public:
+    static AssetBundle& instance();
+
+    AssetBundle(const AssetBundle&) = delete;
+    AssetBundle& operator=(const AssetBundle&) = delete;
+
+    // Maps the bundle at path. Returns false, leaving loaders on loose files, if it is missing or invalid.
+    bool mount(const char* path);
+    bool isMounted() const { return m_base != nullptr; }
+
+    // Contents of the entry stored under path, or an empty span. Entries are followed by a NUL
+    // byte, so text entries can be used as C strings directly.
+    std::span<const std::byte> find(std::string_view path) const;
+
+    // Asks the kernel to start reading these entries in the given order (madvise(MADV_WILLNEED)).
+    void prefetch(std::span<const char* const> paths) const;
+
+    size_t entryCount() const { return m_header ? m_header->entryCount : 0; }
+    size_t sizeBytes() const { return m_size; }
+
+private:
+    AssetBundle() = default;
+    ~AssetBundle();
+
+    const std::byte* m_base = nullptr;
+    size_t m_size = 0;
+    const bundle_format::BundleHeader* m_header = nullptr;
+    const bundle_format::BundleSlot* m_slots = nullptr;
+    std::vector<std::byte> m_fallback; // whole-file copy where mmap is unavailable
+};
+
+// stb_image loaders that decode from the mounted bundle when it holds `path`, and from the
+// loose file otherwise. Free the result with stbi_image_free(). The flip applies to this call
+// only, so decodes running on other threads at the same time cannot change each other's rows.
+unsigned char* loadImage(const char* path, int* width, int* height, int* channels, int desiredChannels,
+                         bool flipVertically = false);
+unsigned short* loadImage16(const char* path, int* width, int* height, int* channels, int desiredChannels,
+                            bool flipVertically = false);
+bool isImage16Bit(const char* path);
@@ -0,0 +1,157 @@
+// Packs asset files into one bundle for AssetBundle to map at startup.
+//
+//   bundle_builder <output.pak> <file-or-directory>...
+//
+// The files in bundle_format::kLoadOrder come first, in the order the program loads them, so
+// the kernel reads the bundle front to back; the arguments follow in the order given.
+// Directories add every file below them in sorted order; files already added are skipped, so
+// a directory picks up whatever the load order left out. Paths are stored exactly as written,
+// relative to the working directory.
+#include "AssetBundle.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace bundle_format;
+
+namespace {
+
+struct Entry {
+    std::string path;
+    std::vector<char> data;
+};
+
+bool readFile(const std::string& path, std::vector<char>& data) {
+    std::ifstream stream(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!stream.is_open()) return false;
+    data.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    return static_cast<bool>(stream.read(data.data(), data.size()));
+}
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <output.pak> <file-or-directory>..." << std::endl;
+        return 1;
+    }
+
+    // Collect paths in load order.
+    std::vector<std::string> paths;
+    std::unordered_set<std::string> seen;
+    auto add = [&](const std::string& path) {
+        if (seen.insert(path).second) paths.push_back(path);
+    };
+    for (const char* path : kLoadOrder) {
+        std::error_code error;
+        if (fs::is_regular_file(path, error)) {
+            add(path);
+        } else {
+            std::cerr << "Skipping missing asset: " << path << std::endl;
+        }
+    }
+    for (int i = 2; i < argc; ++i) {
+        std::error_code error;
+        if (fs::is_directory(argv[i], error)) {
+            std::vector<std::string> files;
+            for (const fs::directory_entry& entry : fs::recursive_directory_iterator(argv[i])) {
+                if (entry.is_regular_file()) files.push_back(entry.path().generic_string());
+            }
+            std::sort(files.begin(), files.end());
+            for (const std::string& file : files) add(file);
+        } else if (fs::is_regular_file(argv[i], error)) {
+            add(fs::path(argv[i]).generic_string());
+        } else {
+            std::cerr << "Skipping missing asset: " << argv[i] << std::endl;
+        }
+    }
+
+    if (paths.empty()) {
+        std::cerr << "No assets to pack" << std::endl;
+        return 1;
+    }
+
+    std::vector<Entry> entries(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        entries[i].path = paths[i];
+        if (!readFile(paths[i], entries[i].data)) {
+            std::cerr << "Failed to read " << paths[i] << std::endl;
+            return 1;
+        }
+    }
+
+    // Open addressing at a load factor of at most 1/2 keeps probes short.
+    uint32_t slotCount = 1;
+    while (slotCount < entries.size() * 2) slotCount <<= 1;
+
+    std::vector<BundleSlot> slots(slotCount, BundleSlot{});
+    uint64_t pathOffset = sizeof(BundleHeader) + sizeof(BundleSlot) * static_cast<uint64_t>(slotCount);
+    uint64_t pathBytes = 0;
+    for (const Entry& entry : entries) pathBytes += entry.path.size();
+
+    uint64_t dataOffset = alignUp(pathOffset + pathBytes, kBundleAlignment);
+    std::vector<uint64_t> offsets(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+        uint64_t hash = hashPath(entry.path);
+        uint32_t index = static_cast<uint32_t>(hash) & (slotCount - 1);
+        while (slots[index].hash != 0) index = (index + 1) & (slotCount - 1);
+
+        offsets[i] = dataOffset;
+        BundleSlot& slot = slots[index];
+        slot.hash = hash;
+        slot.offset = dataOffset;
+        slot.size = entry.data.size();
+        slot.pathOffset = static_cast<uint32_t>(pathOffset);
+        slot.pathLength = static_cast<uint32_t>(entry.path.size());
+
+        pathOffset += entry.path.size();
+        dataOffset = nextEntryOffset(dataOffset, entry.data.size());
+    }
+
+    BundleHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.slotCount = slotCount;
+    header.fileSize = dataOffset;
+
+    std::ofstream out(argv[1], std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open " << argv[1] << " for writing" << std::endl;
+        return 1;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(slots.data()), sizeof(BundleSlot) * slots.size());
+    for (const Entry& entry : entries) out.write(entry.path.data(), entry.path.size());
+
+    // Entries go exactly where the slots say; the zero padding in between holds each one's NUL.
+    const std::vector<char> padding(kBundleAlignment, '\0');
+    uint64_t position = sizeof(BundleHeader) + sizeof(BundleSlot) * static_cast<uint64_t>(slotCount) + pathBytes;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        out.write(padding.data(), static_cast<std::streamsize>(offsets[i] - position));
+        out.write(entries[i].data.data(), entries[i].data.size());
+        position = offsets[i] + entries[i].data.size();
+    }
+    const uint64_t end = dataOffset;
+    out.write(padding.data(), static_cast<std::streamsize>(end - position));
+
+    if (!out) {
+        std::cerr << "Failed to write " << argv[1] << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << argv[1] << ": " << entries.size() << " entries, " << end / 1024 << " KiB" << std::endl;
+    return 0;
+}
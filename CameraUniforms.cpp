@@ -0,0 +1,39 @@
+#include "CameraUniforms.hpp"
+#include "Telemetry.hpp"
+
+#include <cstring>
+#include <iostream>
+
+static const char* cameraBlockShaderSource = R"(
+layout(std140) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+};
+)";
+
+void CameraUniforms::latch(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position, StreamBuffer& stream) {
+    StreamAllocation allocation = stream.allocateUniform(sizeof(Block));
+    if (!allocation) return;
+
+    Block block{ view, projection, projection * view, glm::vec4(position, 1.0f) };
+    std::memcpy(allocation.data, &block, sizeof(block));
+    stream.flush();
+    glBindBufferRange(GL_UNIFORM_BUFFER, kCameraBlockBinding, stream.buffer(), allocation.offset, allocation.size);
+    telemetry::add(telemetry::Counter::StateChanges);
+}
+
+const char* CameraUniforms::shaderLibrary() {
+    return cameraBlockShaderSource;
+}
+
+void CameraUniforms::setupProgram(GLuint program) {
+    GLuint block = glGetUniformBlockIndex(program, "CameraBlock");
+    if (block == GL_INVALID_INDEX) {
+        std::cerr << "Program " << program << " does not read the camera block." << std::endl;
+        return;
+    }
+    glUniformBlockBinding(program, block, kCameraBlockBinding);
+}
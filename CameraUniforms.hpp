@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "StreamBuffer.hpp"
+
+// The camera matrices every scene shader reads, in one uniform block at a fixed binding.
+//
+// Draws no longer get the camera as uniforms set early in the frame; latch() writes the block
+// from the camera as it is right before the draws run, so the last input sampled is what ends
+// up on screen. Binding 0 is also where uniform blocks point by default, so a program that
+// declares the block reads it even without setupProgram().
+class CameraUniforms {
+public:
+    static constexpr GLuint kCameraBlockBinding = 0;
+
+    // std140 layout of CameraBlock.
+    struct Block {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 viewProjection;
+        glm::vec4 position; // w unused
+    };
+
+    // Writes the block into stream and binds it for the draws that follow.
+    static void latch(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position, StreamBuffer& stream);
+
+    // GLSL declaring CameraBlock, whose members view, projection, viewProjection and
+    // cameraPosition are then plain names. Splice it in with withShaderLibrary().
+    static const char* shaderLibrary();
+    static void setupProgram(GLuint program);
+};
@@ -0,0 +1,365 @@
+#include "ClusteredLighting.hpp"
+#include "FrameArena.hpp"
+#include "JobSystem.hpp"
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <glm/gtc/type_ptr.hpp>
+
+// Depth slices are spaced exponentially from here to the far plane; everything nearer
+// falls into the first slice, which would otherwise be uselessly thin.
+static constexpr float kSliceNear = 2.0f;
+
+static const char* clusteredLightingShaderSource = R"(
+layout(std140) uniform ClusterBlock
+{
+    vec4 clusterParams; // xy: clusters per pixel, z: slices per log unit of depth, w: slice bias
+};
+uniform samplerBuffer clusterLights;   // two texels per light: position + radius, color * intensity
+uniform usamplerBuffer clusterGrid;    // per cluster: first entry in clusterIndices, light count
+uniform usamplerBuffer clusterIndices;
+
+vec3 clusteredPointLights(vec3 worldPos, vec3 normal, float viewDepth)
+{
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy * clusterParams.xy),
+                          int(floor(log(max(viewDepth, 1e-3)) * clusterParams.z + clusterParams.w)));
+    cluster = clamp(cluster, ivec3(0), ivec3(CLUSTERS_X - 1, CLUSTERS_Y - 1, CLUSTERS_Z - 1));
+    uvec2 range = texelFetch(clusterGrid, (cluster.z * CLUSTERS_Y + cluster.y) * CLUSTERS_X + cluster.x).xy;
+
+    vec3 total = vec3(0.0);
+    for (uint i = 0u; i < range.y; ++i) {
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(clusterLights, 2 * light);
+        vec3 toLight = positionRadius.xyz - worldPos;
+        float distance = length(toLight);
+        // Reaches exactly zero at the radius the lights were binned with.
+        float falloff = clamp(1.0 - distance / positionRadius.w, 0.0, 1.0);
+        float diffuse = max(dot(normal, toLight / max(distance, 1e-4)), 0.0);
+        total += texelFetch(clusterLights, 2 * light + 1).rgb * (falloff * falloff * diffuse);
+    }
+    return total;
+}
+)";
+
+static int sliceOf(float depth, float sliceNear, float sliceScale) {
+    int slice = static_cast<int>(std::floor(std::log(std::max(depth, 1e-3f) / sliceNear) * sliceScale));
+    return std::clamp(slice, 0, ClusteredLighting::kClustersZ - 1);
+}
+
+static int clusterIndex(int x, int y, int z) {
+    return (z * ClusteredLighting::kClustersY + y) * ClusteredLighting::kClustersX + x;
+}
+
+// Creates a buffer texture over a buffer of `bytes`, left uninitialized.
+static void createBufferTexture(GLBuffer& buffer, GLTexture& texture, GLenum internalFormat, size_t bytes,
+                                const char* owner, const char* format) {
+    buffer = GLBuffer::create(owner);
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer.id());
+    glBufferData(GL_TEXTURE_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    buffer.setStorage(bytes, format);
+
+    texture = GLTexture::create(owner);
+    glBindTexture(GL_TEXTURE_BUFFER, texture.id());
+    glTexBuffer(GL_TEXTURE_BUFFER, internalFormat, buffer.id());
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+
+ClusteredLighting::ClusteredLighting() {
+    // Everything the per-frame path touches is allocated here, at its maximum size.
+    m_lights.reserve(kMaxLights);
+    m_ranges.resize(kMaxLights);
+    m_clusterMin.resize(kClusterCount);
+    m_clusterMax.resize(kClusterCount);
+    m_binned.resize(static_cast<size_t>(kClusterCount) * kMaxLightsPerCluster);
+    m_binnedCount.resize(kClusterCount, 0);
+    m_grid.resize(static_cast<size_t>(kClusterCount) * 2, 0);
+    m_indices.resize(static_cast<size_t>(kClusterCount) * kMaxLightsPerCluster);
+
+    createBufferTexture(m_lightBuffer, m_lightTexture, GL_RGBA32F, kMaxLights * 2 * sizeof(glm::vec4),
+                        "ClusteredLighting", "lights RGBA32F x2");
+    createBufferTexture(m_gridBuffer, m_gridTexture, GL_RG32UI, m_grid.size() * sizeof(uint32_t),
+                        "ClusteredLighting", "cluster grid RG32UI");
+    createBufferTexture(m_indexBuffer, m_indexTexture, GL_R16UI, m_indices.size() * sizeof(uint16_t),
+                        "ClusteredLighting", "light indices R16UI");
+}
+
+ClusteredLighting::~ClusteredLighting() = default;
+
+void ClusteredLighting::setLights(const PointLight* lights, size_t count) {
+    count = std::min(count, static_cast<size_t>(kMaxLights));
+    m_lights.assign(lights, lights + count);
+    if (count == 0) return;
+
+    LinearArena& arena = scratchArena();
+    ArenaScope scratchScope(arena);
+    glm::vec4* texels = arena.allocateArray<glm::vec4>(count * 2);
+    if (!texels) return;
+    for (size_t i = 0; i < count; ++i) {
+        texels[2 * i] = glm::vec4(lights[i].position, lights[i].radius);
+        texels[2 * i + 1] = glm::vec4(lights[i].color * lights[i].intensity, 0.0f);
+    }
+    size_t bytes = count * 2 * sizeof(glm::vec4);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_lightBuffer.id());
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, texels);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    telemetry::add(telemetry::Counter::BytesUploaded, bytes);
+}
+
+void ClusteredLighting::update(const glm::mat4& view, const glm::mat4& projection, int renderWidth, int renderHeight,
+                               StreamBuffer& stream) {
+    auto start = std::chrono::steady_clock::now();
+
+    m_view = view;
+    m_projection = projection;
+    if (projection != m_boundsProjection) {
+        updateClusterBounds(projection);
+    }
+
+    m_overflows.store(0, std::memory_order_relaxed);
+    int lightCount = static_cast<int>(m_lights.size());
+    if (lightCount > 0) {
+        run(Stage::LightRanges, (lightCount + kLightsPerTask - 1) / kLightsPerTask);
+        run(Stage::BinSlices, kClustersZ);
+    } else {
+        std::fill(m_binnedCount.begin(), m_binnedCount.end(), 0u);
+    }
+
+    // Prefix sum and compaction; cheap next to the binning, so it stays on this thread.
+    uint32_t offset = 0;
+    for (int cluster = 0; cluster < kClusterCount; ++cluster) {
+        uint32_t count = m_binnedCount[cluster];
+        m_grid[2 * cluster] = offset;
+        m_grid[2 * cluster + 1] = count;
+        std::memcpy(&m_indices[offset], &m_binned[static_cast<size_t>(cluster) * kMaxLightsPerCluster], count * sizeof(uint16_t));
+        offset += count;
+    }
+
+    // Orphan and refill, so the driver never waits on last frame's draws still reading the old data.
+    size_t gridBytes = m_grid.size() * sizeof(uint32_t);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_gridBuffer.id());
+    glBufferData(GL_TEXTURE_BUFFER, gridBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, gridBytes, m_grid.data());
+    size_t indexBytes = offset * sizeof(uint16_t);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_indexBuffer.id());
+    glBufferData(GL_TEXTURE_BUFFER, m_indices.size() * sizeof(uint16_t), nullptr, GL_STREAM_DRAW);
+    if (indexBytes > 0) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, indexBytes, m_indices.data());
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    telemetry::add(telemetry::Counter::BytesUploaded, gridBytes + indexBytes);
+
+    StreamAllocation block = stream.allocateUniform(sizeof(glm::vec4));
+    if (block) {
+        float sliceBias = -std::log(m_sliceNear) * m_sliceScale;
+        glm::vec4 params(static_cast<float>(kClustersX) / std::max(renderWidth, 1),
+                         static_cast<float>(kClustersY) / std::max(renderHeight, 1), m_sliceScale, sliceBias);
+        std::memcpy(block.data, glm::value_ptr(params), sizeof(params));
+        stream.flush();
+        glBindBufferRange(GL_UNIFORM_BUFFER, kClusterBlockBinding, stream.buffer(), block.offset, block.size);
+        telemetry::add(telemetry::Counter::StateChanges);
+    }
+
+    glActiveTexture(GL_TEXTURE0 + kLightTextureUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_lightTexture.id());
+    glActiveTexture(GL_TEXTURE0 + kGridTextureUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_gridTexture.id());
+    glActiveTexture(GL_TEXTURE0 + kIndexTextureUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_indexTexture.id());
+    glActiveTexture(GL_TEXTURE0);
+    telemetry::add(telemetry::Counter::TextureBinds, 3);
+
+    auto end = std::chrono::steady_clock::now();
+
+    m_frameStats.lights = static_cast<uint32_t>(lightCount);
+    m_frameStats.visibleLights = 0;
+    for (int i = 0; i < lightCount; ++i) {
+        m_frameStats.visibleLights += m_ranges[i].visible ? 1 : 0;
+    }
+    m_frameStats.lightIndices = offset;
+    m_frameStats.overflows = m_overflows.load(std::memory_order_relaxed);
+    m_frameStats.buildMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    m_totalBuildMs += m_frameStats.buildMs;
+    m_totalIndices += offset;
+    m_maxVisibleLights = std::max(m_maxVisibleLights, m_frameStats.visibleLights);
+    m_frames++;
+}
+
+const char* ClusteredLighting::shaderLibrary() {
+    static const std::string library = "#define CLUSTERS_X " + std::to_string(kClustersX) +
+                                       "\n#define CLUSTERS_Y " + std::to_string(kClustersY) +
+                                       "\n#define CLUSTERS_Z " + std::to_string(kClustersZ) + "\n" +
+                                       clusteredLightingShaderSource;
+    return library.c_str();
+}
+
+void ClusteredLighting::setupProgram(GLuint program) {
+    GLuint block = glGetUniformBlockIndex(program, "ClusterBlock");
+    if (block == GL_INVALID_INDEX) {
+        std::cerr << "Program " << program << " does not use clustered lighting." << std::endl;
+        return;
+    }
+    glUniformBlockBinding(program, block, kClusterBlockBinding);
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "clusterLights"), kLightTextureUnit);
+    glUniform1i(glGetUniformLocation(program, "clusterGrid"), kGridTextureUnit);
+    glUniform1i(glGetUniformLocation(program, "clusterIndices"), kIndexTextureUnit);
+    glUseProgram(0);
+}
+
+void ClusteredLighting::printStats() const {
+    if (m_frames == 0) return;
+    std::cout << std::fixed << std::setprecision(3)
+              << "Clustered lighting: " << m_lights.size() << " lights, up to " << m_maxVisibleLights << " visible, "
+              << std::setprecision(1) << (static_cast<double>(m_totalIndices) / m_frames) << " light indices per frame, "
+              << std::setprecision(3) << (m_totalBuildMs / m_frames) << " ms average build ("
+              << JobSystem::instance().threadCount() << " threads)" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
+
+
+void ClusteredLighting::run(Stage stage, int taskCount) {
+    JobSystem::instance().parallelFor(stage == Stage::LightRanges ? "Cluster light ranges" : "Cluster bin slices",
+                                      taskCount, /*grain=*/1, [this, stage](int begin, int end) {
+        for (int task = begin; task < end; ++task) {
+            if (stage == Stage::LightRanges) {
+                computeLightRanges(task);
+            } else {
+                binSlice(task);
+            }
+        }
+    });
+}
+
+
+void ClusteredLighting::updateClusterBounds(const glm::mat4& projection) {
+    m_boundsProjection = projection;
+
+    // Near and far planes of a glm::perspective projection.
+    float nearPlane = projection[3][2] / (projection[2][2] - 1.0f);
+    float farPlane = projection[3][2] / (projection[2][2] + 1.0f);
+    m_sliceNear = std::min(kSliceNear, farPlane * 0.5f);
+    m_sliceScale = kClustersZ / std::log(farPlane / m_sliceNear);
+
+    // View-space direction through every tile corner, scaled to unit depth.
+    const glm::mat4 inverseProjection = glm::inverse(projection);
+    glm::vec3 corners[kClustersY + 1][kClustersX + 1];
+    for (int y = 0; y <= kClustersY; ++y) {
+        for (int x = 0; x <= kClustersX; ++x) {
+            glm::vec4 ndc(2.0f * x / kClustersX - 1.0f, 2.0f * y / kClustersY - 1.0f, -1.0f, 1.0f);
+            glm::vec4 point = inverseProjection * ndc;
+            glm::vec3 direction = glm::vec3(point) / point.w;
+            corners[y][x] = direction / -direction.z;
+        }
+    }
+
+    for (int z = 0; z < kClustersZ; ++z) {
+        float depthNear = z == 0 ? nearPlane : m_sliceNear * std::exp(z / m_sliceScale);
+        float depthFar = z == kClustersZ - 1 ? farPlane : m_sliceNear * std::exp((z + 1) / m_sliceScale);
+        for (int y = 0; y < kClustersY; ++y) {
+            for (int x = 0; x < kClustersX; ++x) {
+                glm::vec3 boxMin(std::numeric_limits<float>::max());
+                glm::vec3 boxMax(-std::numeric_limits<float>::max());
+                for (int corner = 0; corner < 4; ++corner) {
+                    const glm::vec3& direction = corners[y + (corner >> 1)][x + (corner & 1)];
+                    boxMin = glm::min(boxMin, glm::min(direction * depthNear, direction * depthFar));
+                    boxMax = glm::max(boxMax, glm::max(direction * depthNear, direction * depthFar));
+                }
+                m_clusterMin[clusterIndex(x, y, z)] = boxMin;
+                m_clusterMax[clusterIndex(x, y, z)] = boxMax;
+            }
+        }
+    }
+}
+
+void ClusteredLighting::computeLightRanges(int task) {
+    float nearPlane = m_projection[3][2] / (m_projection[2][2] - 1.0f);
+    float farPlane = m_projection[3][2] / (m_projection[2][2] + 1.0f);
+
+    size_t first = static_cast<size_t>(task) * kLightsPerTask;
+    size_t last = std::min(first + kLightsPerTask, m_lights.size());
+    for (size_t i = first; i < last; ++i) {
+        const PointLight& light = m_lights[i];
+        LightRange& range = m_ranges[i];
+        range.viewCenter = glm::vec3(m_view * glm::vec4(light.position, 1.0f));
+        range.radius = light.radius;
+        range.visible = false;
+
+        float depth = -range.viewCenter.z;
+        if (depth + light.radius < nearPlane || depth - light.radius > farPlane) continue;
+        float minDepth = std::max(depth - light.radius, nearPlane);
+        float maxDepth = std::min(depth + light.radius, farPlane);
+
+        // Screen rectangle of the sphere's view-space box, clipped to the depth range in front of the camera.
+        glm::vec2 ndcMin(std::numeric_limits<float>::max());
+        glm::vec2 ndcMax(-std::numeric_limits<float>::max());
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec4 point(range.viewCenter.x + ((corner & 1) ? light.radius : -light.radius),
+                            range.viewCenter.y + ((corner & 2) ? light.radius : -light.radius),
+                            (corner & 4) ? -maxDepth : -minDepth, 1.0f);
+            glm::vec4 clip = m_projection * point;
+            glm::vec2 ndc = glm::vec2(clip) / clip.w;
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+        if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) continue;
+
+        auto tile = [](float ndc, int tiles) {
+            return std::clamp(static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * tiles)), 0, tiles - 1);
+        };
+        range.minX = static_cast<uint8_t>(tile(ndcMin.x, kClustersX));
+        range.maxX = static_cast<uint8_t>(tile(ndcMax.x, kClustersX));
+        range.minY = static_cast<uint8_t>(tile(ndcMin.y, kClustersY));
+        range.maxY = static_cast<uint8_t>(tile(ndcMax.y, kClustersY));
+        range.minZ = static_cast<uint8_t>(sliceOf(minDepth, m_sliceNear, m_sliceScale));
+        range.maxZ = static_cast<uint8_t>(sliceOf(maxDepth, m_sliceNear, m_sliceScale));
+        range.visible = true;
+    }
+}
+
+void ClusteredLighting::binSlice(int slice) {
+    // Each task owns one depth slice, so no two threads ever write the same cluster.
+    for (int y = 0; y < kClustersY; ++y) {
+        for (int x = 0; x < kClustersX; ++x) {
+            m_binnedCount[clusterIndex(x, y, slice)] = 0;
+        }
+    }
+
+    uint32_t overflows = 0;
+    const size_t lightCount = m_lights.size();
+    for (size_t i = 0; i < lightCount; ++i) {
+        const LightRange& range = m_ranges[i];
+        if (!range.visible || slice < range.minZ || slice > range.maxZ) continue;
+
+        // The screen rectangle is loose near the corners, so test the sphere against each cluster box.
+        const float radiusSquared = range.radius * range.radius;
+        for (int y = range.minY; y <= range.maxY; ++y) {
+            for (int x = range.minX; x <= range.maxX; ++x) {
+                int cluster = clusterIndex(x, y, slice);
+                glm::vec3 closest = glm::clamp(range.viewCenter, m_clusterMin[cluster], m_clusterMax[cluster]);
+                glm::vec3 offset = closest - range.viewCenter;
+                if (glm::dot(offset, offset) > radiusSquared) continue;
+
+                uint32_t& count = m_binnedCount[cluster];
+                if (count < kMaxLightsPerCluster) {
+                    m_binned[static_cast<size_t>(cluster) * kMaxLightsPerCluster + count++] = static_cast<uint16_t>(i);
+                } else {
+                    overflows++;
+                }
+            }
+        }
+    }
+    if (overflows > 0) {
+        m_overflows.fetch_add(overflows, std::memory_order_relaxed);
+    }
+}
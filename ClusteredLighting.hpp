@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GLResource.hpp"
+#include "StreamBuffer.hpp"
+
+struct PointLight {
+    glm::vec3 position;
+    float radius;       // light reaches zero at this distance
+    glm::vec3 color;
+    float intensity;
+};
+
+struct ClusterStats {
+    uint32_t lights = 0;
+    uint32_t visibleLights = 0; // touching at least one cluster
+    uint32_t lightIndices = 0;  // summed over every cluster
+    uint32_t overflows = 0;     // light/cluster pairs dropped because a cluster was full
+    double buildMs = 0.0;
+};
+
+// Clustered forward shading for many point lights.
+//
+// The view frustum is split into a kClustersX x kClustersY grid of screen tiles and kClustersZ
+// exponentially spaced depth slices. Every frame the CPU bins the lights into these clusters
+// on the job system (one light range per task, then one depth slice per task) and
+// uploads the result as texture buffers; fragment shaders look up their cluster and loop
+// only over the lights listed there.
+class ClusteredLighting {
+public:
+    static constexpr int kClustersX = 16;
+    static constexpr int kClustersY = 9;
+    static constexpr int kClustersZ = 24;
+    static constexpr int kClusterCount = kClustersX * kClustersY * kClustersZ;
+    static constexpr int kMaxLightsPerCluster = 128;
+    static constexpr int kMaxLights = 8192; // light indices are stored as 16 bits
+
+    // Fixed binding points, left alone by the rest of the renderer.
+    static constexpr GLuint kClusterBlockBinding = 2;
+    static constexpr GLuint kLightTextureUnit = 8;
+    static constexpr GLuint kGridTextureUnit = 9;
+    static constexpr GLuint kIndexTextureUnit = 10;
+
+    ClusteredLighting();
+    ~ClusteredLighting();
+
+    ClusteredLighting(const ClusteredLighting&) = delete;
+    ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+    // Replaces the light list and uploads it; lights beyond kMaxLights are ignored.
+    void setLights(const PointLight* lights, size_t count);
+    size_t lightCount() const { return m_lights.size(); }
+
+    // Bins the lights for this frame's camera and uploads the cluster grid. renderWidth/Height
+    // are the size of the framebuffer the lit passes draw into; stream must be between
+    // beginFrame/endFrame. Binds the cluster textures and uniform block for the draws that follow.
+    void update(const glm::mat4& view, const glm::mat4& projection, int renderWidth, int renderHeight, StreamBuffer& stream);
+
+    // GLSL declaring `vec3 clusteredPointLights(vec3 worldPos, vec3 normal, float viewDepth)`,
+    // which returns the summed diffuse light at a fragment. Splice it into a fragment shader
+    // with withShaderLibrary(), then call setupProgram() on the linked program.
+    static const char* shaderLibrary();
+    static void setupProgram(GLuint program);
+
+    const ClusterStats& frameStats() const { return m_frameStats; }
+    void printStats() const;
+
+private:
+    // Cluster footprint of one light for the current frame, from the first stage.
+    struct LightRange {
+        glm::vec3 viewCenter;
+        float radius;
+        uint8_t minX, maxX, minY, maxY, minZ, maxZ;
+        bool visible;
+    };
+
+    enum class Stage { LightRanges, BinSlices };
+    static constexpr int kLightsPerTask = 64;
+
+    std::vector<PointLight> m_lights;
+    std::vector<LightRange> m_ranges;
+
+    // View-space bounds of every cluster; rebuilt when the projection changes.
+    std::vector<glm::vec3> m_clusterMin;
+    std::vector<glm::vec3> m_clusterMax;
+    glm::mat4 m_boundsProjection = glm::mat4(0.0f);
+    float m_sliceNear = 1.0f;
+    float m_sliceScale = 1.0f; // slices per log unit of depth
+
+    // Per-cluster light lists before compaction, kMaxLightsPerCluster slots each.
+    std::vector<uint16_t> m_binned;
+    std::vector<uint32_t> m_binnedCount;
+    // Uploaded data: (offset, count) per cluster and the packed index list.
+    std::vector<uint32_t> m_grid;
+    std::vector<uint16_t> m_indices;
+
+    glm::mat4 m_view = glm::mat4(1.0f);
+    glm::mat4 m_projection = glm::mat4(1.0f);
+
+    GLBuffer m_lightBuffer;
+    GLTexture m_lightTexture;
+    GLBuffer m_gridBuffer;
+    GLTexture m_gridTexture;
+    GLBuffer m_indexBuffer;
+    GLTexture m_indexTexture;
+
+    std::atomic<uint32_t> m_overflows{ 0 };
+
+    ClusterStats m_frameStats;
+    double m_totalBuildMs = 0.0;
+    uint64_t m_totalIndices = 0;
+    uint32_t m_maxVisibleLights = 0;
+    uint32_t m_frames = 0;
+
+    // Runs the stage's tasks across the job system; returns when all are done.
+    void run(Stage stage, int taskCount);
+
+    void updateClusterBounds(const glm::mat4& projection);
+    void computeLightRanges(int task);
+    void binSlice(int slice);
+};
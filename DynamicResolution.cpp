@@ -0,0 +1,177 @@
+#include "DynamicResolution.hpp"
+#include "ShaderUtils.hpp"
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// Fullscreen triangle generated from gl_VertexID; no vertex buffer needed.
+static const char* upscaleVertexShaderSource = R"(
+#version 330 core
+out vec2 vUV;
+
+void main()
+{
+    vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    vUV = pos;
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// Bilinear upscale of the used part of the target, with an optional cross-shaped sharpening filter.
+static const char* upscaleFragmentShaderSource = R"(
+#version 330 core
+in vec2 vUV;
+out vec4 FragColor;
+
+uniform sampler2D scene;
+uniform vec2 uvScale;   // rendered size / allocated size
+uniform vec2 uvClamp;   // last texel center inside the rendered region
+uniform vec2 texel;     // one source texel in UV units
+uniform float sharpness;
+
+vec3 fetch(vec2 uv)
+{
+    return texture(scene, min(uv, uvClamp)).rgb;
+}
+
+void main()
+{
+    vec2 uv = vUV * uvScale;
+    vec3 color = fetch(uv);
+    if (sharpness > 0.0) {
+        vec3 blur = fetch(uv + vec2(texel.x, 0.0)) + fetch(uv - vec2(texel.x, 0.0)) +
+                    fetch(uv + vec2(0.0, texel.y)) + fetch(uv - vec2(0.0, texel.y));
+        color = clamp(color + (color - blur * 0.25) * sharpness, 0.0, 1.0);
+    }
+    FragColor = vec4(color, 1.0);
+}
+)";
+
+DynamicResolution::DynamicResolution(const DynamicResolutionConfig& config)
+    : m_config(config), m_scale(config.maxScale)
+{
+    m_config.minScale = std::clamp(m_config.minScale, 0.1f, 1.0f);
+    m_config.maxScale = std::clamp(m_config.maxScale, m_config.minScale, 2.0f);
+    m_scale = m_config.maxScale;
+
+    m_upscaleProgram = GLProgram::adopt(createShaderProgram(upscaleVertexShaderSource, upscaleFragmentShaderSource), "DynamicResolution");
+    if (!m_upscaleProgram) {
+        std::cerr << "Failed to create upscale shader program." << std::endl;
+    } else {
+        m_sceneLoc = glGetUniformLocation(m_upscaleProgram.id(), "scene");
+        m_uvScaleLoc = glGetUniformLocation(m_upscaleProgram.id(), "uvScale");
+        m_uvClampLoc = glGetUniformLocation(m_upscaleProgram.id(), "uvClamp");
+        m_texelLoc = glGetUniformLocation(m_upscaleProgram.id(), "texel");
+        m_sharpnessLoc = glGetUniformLocation(m_upscaleProgram.id(), "sharpness");
+    }
+
+    m_emptyVAO = GLVertexArray::create("DynamicResolution");
+    m_history.resize(kHistoryCapacity);
+}
+
+DynamicResolution::~DynamicResolution() = default;
+
+void DynamicResolution::resize(int windowWidth, int windowHeight) {
+    m_windowWidth = std::max(windowWidth, 1);
+    m_windowHeight = std::max(windowHeight, 1);
+    m_targetWidth = static_cast<int>(std::ceil(m_windowWidth * m_config.maxScale));
+    m_targetHeight = static_cast<int>(std::ceil(m_windowHeight * m_config.maxScale));
+}
+
+void DynamicResolution::beginScene() {
+    readTimings();
+
+    m_renderWidth = std::clamp(static_cast<int>(m_windowWidth * m_scale), 1, m_targetWidth);
+    m_renderHeight = std::clamp(static_cast<int>(m_windowHeight * m_scale), 1, m_targetHeight);
+
+    m_gpuTimer.begin();
+}
+
+void DynamicResolution::present(int windowWidth, int windowHeight, GLuint source) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, windowWidth, windowHeight);
+
+    if (m_upscaleProgram) {
+        glDisable(GL_DEPTH_TEST);
+        glUseProgram(m_upscaleProgram.id());
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, source);
+        glUniform1i(m_sceneLoc, 0);
+        glUniform2f(m_uvScaleLoc, (float)m_renderWidth / m_targetWidth, (float)m_renderHeight / m_targetHeight);
+        glUniform2f(m_uvClampLoc, (m_renderWidth - 0.5f) / m_targetWidth, (m_renderHeight - 0.5f) / m_targetHeight);
+        glUniform2f(m_texelLoc, 1.0f / m_targetWidth, 1.0f / m_targetHeight);
+        glUniform1f(m_sharpnessLoc, m_scale < 1.0f ? m_config.sharpness : 0.0f);
+
+        glBindVertexArray(m_emptyVAO.id());
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        glUseProgram(0);
+        glEnable(GL_DEPTH_TEST);
+        telemetry::countDraw(1);
+        telemetry::add(telemetry::Counter::StateChanges, 2);
+        telemetry::add(telemetry::Counter::TextureBinds);
+    }
+    telemetry::add(telemetry::Counter::StateChanges);
+
+    m_gpuTimer.end(m_frame);
+    m_frame++;
+}
+
+void DynamicResolution::readTimings() {
+    m_gpuTimer.poll([this](uint32_t frame, GLuint64 startNs, GLuint64 endNs) {
+        m_lastGpuMs = static_cast<float>((endNs - startNs) / 1.0e6);
+        updateScale(frame, m_lastGpuMs);
+    });
+}
+
+void DynamicResolution::updateScale(uint32_t frame, float gpuMs) {
+    if (gpuMs > 0.0f && !m_hold) {
+        // Fill cost is roughly proportional to pixel count, i.e. scale squared.
+        float ideal = m_scale * std::sqrt(m_config.targetFrameMs / gpuMs);
+        // Back off quickly when over budget, recover slowly to avoid oscillating.
+        float gain = ideal < m_scale ? 0.5f : 0.05f;
+        m_scale = std::clamp(m_scale + (ideal - m_scale) * gain, m_config.minScale, m_config.maxScale);
+    }
+
+    m_history[m_historyHead] = { frame, gpuMs, m_scale };
+    m_historyHead = (m_historyHead + 1) % m_history.size();
+    m_historySize = std::min(m_historySize + 1, m_history.size());
+}
+
+bool DynamicResolution::writeHistory(const char* path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Failed to write scale history: " << path << std::endl;
+        return false;
+    }
+    out << "frame,gpu_ms,scale\n";
+    size_t start = (m_historyHead + m_history.size() - m_historySize) % m_history.size();
+    for (size_t i = 0; i < m_historySize; ++i) {
+        const HistoryEntry& e = m_history[(start + i) % m_history.size()];
+        out << e.frame << ',' << e.gpuMs << ',' << e.scale << '\n';
+    }
+    std::cout << "Scale history written: " << path << " (" << m_historySize << " frames)" << std::endl;
+    return true;
+}
+
+void DynamicResolution::printStats() const {
+    if (m_historySize == 0) return;
+
+    float minScale = m_config.maxScale, maxScale = m_config.minScale, sumScale = 0.0f, sumMs = 0.0f;
+    for (size_t i = 0; i < m_historySize; ++i) {
+        const HistoryEntry& e = m_history[i];
+        minScale = std::min(minScale, e.scale);
+        maxScale = std::max(maxScale, e.scale);
+        sumScale += e.scale;
+        sumMs += e.gpuMs;
+    }
+    std::cout << std::fixed << std::setprecision(2)
+              << "Dynamic resolution: scale min " << minScale << " / avg " << (sumScale / m_historySize)
+              << " / max " << maxScale << ", avg GPU " << (sumMs / m_historySize) << " ms (target "
+              << m_config.targetFrameMs << " ms)" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+
+#include "GLResource.hpp"
+#include "GpuTimer.hpp"
+
+struct DynamicResolutionConfig {
+    float minScale = 0.5f;       // lowest render scale per axis
+    float maxScale = 1.0f;       // highest render scale per axis
+    float targetFrameMs = 16.0f; // GPU time budget for a frame
+    float sharpness = 0.2f;      // 0 = plain bilinear upscale
+};
+
+// Picks the resolution the 3D scene renders at from the GPU frame time, then upscales it to the
+// window. The offscreen target itself is a render-graph transient sized targetWidth() x
+// targetHeight(), i.e. maxScale times the window; only the viewport shrinks, so changing the
+// scale never reallocates. GPU time comes from timer queries read back a few frames late
+// to avoid stalling.
+class DynamicResolution {
+public:
+    explicit DynamicResolution(const DynamicResolutionConfig& config = DynamicResolutionConfig());
+    ~DynamicResolution();
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    // Sizes the offscreen target for the window. Call before beginScene().
+    void resize(int windowWidth, int windowHeight);
+    // Picks this frame's render size and starts timing the frame.
+    void beginScene();
+    // Upscales source, a targetWidth() x targetHeight() texture with the scene in its
+    // renderWidth() x renderHeight() corner, into the default framebuffer and stops timing the frame.
+    void present(int windowWidth, int windowHeight, GLuint source);
+
+    // While held, GPU times are still recorded but the scale stays put, so the render size does
+    // too; idle mode needs that to keep its cached layers.
+    void setHold(bool hold) { m_hold = hold; }
+
+    float scale() const { return m_scale; }
+    // GPU time of the most recent frame whose timer query has come back (a few frames old).
+    float lastGpuMs() const { return m_lastGpuMs; }
+    int renderWidth() const { return m_renderWidth; }
+    int renderHeight() const { return m_renderHeight; }
+    // Size of the offscreen target; the scene covers renderWidth() x renderHeight() of it.
+    int targetWidth() const { return m_targetWidth; }
+    int targetHeight() const { return m_targetHeight; }
+
+    // Writes the recorded (frame, gpu ms, scale) history as CSV.
+    bool writeHistory(const char* path) const;
+    void printStats() const;
+
+private:
+    struct HistoryEntry {
+        uint32_t frame;
+        float gpuMs;
+        float scale;
+    };
+
+    static constexpr size_t kHistoryCapacity = 1 << 14;
+
+    DynamicResolutionConfig m_config;
+    float m_scale;
+    float m_lastGpuMs = 0.0f;
+    bool m_hold = false;
+    int m_renderWidth = 0;
+    int m_renderHeight = 0;
+
+    int m_windowWidth = 1;
+    int m_windowHeight = 1;
+    int m_targetWidth = 0;
+    int m_targetHeight = 0;
+
+    GLProgram m_upscaleProgram;
+    GLVertexArray m_emptyVAO;
+    GLint m_sceneLoc = -1;
+    GLint m_uvScaleLoc = -1;
+    GLint m_uvClampLoc = -1;
+    GLint m_texelLoc = -1;
+    GLint m_sharpnessLoc = -1;
+
+    GpuTimer<uint32_t> m_gpuTimer{ "DynamicResolution" }; // tagged with the frame number
+    uint32_t m_frame = 0;
+
+    std::vector<HistoryEntry> m_history; // ring buffer, preallocated
+    size_t m_historyHead = 0;
+    size_t m_historySize = 0;
+
+    void readTimings();
+    void updateScale(uint32_t frame, float gpuMs);
+};
@@ -0,0 +1,54 @@
+#include "FrameArena.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+static constexpr size_t kScratchArenaBytes = size_t(16) << 20;
+static constexpr size_t kFrameArenaBytes = size_t(4) << 20;
+
+LinearArena::LinearArena(size_t capacity)
+    : m_base(static_cast<std::byte*>(std::malloc(capacity))), m_capacity(m_base ? capacity : 0)
+{
+    if (!m_base) {
+        std::cerr << "Failed to reserve " << capacity << " bytes for arena." << std::endl;
+    }
+}
+
+LinearArena::~LinearArena() {
+    std::free(m_base);
+}
+
+void* LinearArena::allocate(size_t bytes, size_t alignment) {
+    size_t start = (m_offset + alignment - 1) & ~(alignment - 1);
+    if (start + bytes > m_capacity) {
+        if (!m_reportedOverflow) {
+            std::cerr << "Arena exhausted: requested " << bytes << " bytes with " << (m_capacity - m_offset)
+                      << " of " << m_capacity << " left." << std::endl;
+            m_reportedOverflow = true;
+        }
+        return nullptr;
+    }
+    m_offset = start + bytes;
+    if (m_offset > m_highWater) m_highWater = m_offset;
+    return m_base + start;
+}
+
+FrameArena::FrameArena(size_t capacityPerFrame)
+    : m_storage0(capacityPerFrame), m_storage1(capacityPerFrame), m_arenas{ &m_storage0, &m_storage1 }
+{
+}
+
+void FrameArena::beginFrame() {
+    m_index ^= 1;
+    m_arenas[m_index]->reset();
+}
+
+LinearArena& scratchArena() {
+    static LinearArena arena(kScratchArenaBytes);
+    return arena;
+}
+
+FrameArena& frameArena() {
+    static FrameArena arena(kFrameArenaBytes);
+    return arena;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bump allocator over a fixed block. Individual frees are no-ops; memory comes back on reset()
+// or when rewinding to a marker.
+class LinearArena {
+public:
+    explicit LinearArena(size_t capacity);
+    ~LinearArena();
+
+    LinearArena(const LinearArena&) = delete;
+    LinearArena& operator=(const LinearArena&) = delete;
+
+    // Returns nullptr (and logs once) when the arena is exhausted.
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    // Uninitialized storage for `count` objects of a trivially destructible type.
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void reset() { m_offset = 0; }
+    size_t marker() const { return m_offset; }
+    void rewind(size_t marker) { if (marker <= m_offset) m_offset = marker; }
+
+    size_t used() const { return m_offset; }
+    size_t capacity() const { return m_capacity; }
+    size_t highWater() const { return m_highWater; }
+
+private:
+    std::byte* m_base;
+    size_t m_capacity;
+    size_t m_offset = 0;
+    size_t m_highWater = 0;
+    bool m_reportedOverflow = false;
+};
+
+// Two arenas used alternately, one per frame. beginFrame() resets the arena written two frames
+// ago, so packets built in frame N stay valid while frame N+1 is recorded.
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacityPerFrame);
+
+    void beginFrame();
+    LinearArena& current() { return *m_arenas[m_index]; }
+    LinearArena& previous() { return *m_arenas[m_index ^ 1]; }
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) { return current().allocate(bytes, alignment); }
+    template <typename T>
+    T* allocateArray(size_t count) { return current().allocateArray<T>(count); }
+
+private:
+    LinearArena m_storage0;
+    LinearArena m_storage1;
+    LinearArena* m_arenas[2];
+    int m_index = 0;
+};
+
+// Restores the arena to its current position when the scope ends.
+class ArenaScope {
+public:
+    explicit ArenaScope(LinearArena& arena) : m_arena(arena), m_marker(arena.marker()) {}
+    ~ArenaScope() { m_arena.rewind(m_marker); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    LinearArena& m_arena;
+    size_t m_marker;
+};
+
+// Arena for load-time temporaries (file contents, generated vertex data, info logs).
+// Wrap each use in an ArenaScope so the space is reused by the next loader.
+LinearArena& scratchArena();
+// Arena for per-frame transient CPU data, flipped once per frame by the main loop.
+FrameArena& frameArena();
@@ -0,0 +1,372 @@
+#include "FrameCapture.hpp"
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+FrameCapture::FrameCapture(const FrameCaptureConfig& config)
+    : m_config(config)
+{
+    m_config.encoderThreads = std::max(m_config.encoderThreads, 1);
+    m_config.queueDepth = std::max(m_config.queueDepth, 1);
+
+    if (!m_config.path.empty()) {
+        if (m_config.format == CaptureFormat::Png) {
+            std::error_code error;
+            std::filesystem::create_directories(m_config.path, error);
+            m_open = !error;
+        } else {
+            m_video = std::fopen(m_config.path.c_str(), "wb");
+            m_open = m_video != nullptr;
+        }
+        if (!m_open) {
+            std::cerr << "Failed to open capture output: " << m_config.path << std::endl;
+        }
+    }
+
+    // GL rows are bottom-up; PNGs are written top-down.
+    stbi_flip_vertically_on_write(1);
+
+    m_jobs.resize(m_config.queueDepth);
+    m_freeJobs.reserve(m_config.queueDepth);
+    for (int i = m_config.queueDepth - 1; i >= 0; --i) {
+        m_freeJobs.push_back(i);
+    }
+    m_queue.resize(m_config.queueDepth);
+
+    for (Readback& readback : m_ring) {
+        readback.buffer = GLBuffer::create("FrameCapture");
+    }
+    for (int i = 0; i < m_config.encoderThreads; ++i) {
+        m_encoders.emplace_back(&FrameCapture::encoderLoop, this);
+    }
+}
+
+FrameCapture::~FrameCapture() {
+    finish();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& encoder : m_encoders) {
+        if (encoder.joinable()) encoder.join();
+    }
+    for (Readback& readback : m_ring) {
+        if (readback.fence) glDeleteSync(readback.fence);
+    }
+    if (m_video) std::fclose(m_video);
+}
+
+void FrameCapture::reserve(int width, int height) {
+    size_t bytes = static_cast<size_t>(std::max(width, 0)) * std::max(height, 0) * 4;
+    if (bytes <= m_reservedBytes) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Only free jobs: the others' pixels are being read by an encoder.
+    for (int index : m_freeJobs) {
+        if (m_jobs[index].pixels.size() < bytes) m_jobs[index].pixels.resize(bytes);
+    }
+    if (m_freeJobs.size() == m_jobs.size()) m_reservedBytes = bytes;
+}
+
+void FrameCapture::poll() {
+    auto start = std::chrono::steady_clock::now();
+
+    // Readbacks complete in submission order, so stop at the first one still in flight.
+    while (m_ringCount > 0) {
+        Readback& readback = m_ring[m_ringTail];
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) break;
+
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        collect(readback);
+        m_ringTail = (m_ringTail + 1) % kRingSize;
+        m_ringCount--;
+    }
+
+    m_pendingCaptureMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void FrameCapture::capture(GLuint framebuffer, int x, int y, int width, int height, uint64_t frame) {
+    const bool record = m_recording && m_open;
+    const bool screenshot = m_screenshotRequested;
+    if ((!record && !screenshot) || width <= 0 || height <= 0) return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (m_ringCount == kRingSize) {
+        // The GPU has not finished the last kRingSize readbacks; a screenshot waits for the next frame.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.droppedReadback++;
+    } else {
+        Readback& readback = m_ring[m_ringHead];
+        size_t bytes = static_cast<size_t>(width) * height * 4;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.id());
+        if (readback.capacity < bytes) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+            readback.buffer.setStorage(bytes, "RGBA8 readback");
+            readback.capacity = bytes;
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glReadBuffer(framebuffer == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        telemetry::add(telemetry::Counter::StateChanges, 2);
+
+        readback.width = width;
+        readback.height = height;
+        readback.frame = frame;
+        readback.record = record;
+        readback.screenshot = screenshot;
+        m_screenshotRequested = false;
+        m_ringHead = (m_ringHead + 1) % kRingSize;
+        m_ringCount++;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.captured++;
+    }
+
+    double ms = m_pendingCaptureMs + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    m_pendingCaptureMs = 0.0;
+    m_totalCaptureMs += ms;
+    m_maxCaptureMs = std::max(m_maxCaptureMs, ms);
+    m_captureCalls++;
+}
+
+void FrameCapture::collect(Readback& readback, bool wait) {
+    bool record = readback.record;
+    const bool isVideo = m_config.format != CaptureFormat::Png;
+    if (record && isVideo) {
+        if (m_videoWidth == 0) {
+            m_videoWidth = readback.width;
+            m_videoHeight = readback.height;
+        } else if (readback.width != m_videoWidth || readback.height != m_videoHeight) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.droppedSize++;
+            record = false;
+        }
+    }
+    if (!record && !readback.screenshot) return;
+
+    int jobIndex = -1;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (wait) {
+            m_idle.wait(lock, [this] { return !m_freeJobs.empty(); });
+        }
+        if (m_freeJobs.empty()) {
+            m_stats.droppedEncoder++;
+            return;
+        }
+        jobIndex = m_freeJobs.back();
+        m_freeJobs.pop_back();
+        m_jobsInFlight++;
+    }
+
+    Job& job = m_jobs[jobIndex];
+    size_t bytes = static_cast<size_t>(readback.width) * readback.height * 4;
+    if (job.pixels.size() < bytes) {
+        if (wait) {
+            job.pixels.resize(bytes); // shutdown, outside the render loop
+        } else {
+            // Growing here would allocate inside the render loop; reserve() catches up next frame.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeJobs.push_back(jobIndex);
+            m_jobsInFlight--;
+            m_stats.droppedSize++;
+            return;
+        }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.id());
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if (mapped) {
+        std::memcpy(job.pixels.data(), mapped, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    job.width = readback.width;
+    job.height = readback.height;
+    job.frame = readback.frame;
+    job.record = record && mapped;
+    job.screenshot = readback.screenshot && mapped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Video frames keep their queue order through the encoders; see writeVideoFrame().
+        job.sequence = job.record && isVideo ? m_nextSequence++ : 0;
+        m_queue[(m_queueHead + m_queueSize) % m_queue.size()] = jobIndex;
+        m_queueSize++;
+    }
+    m_wake.notify_one();
+}
+
+void FrameCapture::finish() {
+    while (m_ringCount > 0) {
+        Readback& readback = m_ring[m_ringTail];
+        glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        collect(readback, /*wait=*/true);
+        m_ringTail = (m_ringTail + 1) % kRingSize;
+        m_ringCount--;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_jobsInFlight == 0; });
+    if (m_video) std::fflush(m_video);
+}
+
+void FrameCapture::encoderLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this] { return m_quit || m_queueSize > 0; });
+        if (m_queueSize == 0) break; // quitting with nothing left to do
+
+        int jobIndex = m_queue[m_queueHead];
+        m_queueHead = (m_queueHead + 1) % m_queue.size();
+        m_queueSize--;
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        encode(m_jobs[jobIndex]);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        m_totalEncodeMs += ms;
+        m_stats.encoded++;
+        m_freeJobs.push_back(jobIndex);
+        m_jobsInFlight--;
+        m_idle.notify_all();
+    }
+}
+
+void FrameCapture::encode(Job& job) {
+    // Both PNG paths write RGB; video frames convert from RGBA themselves.
+    if (job.screenshot) {
+        writePng(job, m_config.screenshotDirectory.c_str(), "screenshot");
+    }
+    if (job.record) {
+        if (m_config.format == CaptureFormat::Png) {
+            writePng(job, m_config.path.c_str(), "frame");
+        } else {
+            writeVideoFrame(job);
+        }
+    }
+}
+
+void FrameCapture::writePng(const Job& job, const char* directory, const char* prefix) {
+    // Drop the alpha channel (whatever the framebuffer held there) while copying out.
+    const size_t pixelCount = static_cast<size_t>(job.width) * job.height;
+    std::vector<uint8_t> rgb(pixelCount * 3);
+    for (size_t i = 0; i < pixelCount; ++i) {
+        rgb[3 * i] = job.pixels[4 * i];
+        rgb[3 * i + 1] = job.pixels[4 * i + 1];
+        rgb[3 * i + 2] = job.pixels[4 * i + 2];
+    }
+
+    char path[1024];
+    std::snprintf(path, sizeof(path), "%s/%s_%06llu.png", directory, prefix, static_cast<unsigned long long>(job.frame));
+    if (!stbi_write_png(path, job.width, job.height, 3, rgb.data(), job.width * 3)) {
+        std::cerr << "Failed to write " << path << std::endl;
+    } else if (std::strcmp(prefix, "screenshot") == 0) {
+        std::cout << "Screenshot saved: " << path << std::endl;
+    }
+}
+
+void FrameCapture::writeVideoFrame(Job& job) {
+    const int width = m_videoWidth & ~1; // 4:2:0 needs even dimensions
+    const int height = m_videoHeight & ~1;
+
+    // Convert before taking a turn at the file, so encoders overlap on the expensive part.
+    std::vector<uint8_t>& frame = job.converted;
+    if (m_config.format == CaptureFormat::Y4m) {
+        const size_t lumaSize = static_cast<size_t>(width) * height;
+        const size_t chromaSize = lumaSize / 4;
+        frame.resize(lumaSize + 2 * chromaSize);
+        uint8_t* luma = frame.data();
+        uint8_t* cb = luma + lumaSize;
+        uint8_t* cr = cb + chromaSize;
+
+        // Full-range BT.601, matching the C420jpeg tag in the header. Output rows are top-down.
+        auto pixel = [&](int x, int row) { return &job.pixels[(static_cast<size_t>(job.height - 1 - row) * job.width + x) * 4]; };
+        for (int row = 0; row < height; ++row) {
+            for (int x = 0; x < width; ++x) {
+                const uint8_t* p = pixel(x, row);
+                luma[static_cast<size_t>(row) * width + x] = static_cast<uint8_t>(0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2] + 0.5f);
+            }
+        }
+        for (int row = 0; row < height; row += 2) {
+            for (int x = 0; x < width; x += 2) {
+                float r = 0.0f, g = 0.0f, b = 0.0f;
+                for (int corner = 0; corner < 4; ++corner) {
+                    const uint8_t* p = pixel(x + (corner & 1), row + (corner >> 1));
+                    r += p[0];
+                    g += p[1];
+                    b += p[2];
+                }
+                r *= 0.25f;
+                g *= 0.25f;
+                b *= 0.25f;
+                size_t index = static_cast<size_t>(row / 2) * (width / 2) + x / 2;
+                cb[index] = static_cast<uint8_t>(std::clamp(128.0f - 0.168736f * r - 0.331264f * g + 0.5f * b + 0.5f, 0.0f, 255.0f));
+                cr[index] = static_cast<uint8_t>(std::clamp(128.0f + 0.5f * r - 0.418688f * g - 0.081312f * b + 0.5f, 0.0f, 255.0f));
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_written.wait(lock, [&] { return m_nextWrite == job.sequence; });
+    lock.unlock();
+
+    if (m_config.format == CaptureFormat::Y4m) {
+        if (job.sequence == 0) {
+            std::fprintf(m_video, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, m_config.framesPerSecond);
+        }
+        std::fputs("FRAME\n", m_video);
+        std::fwrite(frame.data(), 1, frame.size(), m_video);
+    } else {
+        std::fwrite(job.pixels.data(), 1, static_cast<size_t>(job.width) * job.height * 4, m_video);
+    }
+
+    lock.lock();
+    m_nextWrite++;
+    lock.unlock();
+    m_written.notify_all();
+}
+
+FrameCaptureStats FrameCapture::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void FrameCapture::printStats() const {
+    FrameCaptureStats totals = stats();
+    if (m_captureCalls == 0) return;
+
+    double encodeMs;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        encodeMs = totals.encoded ? m_totalEncodeMs / totals.encoded : 0.0;
+    }
+    std::cout << std::fixed << std::setprecision(3)
+              << "Frame capture: " << totals.captured << " frames read back, " << totals.encoded << " encoded, dropped "
+              << totals.droppedReadback << " (readback busy) / " << totals.droppedEncoder << " (encoders busy) / "
+              << totals.droppedSize << " (size changed)" << std::endl
+              << "  render thread overhead: " << (m_totalCaptureMs / m_captureCalls) << " ms per frame on average, "
+              << m_maxCaptureMs << " ms at most; encode " << encodeMs << " ms per frame on "
+              << m_encoders.size() << " threads" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <GL/glew.h>
+
+#include "GLResource.hpp"
+
+enum class CaptureFormat {
+    Png, // one file per frame in a directory
+    Y4m, // YUV 4:2:0 video stream, playable by ffmpeg/mpv
+    Raw, // bottom-up RGBA8 frames back to back
+};
+
+struct FrameCaptureConfig {
+    CaptureFormat format = CaptureFormat::Png;
+    std::string path;            // directory for Png, file for Y4m/Raw; empty for screenshots only
+    std::string screenshotDirectory = ".";
+    int framesPerSecond = 60;    // written into the Y4M header
+    int encoderThreads = 2;
+    int queueDepth = 6;          // frames waiting for or inside an encoder; more are dropped
+};
+
+struct FrameCaptureStats {
+    uint64_t captured = 0;         // readbacks started
+    uint64_t encoded = 0;
+    uint64_t droppedReadback = 0;  // every PBO still in flight
+    uint64_t droppedEncoder = 0;   // encoders behind, queue full
+    uint64_t droppedSize = 0;      // video frame size changed mid-stream, or larger than reserve()
+};
+
+// Asynchronous frame capture for screenshots and video dumps.
+//
+// capture() only issues glReadPixels into the next pixel buffer object of a small ring and
+// drops a fence behind it; poll() maps the buffers whose fences have signalled, copies the
+// pixels into a preallocated frame slot and hands the slot to a pool of encoder threads.
+// Nothing on the render thread ever waits on the GPU or on an encoder: when either is behind
+// the frame is dropped and counted instead.
+class FrameCapture {
+public:
+    explicit FrameCapture(const FrameCaptureConfig& config);
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    bool isOpen() const { return m_open; }
+
+    // Records every frame passed to capture() while on.
+    void setRecording(bool recording) { m_recording = recording; }
+    bool isRecording() const { return m_recording; }
+    // Saves the next captured frame as a PNG in the screenshot directory, even when not recording.
+    void requestScreenshot() { m_screenshotRequested = true; }
+
+    // Grows the frame slots to hold width x height captures, so poll() never allocates. Call
+    // every frame outside the no-allocation part of the loop; slots still with an encoder are
+    // grown on a later call.
+    void reserve(int width, int height);
+    // Collects finished readbacks. Call once per frame, before capture().
+    void poll();
+    // Starts reading back the (x, y, width, height) rectangle of framebuffer's color buffer
+    // (the back buffer for framebuffer 0). Call after the frame's last draw, before swapping.
+    void capture(GLuint framebuffer, int x, int y, int width, int height, uint64_t frame);
+
+    // Blocks until every pending readback and encode has finished. For shutdown only.
+    void finish();
+
+    FrameCaptureStats stats() const;
+    void printStats() const;
+
+private:
+    static constexpr int kRingSize = 3;
+
+    struct Readback {
+        GLBuffer buffer;
+        size_t capacity = 0;
+        GLsync fence = nullptr;
+        int width = 0;
+        int height = 0;
+        uint64_t frame = 0;
+        bool record = false;
+        bool screenshot = false;
+    };
+
+    // One frame on its way through an encoder.
+    struct Job {
+        std::vector<uint8_t> pixels;    // RGBA8, bottom-up, sized by reserve()
+        std::vector<uint8_t> converted; // encoder-side scratch (YUV planes)
+        int width = 0;
+        int height = 0;
+        uint64_t frame = 0;
+        uint64_t sequence = 0;       // order in the video stream
+        bool record = false;
+        bool screenshot = false;
+    };
+
+    FrameCaptureConfig m_config;
+    bool m_open = false;
+    bool m_recording = false;
+    bool m_screenshotRequested = false;
+
+    Readback m_ring[kRingSize];
+    int m_ringHead = 0; // next slot to read into
+    int m_ringTail = 0; // oldest slot in flight
+    int m_ringCount = 0;
+
+    // Video files are written by one encoder at a time, in sequence order.
+    std::FILE* m_video = nullptr;
+    int m_videoWidth = 0;
+    int m_videoHeight = 0;
+    uint64_t m_nextSequence = 0;
+    uint64_t m_nextWrite = 0;
+
+    std::vector<Job> m_jobs;
+    size_t m_reservedBytes = 0;    // every job's pixels hold at least this much
+    std::vector<int> m_freeJobs;   // used as a stack, capacity fixed at construction
+    std::vector<int> m_queue;      // ring of job indices, capacity fixed at construction
+    size_t m_queueHead = 0;
+    size_t m_queueSize = 0;
+    int m_jobsInFlight = 0;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::condition_variable m_written;
+    bool m_quit = false;
+    std::vector<std::thread> m_encoders;
+
+    FrameCaptureStats m_stats;
+    double m_pendingCaptureMs = 0.0; // poll() time not yet attributed to a frame
+    double m_totalCaptureMs = 0.0;  // render-thread time spent in capture() and poll()
+    double m_maxCaptureMs = 0.0;
+    double m_totalEncodeMs = 0.0;   // encoder-thread time
+    uint64_t m_captureCalls = 0;
+
+    // Copies a finished readback into a free job and queues it; with wait, blocks for a free job
+    // instead of dropping the frame.
+    void collect(Readback& readback, bool wait = false);
+    void encoderLoop();
+    void encode(Job& job);
+    void writePng(const Job& job, const char* directory, const char* prefix);
+    void writeVideoFrame(Job& job);
+};
@@ -0,0 +1,162 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <GLFW/glfw3.h>
+
+const char* swapModeName(SwapMode mode) {
+    switch (mode) {
+        case SwapMode::Immediate:     return "off";
+        case SwapMode::AdaptiveVsync: return "adaptive";
+        default:                      return "on";
+    }
+}
+
+bool parseSwapMode(const char* name, SwapMode& mode) {
+    if (std::strcmp(name, "off") == 0 || std::strcmp(name, "0") == 0) {
+        mode = SwapMode::Immediate;
+    } else if (std::strcmp(name, "on") == 0 || std::strcmp(name, "1") == 0) {
+        mode = SwapMode::Vsync;
+    } else if (std::strcmp(name, "adaptive") == 0) {
+        mode = SwapMode::AdaptiveVsync;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+FramePacer::FramePacer(const FramePacingConfig& config)
+    : m_swapMode(config.swapMode),
+      m_framesInFlight(std::clamp(config.framesInFlight, 1, kMaxFramesInFlight)),
+      m_lateLatch(config.lateLatch)
+{
+    m_adaptiveSupported = glfwExtensionSupported("GLX_EXT_swap_control_tear") ||
+                          glfwExtensionSupported("WGL_EXT_swap_control_tear");
+    m_history.resize(kHistoryCapacity);
+
+    setSwapMode(m_swapMode);
+    std::cout << "Frame pacing: vsync " << swapModeName(m_swapMode) << ", " << m_framesInFlight
+              << " frame(s) in flight, late latch " << (m_lateLatch ? "on" : "off") << std::endl;
+}
+
+FramePacer::~FramePacer() {
+    for (Slot& slot : m_slots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+    }
+}
+
+void FramePacer::setSwapMode(SwapMode mode) {
+    if (mode == SwapMode::AdaptiveVsync && !m_adaptiveSupported) {
+        std::cout << "Adaptive vsync is not supported here; using vsync." << std::endl;
+        mode = SwapMode::Vsync;
+    }
+    m_swapMode = mode;
+    // -1 syncs to vblank only when the frame is on time and tears instead of waiting when it is late.
+    glfwSwapInterval(mode == SwapMode::Immediate ? 0 : mode == SwapMode::Vsync ? 1 : -1);
+}
+
+void FramePacer::cycleSwapMode() {
+    SwapMode next = m_swapMode == SwapMode::Immediate ? SwapMode::Vsync
+                  : m_swapMode == SwapMode::Vsync && m_adaptiveSupported ? SwapMode::AdaptiveVsync
+                  : SwapMode::Immediate;
+    setSwapMode(next);
+    std::cout << "Vsync: " << swapModeName(m_swapMode) << std::endl;
+}
+
+void FramePacer::setFramesInFlight(int frames) {
+    m_framesInFlight = std::clamp(frames, 1, kMaxFramesInFlight);
+}
+
+void FramePacer::cycleFramesInFlight() {
+    setFramesInFlight(m_framesInFlight % kMaxFramesInFlight + 1);
+    std::cout << "Frames in flight: " << m_framesInFlight << std::endl;
+}
+
+void FramePacer::setLateLatch(bool enabled) {
+    m_lateLatch = enabled;
+    std::cout << "Late latch: " << (m_lateLatch ? "on" : "off") << std::endl;
+}
+
+void FramePacer::waitForFrameSlot() {
+    readTimings();
+
+    // Frames finish in order, so waiting on the framesInFlight-th most recent covers the older ones.
+    Slot& oldest = m_slots[(m_slot + kSlotCount - m_framesInFlight) % kSlotCount];
+    float waitMs = 0.0f;
+    if (oldest.fence) {
+        auto start = std::chrono::steady_clock::now();
+        glClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        waitMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        glDeleteSync(oldest.fence);
+        oldest.fence = nullptr;
+    }
+    m_slots[m_slot].waitMs = waitMs;
+}
+
+void FramePacer::markInputSampled() {
+    // Same clock as GL_TIMESTAMP queries, so the two subtract directly.
+    glGetInteger64v(GL_TIMESTAMP, &m_slots[m_slot].inputGpuNs);
+}
+
+void FramePacer::endFrame() {
+    Slot& slot = m_slots[m_slot];
+    if (slot.fence) glDeleteSync(slot.fence);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_gpuTimer.stamp({ m_frame, slot.inputGpuNs, slot.waitMs });
+    m_slot = (m_slot + 1) % kSlotCount;
+    m_frame++;
+}
+
+void FramePacer::readTimings() {
+    m_gpuTimer.poll([this](const Sample& sample, GLuint64, GLuint64 completedNs) {
+        m_lastLatencyMs = static_cast<float>((static_cast<GLint64>(completedNs) - sample.inputGpuNs) / 1.0e6);
+
+        m_history[m_historyHead] = { sample.frame, m_lastLatencyMs, sample.waitMs,
+                                     static_cast<uint8_t>(m_framesInFlight), m_swapMode };
+        m_historyHead = (m_historyHead + 1) % m_history.size();
+        m_historySize = std::min(m_historySize + 1, m_history.size());
+    });
+}
+
+bool FramePacer::writeHistory(const char* path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Failed to write latency history: " << path << std::endl;
+        return false;
+    }
+    out << "frame,latency_ms,wait_ms,frames_in_flight,vsync\n";
+    size_t start = (m_historyHead + m_history.size() - m_historySize) % m_history.size();
+    for (size_t i = 0; i < m_historySize; ++i) {
+        const HistoryEntry& e = m_history[(start + i) % m_history.size()];
+        out << e.frame << ',' << e.latencyMs << ',' << e.waitMs << ',' << int(e.framesInFlight) << ','
+            << swapModeName(e.swapMode) << '\n';
+    }
+    std::cout << "Latency history written: " << path << " (" << m_historySize << " frames)" << std::endl;
+    return true;
+}
+
+void FramePacer::printStats() const {
+    if (m_historySize == 0) return;
+
+    std::vector<float> latencies(m_historySize);
+    float sumLatency = 0.0f, sumWait = 0.0f;
+    for (size_t i = 0; i < m_historySize; ++i) {
+        latencies[i] = m_history[i].latencyMs;
+        sumLatency += m_history[i].latencyMs;
+        sumWait += m_history[i].waitMs;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](float p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Input to frame done: avg " << (sumLatency / m_historySize) << " ms, p50 " << percentile(0.5f)
+              << " / p99 " << percentile(0.99f) << " / max " << latencies.back() << " ms; waited "
+              << (sumWait / m_historySize) << " ms per frame for the GPU (vsync " << swapModeName(m_swapMode)
+              << ", " << m_framesInFlight << " in flight)" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
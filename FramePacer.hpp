@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+
+#include "GLResource.hpp"
+#include "GpuTimer.hpp"
+
+enum class SwapMode : uint8_t { Immediate, Vsync, AdaptiveVsync };
+
+const char* swapModeName(SwapMode mode);
+// Parses "off", "on" or "adaptive"; false leaves mode alone.
+bool parseSwapMode(const char* name, SwapMode& mode);
+
+struct FramePacingConfig {
+    SwapMode swapMode = SwapMode::Vsync;
+    int framesInFlight = 2; // frames the CPU may queue ahead of the GPU, 1 to kMaxFramesInFlight
+    bool lateLatch = true;  // poll input again right before the camera block is written
+};
+
+// Swap interval, CPU run-ahead and input-to-present latency for the frame loop.
+//
+// Per frame: waitForFrameSlot() blocks until the GPU has finished all but framesInFlight - 1
+// earlier frames, so input sampled after it is never further than that from the screen;
+// markInputSampled() records the GPU clock at the moment input was read; endFrame(), right
+// after the swap, fences the frame and drops a GPU timestamp behind it. The difference between
+// the two, read back a few frames late, is the frame's latency from input to the GPU finishing
+// the frame; with vsync on, scan-out adds up to one more refresh.
+class FramePacer {
+public:
+    static constexpr int kMaxFramesInFlight = 3;
+
+    explicit FramePacer(const FramePacingConfig& config = FramePacingConfig());
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    SwapMode swapMode() const { return m_swapMode; }
+    // Applies the swap interval to the current context. Adaptive vsync falls back to vsync
+    // where the swap_control_tear extension is missing.
+    void setSwapMode(SwapMode mode);
+    void cycleSwapMode();
+    int framesInFlight() const { return m_framesInFlight; }
+    void setFramesInFlight(int frames);
+    void cycleFramesInFlight();
+    bool lateLatch() const { return m_lateLatch; }
+    void setLateLatch(bool enabled);
+
+    void waitForFrameSlot();
+    // May be called again later in the frame; the last call counts.
+    void markInputSampled();
+    void endFrame();
+
+    // Latency of the most recent frame whose timestamp has come back (a few frames old).
+    float lastLatencyMs() const { return m_lastLatencyMs; }
+
+    // Writes the recorded (frame, latency ms, wait ms, frames in flight, swap mode) history as CSV.
+    bool writeHistory(const char* path) const;
+    void printStats() const;
+
+private:
+    struct HistoryEntry {
+        uint32_t frame;
+        float latencyMs;
+        float waitMs; // CPU time blocked in waitForFrameSlot()
+        uint8_t framesInFlight;
+        SwapMode swapMode;
+    };
+
+    // One more than the deepest queue, so a slot is never reused while its fence is awaited.
+    static constexpr int kSlotCount = kMaxFramesInFlight + 1;
+    static constexpr size_t kHistoryCapacity = 1 << 14;
+
+    struct Slot {
+        GLsync fence = nullptr;
+        GLint64 inputGpuNs = 0;
+        float waitMs = 0.0f;
+    };
+
+    // What a frame's completion timestamp is measured against once it comes back.
+    struct Sample {
+        uint32_t frame;
+        GLint64 inputGpuNs;
+        float waitMs;
+    };
+
+    SwapMode m_swapMode;
+    int m_framesInFlight;
+    bool m_lateLatch;
+    bool m_adaptiveSupported = false;
+
+    Slot m_slots[kSlotCount];
+    int m_slot = 0;
+    GpuTimer<Sample, kSlotCount> m_gpuTimer{ "FramePacer" };
+    uint32_t m_frame = 0;
+    float m_lastLatencyMs = 0.0f;
+
+    std::vector<HistoryEntry> m_history; // ring buffer, preallocated
+    size_t m_historyHead = 0;
+    size_t m_historySize = 0;
+
+    void readTimings();
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+
+// View frustum planes extracted from a view-projection matrix (Gribb/Hartmann).
+// Plane normals point inwards; xyz is not normalized, which is fine for sign tests.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    explicit Frustum(const glm::mat4& viewProjection) {
+        glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+        glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+        planes[0] = row3 + row0; // left
+        planes[1] = row3 - row0; // right
+        planes[2] = row3 + row1; // bottom
+        planes[3] = row3 - row1; // top
+        planes[4] = row3 + row2; // near
+        planes[5] = row3 - row2; // far
+    }
+
+    // False only if the box lies entirely outside one of the planes.
+    bool intersects(const AABB& box) const {
+        for (const glm::vec4& p : planes) {
+            glm::vec3 positive((p.x >= 0.0f) ? box.max.x : box.min.x,
+                               (p.y >= 0.0f) ? box.max.y : box.min.y,
+                               (p.z >= 0.0f) ? box.max.z : box.min.z);
+            if (p.x * positive.x + p.y * positive.y + p.z * positive.z + p.w < 0.0f) return false;
+        }
+        return true;
+    }
+};
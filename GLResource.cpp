@@ -0,0 +1,180 @@
+#include "GLResource.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+
+static double toMiB(size_t bytes) {
+    return bytes / (1024.0 * 1024.0);
+}
+
+const char* glResourceKindName(GLResourceKind kind) {
+    switch (kind) {
+        case GLResourceKind::Buffer:       return "buffer";
+        case GLResourceKind::VertexArray:  return "vertex array";
+        case GLResourceKind::Texture:      return "texture";
+        case GLResourceKind::Framebuffer:  return "framebuffer";
+        case GLResourceKind::Renderbuffer: return "renderbuffer";
+        case GLResourceKind::Program:      return "program";
+        case GLResourceKind::Query:        return "query";
+        default:                           return "unknown";
+    }
+}
+
+size_t glTextureBytes(GLenum internalFormat, int width, int height, int layers, bool mipmapped) {
+    size_t bytesPerPixel;
+    switch (internalFormat) {
+        case GL_RED: case GL_R8:                             bytesPerPixel = 1; break;
+        case GL_RG: case GL_RG8: case GL_R16: case GL_R16F:  bytesPerPixel = 2; break;
+        case GL_RGB: case GL_RGB8:                           bytesPerPixel = 3; break;
+        case GL_DEPTH_COMPONENT24:                           bytesPerPixel = 4; break; // padded to 32 bits
+        case GL_RGBA16F: case GL_RG32F:                      bytesPerPixel = 8; break;
+        case GL_RGBA32F:                                     bytesPerPixel = 16; break;
+        default:                                             bytesPerPixel = 4; break;
+    }
+
+    size_t bytes = static_cast<size_t>(width) * height * bytesPerPixel;
+    while (mipmapped && (width > 1 || height > 1)) {
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+        bytes += static_cast<size_t>(width) * height * bytesPerPixel;
+    }
+    return bytes * layers;
+}
+
+GLuint glCreateResource(GLResourceKind kind) {
+    GLuint id = 0;
+    switch (kind) {
+        case GLResourceKind::Buffer:       glGenBuffers(1, &id); break;
+        case GLResourceKind::VertexArray:  glGenVertexArrays(1, &id); break;
+        case GLResourceKind::Texture:      glGenTextures(1, &id); break;
+        case GLResourceKind::Framebuffer:  glGenFramebuffers(1, &id); break;
+        case GLResourceKind::Renderbuffer: glGenRenderbuffers(1, &id); break;
+        case GLResourceKind::Program:      id = glCreateProgram(); break;
+        case GLResourceKind::Query:        glGenQueries(1, &id); break;
+        default: break;
+    }
+    return id;
+}
+
+void glDeleteResource(GLResourceKind kind, GLuint id) {
+    switch (kind) {
+        case GLResourceKind::Buffer:       glDeleteBuffers(1, &id); break;
+        case GLResourceKind::VertexArray:  glDeleteVertexArrays(1, &id); break;
+        case GLResourceKind::Texture:      glDeleteTextures(1, &id); break;
+        case GLResourceKind::Framebuffer:  glDeleteFramebuffers(1, &id); break;
+        case GLResourceKind::Renderbuffer: glDeleteRenderbuffers(1, &id); break;
+        case GLResourceKind::Program:      glDeleteProgram(id); break;
+        case GLResourceKind::Query:        glDeleteQueries(1, &id); break;
+        default: break;
+    }
+}
+
+GpuMemoryRegistry& GpuMemoryRegistry::instance() {
+    static GpuMemoryRegistry registry;
+    return registry;
+}
+
+void GpuMemoryRegistry::onCreate(GLResourceKind kind, GLuint id, const char* owner) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_allocations[key(kind, id)] = { kind, id, 0, "", owner ? owner : "unknown" };
+}
+
+void GpuMemoryRegistry::onDestroy(GLResourceKind kind, GLuint id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_allocations.find(key(kind, id));
+    if (it == m_allocations.end()) return;
+    m_residentBytes -= it->second.bytes;
+    m_allocations.erase(it);
+    if (m_overBudget && m_residentBytes <= m_budgetBytes) m_overBudget = false;
+}
+
+void GpuMemoryRegistry::setStorage(GLResourceKind kind, GLuint id, size_t bytes, const char* format) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_allocations.find(key(kind, id));
+    if (it == m_allocations.end()) return;
+
+    m_residentBytes = m_residentBytes - it->second.bytes + bytes;
+    it->second.bytes = bytes;
+    it->second.format = format ? format : "";
+    m_peakBytes = std::max(m_peakBytes, m_residentBytes);
+    checkBudget(it->second.owner);
+}
+
+void GpuMemoryRegistry::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budgetBytes = bytes;
+    // A new budget is a new line to cross, and what is already resident counts against it now.
+    m_overBudget = false;
+    checkBudget(nullptr);
+}
+
+void GpuMemoryRegistry::checkBudget(const char* cause) {
+    if (m_budgetBytes == 0 || m_residentBytes <= m_budgetBytes || m_overBudget) return;
+    m_overBudget = true;
+    std::cerr << "WARNING: GPU memory budget exceeded: " << toMiB(m_residentBytes) << " MiB resident, budget "
+              << toMiB(m_budgetBytes) << " MiB";
+    if (cause) std::cerr << " (last allocation by " << cause << ")";
+    std::cerr << std::endl;
+}
+
+size_t GpuMemoryRegistry::residentBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_residentBytes;
+}
+
+size_t GpuMemoryRegistry::peakBytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_peakBytes;
+}
+
+size_t GpuMemoryRegistry::liveObjects() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocations.size();
+}
+
+void GpuMemoryRegistry::printReport() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::map<std::string, size_t> byOwner;
+    size_t byKind[static_cast<size_t>(GLResourceKind::Count)] = {};
+    size_t countByKind[static_cast<size_t>(GLResourceKind::Count)] = {};
+    for (const auto& [k, a] : m_allocations) {
+        byOwner[a.owner] += a.bytes;
+        byKind[static_cast<size_t>(a.kind)] += a.bytes;
+        countByKind[static_cast<size_t>(a.kind)]++;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "GPU memory: " << toMiB(m_residentBytes) << " MiB resident, peak " << toMiB(m_peakBytes) << " MiB";
+    if (m_budgetBytes != 0) {
+        std::cout << ", budget " << toMiB(m_budgetBytes) << " MiB ("
+                  << (100.0 * m_residentBytes / m_budgetBytes) << "% used)";
+    }
+    std::cout << ", " << m_allocations.size() << " objects" << std::endl;
+
+    for (size_t i = 0; i < static_cast<size_t>(GLResourceKind::Count); ++i) {
+        if (countByKind[i] == 0) continue;
+        std::cout << "  " << std::setw(14) << std::left << glResourceKindName(static_cast<GLResourceKind>(i))
+                  << std::right << std::setw(10) << toMiB(byKind[i]) << " MiB  (" << countByKind[i] << ")" << std::endl;
+    }
+    for (const auto& [owner, bytes] : byOwner) {
+        std::cout << "  " << std::setw(24) << std::left << owner << std::right << std::setw(10) << toMiB(bytes) << " MiB" << std::endl;
+    }
+    std::cout.unsetf(std::ios::fixed);
+}
+
+size_t GpuMemoryRegistry::reportLeaks() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [k, a] : m_allocations) {
+        std::cerr << "GL leak: " << glResourceKindName(a.kind) << " " << a.id << " owned by " << a.owner;
+        if (a.bytes != 0) std::cerr << " (" << a.bytes << " bytes, " << a.format << ")";
+        std::cerr << std::endl;
+    }
+    if (!m_allocations.empty()) {
+        std::cerr << m_allocations.size() << " GL objects leaked, " << m_residentBytes << " bytes" << std::endl;
+    }
+    return m_allocations.size();
+}
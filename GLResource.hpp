@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <GL/glew.h>
+
+enum class GLResourceKind : uint8_t {
+    Buffer,
+    VertexArray,
+    Texture,
+    Framebuffer,
+    Renderbuffer,
+    Program,
+    Query,
+    Count
+};
+
+const char* glResourceKindName(GLResourceKind kind);
+
+// Bytes used by a 2D texture (or cubemap face, layers > 1) of the given internal format,
+// including the mip chain when `mipmapped` is set. Unsized formats are treated as 8 bits per channel.
+size_t glTextureBytes(GLenum internalFormat, int width, int height, int layers = 1, bool mipmapped = false);
+
+// Tracks every live GL object created through GLHandle: who owns it and how much memory backs it.
+// Owner and format strings must be string literals (or otherwise outlive the object).
+class GpuMemoryRegistry {
+public:
+    static GpuMemoryRegistry& instance();
+
+    void onCreate(GLResourceKind kind, GLuint id, const char* owner);
+    void onDestroy(GLResourceKind kind, GLuint id);
+    void setStorage(GLResourceKind kind, GLuint id, size_t bytes, const char* format);
+
+    size_t residentBytes() const;
+    size_t peakBytes() const;
+    size_t liveObjects() const;
+
+    // Warns once each time the resident total crosses the budget, including when a new budget is
+    // already exceeded. 0 disables the check.
+    void setBudget(size_t bytes);
+
+    // Prints resident memory per owner and per kind, against the budget.
+    void printReport() const;
+    // Prints every object still alive; call right before the GL context goes away.
+    // Returns the number of leaked objects.
+    size_t reportLeaks() const;
+
+private:
+    struct Allocation {
+        GLResourceKind kind;
+        GLuint id;
+        size_t bytes;
+        const char* format;
+        const char* owner;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint64_t, Allocation> m_allocations;
+    size_t m_residentBytes = 0;
+    size_t m_peakBytes = 0;
+    size_t m_budgetBytes = 0;
+    bool m_overBudget = false;
+
+    static uint64_t key(GLResourceKind kind, GLuint id) { return (static_cast<uint64_t>(kind) << 32) | id; }
+    // Call with m_mutex held; cause names the owner of the allocation that crossed, if any.
+    void checkBudget(const char* cause);
+};
+
+GLuint glCreateResource(GLResourceKind kind);
+void glDeleteResource(GLResourceKind kind, GLuint id);
+
+// Move-only owner of a single GL object. Creation and deletion are reported to the GpuMemoryRegistry.
+template <GLResourceKind Kind>
+class GLHandle {
+public:
+    GLHandle() = default;
+    ~GLHandle() { reset(); }
+
+    GLHandle(const GLHandle&) = delete;
+    GLHandle& operator=(const GLHandle&) = delete;
+
+    GLHandle(GLHandle&& other) noexcept : m_id(other.m_id) { other.m_id = 0; }
+    GLHandle& operator=(GLHandle&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_id = other.m_id;
+            other.m_id = 0;
+        }
+        return *this;
+    }
+
+    // Generates a new object.
+    static GLHandle create(const char* owner) {
+        return adopt(glCreateResource(Kind), owner);
+    }
+    // Takes ownership of an object created elsewhere (e.g. a linked shader program).
+    static GLHandle adopt(GLuint id, const char* owner) {
+        GLHandle handle;
+        handle.m_id = id;
+        if (id != 0) GpuMemoryRegistry::instance().onCreate(Kind, id, owner);
+        return handle;
+    }
+
+    // Records the memory backing this object, replacing any previous size.
+    void setStorage(size_t bytes, const char* format) const {
+        if (m_id != 0) GpuMemoryRegistry::instance().setStorage(Kind, m_id, bytes, format);
+    }
+
+    void reset() {
+        if (m_id != 0) {
+            GpuMemoryRegistry::instance().onDestroy(Kind, m_id);
+            glDeleteResource(Kind, m_id);
+            m_id = 0;
+        }
+    }
+
+    GLuint id() const { return m_id; }
+    explicit operator bool() const { return m_id != 0; }
+
+private:
+    GLuint m_id = 0;
+};
+
+using GLBuffer = GLHandle<GLResourceKind::Buffer>;
+using GLVertexArray = GLHandle<GLResourceKind::VertexArray>;
+using GLTexture = GLHandle<GLResourceKind::Texture>;
+using GLFramebuffer = GLHandle<GLResourceKind::Framebuffer>;
+using GLRenderbuffer = GLHandle<GLResourceKind::Renderbuffer>;
+using GLProgram = GLHandle<GLResourceKind::Program>;
+using GLQuery = GLHandle<GLResourceKind::Query>;
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <GL/glew.h>
+
+#include "GLResource.hpp"
+
+// Ring of GPU timestamp queries, read back a few frames late so timing never stalls the
+// pipeline. Each timed interval carries a Tag chosen by the caller (a mode, a frame number)
+// that comes back with its result.
+//
+// A slot still in flight when the ring comes round to it is skipped rather than waited on, so
+// a GPU running far behind leaves some intervals untimed.
+template <typename Tag, int SlotCount = 4>
+class GpuTimer {
+public:
+    explicit GpuTimer(const char* owner) {
+        for (Slot& slot : m_slots) {
+            slot.start = GLQuery::create(owner);
+            slot.end = GLQuery::create(owner);
+        }
+    }
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // Starts an interval at the GPU's current position in the command stream.
+    void begin() {
+        m_timing = !m_slots[m_index].pending;
+        if (m_timing) glQueryCounter(m_slots[m_index].start.id(), GL_TIMESTAMP);
+    }
+    // Ends the interval begin() started.
+    void end(const Tag& tag) {
+        if (!m_timing) return;
+        m_timing = false;
+        submit(tag, true);
+    }
+    // Records a lone timestamp, e.g. when the frame's last command completes; its startNs is 0.
+    void stamp(const Tag& tag) {
+        if (!m_slots[m_index].pending) submit(tag, false);
+    }
+
+    // Calls onResult(tag, startNs, endNs) for every interval whose queries have come back,
+    // oldest first.
+    template <typename Fn>
+    void poll(const Fn& onResult) {
+        for (int i = 0; i < SlotCount; ++i) {
+            Slot& slot = m_slots[(m_index + i) % SlotCount];
+            if (!slot.pending) continue;
+
+            // The end query finishes last, so the start is ready once it is.
+            GLint available = 0;
+            glGetQueryObjectiv(slot.end.id(), GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+
+            GLuint64 startNs = 0, endNs = 0;
+            if (slot.hasStart) glGetQueryObjectui64v(slot.start.id(), GL_QUERY_RESULT, &startNs);
+            glGetQueryObjectui64v(slot.end.id(), GL_QUERY_RESULT, &endNs);
+            slot.pending = false;
+            onResult(slot.tag, startNs, endNs);
+        }
+    }
+
+private:
+    struct Slot {
+        GLQuery start;
+        GLQuery end;
+        Tag tag{};
+        bool hasStart = false;
+        bool pending = false;
+    };
+
+    Slot m_slots[SlotCount];
+    int m_index = 0;
+    bool m_timing = false;
+
+    void submit(const Tag& tag, bool hasStart) {
+        Slot& slot = m_slots[m_index];
+        glQueryCounter(slot.end.id(), GL_TIMESTAMP);
+        slot.tag = tag;
+        slot.hasStart = hasStart;
+        slot.pending = true;
+        m_index = (m_index + 1) % SlotCount;
+    }
+};
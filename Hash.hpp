@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a. Chain calls by passing the previous result as hash.
+constexpr uint64_t kFnv1aOffsetBasis = 14695981039346656037ull;
+constexpr uint64_t kFnv1aPrime = 1099511628211ull;
+
+inline uint64_t fnv1a(const void* data, size_t bytes, uint64_t hash = kFnv1aOffsetBasis) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < bytes; ++i) {
+        hash ^= p[i];
+        hash *= kFnv1aPrime;
+    }
+    return hash;
+}
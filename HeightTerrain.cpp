@@ -0,0 +1,310 @@
+#include "HeightTerrain.hpp"
+#include "CameraUniforms.hpp"
+#include "ClusteredLighting.hpp"
+#include "Frustum.hpp"
+#include "Heightfield.hpp"
+#include "HorizonMap.hpp"
+#include "ShaderUtils.hpp"
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <glm/gtc/type_ptr.hpp>
+
+// Bytes per vertex of a conventional terrain mesh (position, normal, UV as floats), for the report.
+static constexpr size_t kConventionalVertexBytes = (3 + 3 + 2) * sizeof(float);
+
+static const char* heightTerrainVertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in uvec2 aChunkOrigin; // per instance, in texels
+
+uniform sampler2D heightMap;  // R16, normalized over heightRange
+uniform ivec2 mapSize;
+uniform vec2 gridOrigin;      // world x/z of texel (0, 0)
+uniform float gridScale;
+uniform vec2 heightRange;     // lowest height, highest minus lowest
+
+out vec3 vWorldPos;
+out vec3 vNormal;
+out float vViewDepth;
+
+float heightAt(ivec2 texel)
+{
+    texel = clamp(texel, ivec2(0), mapSize - 1);
+    return heightRange.x + texelFetch(heightMap, texel, 0).r * heightRange.y;
+}
+
+void main()
+{
+    // The shared index buffer holds vertex numbers inside a chunk, row by row.
+    ivec2 local = ivec2(gl_VertexID % CHUNK_VERTICES, gl_VertexID / CHUNK_VERTICES);
+    ivec2 texel = min(ivec2(aChunkOrigin) + local, mapSize - 1);
+
+    vec3 world = vec3(gridOrigin.x + texel.x * gridScale, heightAt(texel), gridOrigin.y + texel.y * gridScale);
+    float dx = heightAt(texel + ivec2(1, 0)) - heightAt(texel - ivec2(1, 0));
+    float dz = heightAt(texel + ivec2(0, 1)) - heightAt(texel - ivec2(0, 1));
+    vNormal = normalize(vec3(-dx, 2.0 * gridScale, -dz));
+
+    vec4 viewPos = view * vec4(world, 1.0);
+    vWorldPos = world;
+    vViewDepth = -viewPos.z;
+    gl_Position = projection * viewPos;
+}
+)";
+
+static const char* heightTerrainFragmentShaderSource = R"(
+#version 330 core
+in vec3 vWorldPos;
+in vec3 vNormal;
+in float vViewDepth;
+out vec4 FragColor;
+
+uniform vec4 bands; // sea level, sand top, grass top, slope where rock starts
+uniform vec3 sunDir;
+uniform vec3 sunColor;
+uniform ivec2 mapSize;
+uniform vec2 gridOrigin;
+uniform float gridScale;
+
+const vec3 kSeabed = vec3(0.35, 0.33, 0.25);
+const vec3 kSand = vec3(0.76, 0.70, 0.50);
+const vec3 kGrass = vec3(0.30, 0.45, 0.18);
+const vec3 kRock = vec3(0.45, 0.43, 0.40);
+
+void main()
+{
+    vec3 normal = normalize(vNormal);
+    float height = vWorldPos.y;
+    float slope = 1.0 - normal.y;
+
+    vec3 albedo = mix(kSeabed, kSand, smoothstep(bands.x - 5.0, bands.x, height));
+    albedo = mix(albedo, kGrass, smoothstep(bands.y - 5.0, bands.y + 5.0, height));
+    float rock = max(smoothstep(bands.z - 10.0, bands.z + 10.0, height), smoothstep(bands.w - 0.1, bands.w + 0.1, slope));
+    albedo = mix(albedo, kRock, rock);
+
+    // Texel centres of the height map sit at whole grid steps from gridOrigin.
+    vec2 mapUV = ((vWorldPos.xz - gridOrigin) / gridScale + 0.5) / vec2(mapSize);
+    float sunVisibility = horizonSunVisibility(mapUV, -sunDir);
+    float ambient = horizonAmbient(mapUV);
+
+    float diffuse = max(dot(normal, -sunDir), 0.0) * sunVisibility;
+    vec3 lights = clusteredPointLights(vWorldPos, normal, vViewDepth);
+    FragColor = vec4(albedo * (0.35 * ambient + 0.65 * diffuse * sunColor + lights), 1.0);
+}
+)";
+
+
+HeightTerrain::HeightTerrain() {
+    std::string vertexLibrary = "#define CHUNK_VERTICES " + std::to_string(kChunkVertices) + "\n" + CameraUniforms::shaderLibrary();
+    std::string vertexSource = withShaderLibrary(heightTerrainVertexShaderSource, vertexLibrary.c_str());
+    std::string fragmentLibrary = std::string(ClusteredLighting::shaderLibrary()) + HorizonMap::shaderLibrary();
+    std::string fragmentSource = withShaderLibrary(heightTerrainFragmentShaderSource, fragmentLibrary.c_str());
+    m_program = GLProgram::adopt(createShaderProgram(vertexSource.c_str(), fragmentSource.c_str()), "HeightTerrain");
+    if (!m_program) {
+        std::cerr << "Failed to create height terrain shader program." << std::endl;
+        return;
+    }
+    CameraUniforms::setupProgram(m_program.id());
+    ClusteredLighting::setupProgram(m_program.id());
+    HorizonMap::setupProgram(m_program.id());
+
+    m_mapSizeLoc = glGetUniformLocation(m_program.id(), "mapSize");
+    m_gridOriginLoc = glGetUniformLocation(m_program.id(), "gridOrigin");
+    m_gridScaleLoc = glGetUniformLocation(m_program.id(), "gridScale");
+    m_heightRangeLoc = glGetUniformLocation(m_program.id(), "heightRange");
+    m_bandsLoc = glGetUniformLocation(m_program.id(), "bands");
+    m_sunDirLoc = glGetUniformLocation(m_program.id(), "sunDir");
+    m_sunColorLoc = glGetUniformLocation(m_program.id(), "sunColor");
+    m_horizonEnabledLoc = glGetUniformLocation(m_program.id(), "horizonMapEnabled");
+    glUseProgram(m_program.id());
+    glUniform1i(glGetUniformLocation(m_program.id(), "heightMap"), 0);
+    glUseProgram(0);
+
+    // One chunk's triangles, counter-clockwise seen from above.
+    std::vector<uint16_t> indices;
+    indices.reserve(kChunkQuads * kChunkQuads * 6);
+    for (int z = 0; z < kChunkQuads; ++z) {
+        for (int x = 0; x < kChunkQuads; ++x) {
+            uint16_t a = static_cast<uint16_t>(z * kChunkVertices + x);
+            uint16_t b = static_cast<uint16_t>(a + 1);
+            uint16_t c = static_cast<uint16_t>(a + kChunkVertices);
+            uint16_t d = static_cast<uint16_t>(c + 1);
+            indices.insert(indices.end(), { a, c, b, b, c, d });
+        }
+    }
+    m_indexCount = static_cast<GLsizei>(indices.size());
+
+    m_vao = GLVertexArray::create("HeightTerrain");
+    glBindVertexArray(m_vao.id());
+    m_indexBuffer = GLBuffer::create("HeightTerrain");
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer.id());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    m_indexBuffer.setStorage(indices.size() * sizeof(uint16_t), "shared chunk indices u16");
+    telemetry::add(telemetry::Counter::BytesUploaded, indices.size() * sizeof(uint16_t));
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+    glBindVertexArray(0);
+}
+
+HeightTerrain::~HeightTerrain() = default;
+
+bool HeightTerrain::build(const Heightfield& heightfield) {
+    if (!heightfield.isValid() || heightfield.width() > 65536 || heightfield.depth() > 65536) return false;
+
+    m_width = heightfield.width();
+    m_depth = heightfield.depth();
+    m_gridScale = heightfield.gridScale();
+    glm::vec3 origin = heightfield.positionAt(0, 0);
+    m_gridOrigin = glm::vec2(origin.x, origin.z);
+
+    float minHeight = heightfield.heightAt(0, 0);
+    float maxHeight = minHeight;
+    for (int z = 0; z < m_depth; ++z) {
+        for (int x = 0; x < m_width; ++x) {
+            minHeight = std::min(minHeight, heightfield.heightAt(x, z));
+            maxHeight = std::max(maxHeight, heightfield.heightAt(x, z));
+        }
+    }
+    m_minHeight = minHeight;
+    m_heightRange = std::max(maxHeight - minHeight, 1e-3f);
+
+    std::vector<uint16_t> texels(static_cast<size_t>(m_width) * m_depth);
+    for (int z = 0; z < m_depth; ++z) {
+        for (int x = 0; x < m_width; ++x) {
+            float normalized = (heightfield.heightAt(x, z) - m_minHeight) / m_heightRange;
+            texels[static_cast<size_t>(z) * m_width + x] = static_cast<uint16_t>(std::lround(normalized * 65535.0f));
+        }
+    }
+
+    m_heightTexture = GLTexture::create("HeightTerrain");
+    glBindTexture(GL_TEXTURE_2D, m_heightTexture.id());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, m_width, m_depth, 0, GL_RED, GL_UNSIGNED_SHORT, texels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    m_heightTexture.setStorage(glTextureBytes(GL_R16, m_width, m_depth), "R16 heights");
+    telemetry::add(telemetry::Counter::BytesUploaded, texels.size() * sizeof(uint16_t));
+
+    // Chunk bounds from the full-resolution heights, including the shared edge row/column.
+    m_chunks.clear();
+    for (int originZ = 0; originZ < m_depth - 1; originZ += kChunkQuads) {
+        for (int originX = 0; originX < m_width - 1; originX += kChunkQuads) {
+            int lastX = std::min(originX + kChunkQuads, m_width - 1);
+            int lastZ = std::min(originZ + kChunkQuads, m_depth - 1);
+            float low = heightfield.heightAt(originX, originZ);
+            float high = low;
+            for (int z = originZ; z <= lastZ; ++z) {
+                for (int x = originX; x <= lastX; ++x) {
+                    low = std::min(low, heightfield.heightAt(x, z));
+                    high = std::max(high, heightfield.heightAt(x, z));
+                }
+            }
+            Chunk chunk;
+            chunk.bounds.min = glm::vec3(m_gridOrigin.x + originX * m_gridScale, low, m_gridOrigin.y + originZ * m_gridScale);
+            chunk.bounds.max = glm::vec3(m_gridOrigin.x + lastX * m_gridScale, high, m_gridOrigin.y + lastZ * m_gridScale);
+            chunk.originX = static_cast<uint16_t>(originX);
+            chunk.originZ = static_cast<uint16_t>(originZ);
+            m_chunks.push_back(chunk);
+        }
+    }
+
+    std::cout << "Height terrain: " << m_width << "x" << m_depth << " heights in " << m_chunks.size()
+              << " chunks of " << kChunkQuads << "x" << kChunkQuads << " quads" << std::endl;
+    return true;
+}
+
+void HeightTerrain::setBlendParams(float seaLevel, float sandTop, float grassTop, float slopeRockStart) {
+    m_bands = glm::vec4(seaLevel, sandTop, grassTop, slopeRockStart);
+}
+
+void HeightTerrain::setSun(const glm::vec3& direction, const glm::vec3& color) {
+    m_sunDirection = glm::normalize(direction);
+    m_sunColor = color;
+}
+
+void HeightTerrain::draw(const glm::mat4& view, const glm::mat4& projection, StreamBuffer& stream) {
+    m_frameStats = HeightTerrainStats();
+    if (!isValid() || m_chunks.empty()) return;
+
+    // Chunk origins of the visible chunks are the only vertex data: 4 bytes per chunk.
+    StreamAllocation allocation = stream.allocate(m_chunks.size() * 2 * sizeof(uint16_t));
+    if (!allocation) return;
+    uint16_t* origins = static_cast<uint16_t*>(allocation.data);
+
+    const Frustum frustum(projection * view);
+    GLsizei visible = 0;
+    for (const Chunk& chunk : m_chunks) {
+        if (!frustum.intersects(chunk.bounds)) {
+            m_frameStats.chunksCulled++;
+            continue;
+        }
+        origins[2 * visible] = chunk.originX;
+        origins[2 * visible + 1] = chunk.originZ;
+        visible++;
+    }
+    m_frameStats.chunksDrawn = static_cast<uint32_t>(visible);
+    if (visible == 0) return;
+    stream.flush();
+
+    glUseProgram(m_program.id());
+    glUniform2i(m_mapSizeLoc, m_width, m_depth);
+    glUniform2f(m_gridOriginLoc, m_gridOrigin.x, m_gridOrigin.y);
+    glUniform1f(m_gridScaleLoc, m_gridScale);
+    glUniform2f(m_heightRangeLoc, m_minHeight, m_heightRange);
+    glUniform4fv(m_bandsLoc, 1, glm::value_ptr(m_bands));
+    glUniform3fv(m_sunDirLoc, 1, glm::value_ptr(m_sunDirection));
+    glUniform3fv(m_sunColorLoc, 1, glm::value_ptr(m_sunColor));
+    const bool horizon = m_horizonMap && m_horizonMap->isValid();
+    glUniform1i(m_horizonEnabledLoc, horizon ? 1 : 0);
+    if (horizon) {
+        m_horizonMap->bind();
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_heightTexture.id());
+
+    glBindVertexArray(m_vao.id());
+    glBindBuffer(GL_ARRAY_BUFFER, stream.buffer());
+    glVertexAttribIPointer(0, 2, GL_UNSIGNED_SHORT, 2 * sizeof(uint16_t), (void*)allocation.offset);
+    glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_SHORT, nullptr, visible);
+    telemetry::countDraw(static_cast<uint64_t>(m_indexCount / 3) * visible);
+    telemetry::add(telemetry::Counter::StateChanges, 3);
+    telemetry::add(telemetry::Counter::TextureBinds);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+}
+
+void HeightTerrain::printMemoryReport() const {
+    if (!isValid()) return;
+
+    const double vertices = static_cast<double>(m_width) * m_depth;
+    const double quads = static_cast<double>(m_width - 1) * (m_depth - 1);
+    const double conventionalVertexBytes = vertices * kConventionalVertexBytes;
+    const double conventionalIndexBytes = quads * 6 * sizeof(uint32_t);
+    const double heightBytes = vertices * sizeof(uint16_t);
+    const double indexBytes = static_cast<double>(m_indexCount) * sizeof(uint16_t);
+    const double instanceBytes = static_cast<double>(m_chunks.size()) * 2 * sizeof(uint16_t); // per frame, at most
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Height terrain memory:" << std::endl
+              << "  vertex data: " << heightBytes / (1 << 20) << " MiB of R16 heights vs "
+              << conventionalVertexBytes / (1 << 20) << " MiB of position/normal/UV vertices ("
+              << std::setprecision(1) << conventionalVertexBytes / heightBytes << "x smaller)" << std::endl
+              << std::setprecision(2)
+              << "  indices: " << indexBytes / 1024.0 << " KiB shared by " << m_chunks.size() << " chunks vs "
+              << conventionalIndexBytes / (1 << 20) << " MiB for the whole grid" << std::endl
+              << "  total: " << (heightBytes + indexBytes + instanceBytes) / (1 << 20) << " MiB vs "
+              << (conventionalVertexBytes + conventionalIndexBytes) / (1 << 20) << " MiB ("
+              << std::setprecision(1) << (conventionalVertexBytes + conventionalIndexBytes) / (heightBytes + indexBytes + instanceBytes)
+              << "x smaller)" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
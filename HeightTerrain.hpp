@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "GLResource.hpp"
+#include "StreamBuffer.hpp"
+
+class Heightfield;
+class HorizonMap;
+
+struct HeightTerrainStats {
+    uint32_t chunksDrawn = 0;
+    uint32_t chunksCulled = 0;
+};
+
+// Terrain drawn without any per-vertex data.
+//
+// Heights live in one R16 texture; x/z follow from the grid index and gridScale. The map is
+// split into kChunkQuads x kChunkQuads chunks that all share a single index buffer whose
+// values are vertex numbers inside a chunk: the vertex shader turns gl_VertexID plus the
+// chunk's origin (the only per-instance attribute) into a texel, fetches its height and
+// rebuilds the normal from the neighbouring heights. Visible chunks go out in one instanced draw.
+class HeightTerrain {
+public:
+    static constexpr int kChunkQuads = 64;
+    static constexpr int kChunkVertices = kChunkQuads + 1; // per side
+
+    HeightTerrain();
+    ~HeightTerrain();
+
+    HeightTerrain(const HeightTerrain&) = delete;
+    HeightTerrain& operator=(const HeightTerrain&) = delete;
+
+    // Uploads the heights and per-chunk bounds. Uses the heightfield's grid layout and scales.
+    bool build(const Heightfield& heightfield);
+    bool isValid() const { return m_program && m_heightTexture; }
+
+    // Same meaning as Island::setBlendParams; slope is 1 - normal.y.
+    void setBlendParams(float seaLevel, float sandTop, float grassTop, float slopeRockStart);
+    void setSun(const glm::vec3& direction, const glm::vec3& color);
+    // Sun shadows and ambient occlusion from a horizon map baked from the same heightfield; null turns them off.
+    void setHorizonMap(const HorizonMap* horizonMap) { m_horizonMap = horizonMap; }
+
+    // stream must be between beginFrame/endFrame.
+    void draw(const glm::mat4& view, const glm::mat4& projection, StreamBuffer& stream);
+
+    const HeightTerrainStats& frameStats() const { return m_frameStats; }
+    // GPU bytes held by the terrain, against a conventional position/normal/UV mesh of the same grid.
+    void printMemoryReport() const;
+
+private:
+    struct Chunk {
+        AABB bounds;
+        uint16_t originX, originZ; // first texel
+    };
+
+    GLProgram m_program;
+    GLint m_mapSizeLoc = -1;
+    GLint m_gridOriginLoc = -1;
+    GLint m_gridScaleLoc = -1;
+    GLint m_heightRangeLoc = -1;
+    GLint m_bandsLoc = -1;
+    GLint m_sunDirLoc = -1;
+    GLint m_sunColorLoc = -1;
+    GLint m_horizonEnabledLoc = -1;
+
+    GLTexture m_heightTexture;
+    GLBuffer m_indexBuffer;
+    GLVertexArray m_vao;
+    GLsizei m_indexCount = 0;
+
+    int m_width = 0;
+    int m_depth = 0;
+    glm::vec2 m_gridOrigin = glm::vec2(0.0f);
+    float m_gridScale = 1.0f;
+    float m_minHeight = 0.0f;
+    float m_heightRange = 1.0f;
+    std::vector<Chunk> m_chunks;
+
+    glm::vec4 m_bands = glm::vec4(0.0f, 30.0f, 100.0f, 0.5f);
+    glm::vec3 m_sunDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 m_sunColor = glm::vec3(1.0f);
+    const HorizonMap* m_horizonMap = nullptr;
+
+    HeightTerrainStats m_frameStats;
+};
@@ -0,0 +1,140 @@
+#include "Heightfield.hpp"
+#include "AssetBundle.hpp"
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stb_image.h>
+
+Heightfield::Heightfield(const char* path, float heightScale, float gridScale, bool center)
+    : m_heightScale(heightScale), m_gridScale(gridScale)
+{
+    int width, depth, nrChannels;
+    if (isImage16Bit(path)) {
+        unsigned short* data = loadImage16(path, &width, &depth, &nrChannels, 1);
+        if (!data) {
+            std::cerr << "Heightfield failed to load: " << path << ". Reason: " << stbi_failure_reason() << std::endl;
+            return;
+        }
+        m_heights.resize(static_cast<size_t>(width) * depth);
+        for (size_t i = 0; i < m_heights.size(); ++i)
+            m_heights[i] = (data[i] / 65535.0f) * heightScale;
+        stbi_image_free(data);
+    } else {
+        unsigned char* data = loadImage(path, &width, &depth, &nrChannels, 1);
+        if (!data) {
+            std::cerr << "Heightfield failed to load: " << path << ". Reason: " << stbi_failure_reason() << std::endl;
+            return;
+        }
+        m_heights.resize(static_cast<size_t>(width) * depth);
+        for (size_t i = 0; i < m_heights.size(); ++i)
+            m_heights[i] = (data[i] / 255.0f) * heightScale;
+        stbi_image_free(data);
+    }
+
+    m_width = width;
+    m_depth = depth;
+    if (center) {
+        m_origin = glm::vec2(-(m_width - 1) * gridScale * 0.5f, -(m_depth - 1) * gridScale * 0.5f);
+    }
+}
+
+Heightfield::Heightfield(int width, int depth, const std::vector<float>& normalizedHeights, float heightScale, float gridScale, bool center)
+    : m_heightScale(heightScale), m_gridScale(gridScale)
+{
+    if (width < 2 || depth < 2 || normalizedHeights.size() != static_cast<size_t>(width) * depth) {
+        std::cerr << "Heightfield given " << normalizedHeights.size() << " heights for a " << width << "x" << depth << " grid" << std::endl;
+        return;
+    }
+    m_heights.resize(normalizedHeights.size());
+    for (size_t i = 0; i < m_heights.size(); ++i)
+        m_heights[i] = normalizedHeights[i] * heightScale;
+
+    m_width = width;
+    m_depth = depth;
+    if (center) {
+        m_origin = glm::vec2(-(m_width - 1) * gridScale * 0.5f, -(m_depth - 1) * gridScale * 0.5f);
+    }
+}
+
+float Heightfield::heightAt(int x, int z) const {
+    x = std::clamp(x, 0, m_width - 1);
+    z = std::clamp(z, 0, m_depth - 1);
+    return m_heights[static_cast<size_t>(z) * m_width + x];
+}
+
+glm::vec3 Heightfield::positionAt(int x, int z) const {
+    return glm::vec3(m_origin.x + x * m_gridScale, heightAt(x, z), m_origin.y + z * m_gridScale);
+}
+
+float Heightfield::sampleHeight(float worldX, float worldZ) const {
+    if (!isValid()) return 0.0f;
+
+    float fx = std::clamp((worldX - m_origin.x) / m_gridScale, 0.0f, static_cast<float>(m_width - 1));
+    float fz = std::clamp((worldZ - m_origin.y) / m_gridScale, 0.0f, static_cast<float>(m_depth - 1));
+    int x0 = static_cast<int>(fx);
+    int z0 = static_cast<int>(fz);
+    float tx = fx - x0;
+    float tz = fz - z0;
+
+    float h00 = heightAt(x0, z0);
+    float h10 = heightAt(x0 + 1, z0);
+    float h01 = heightAt(x0, z0 + 1);
+    float h11 = heightAt(x0 + 1, z0 + 1);
+    float top = h00 + (h10 - h00) * tx;
+    float bottom = h01 + (h11 - h01) * tx;
+    return top + (bottom - top) * tz;
+}
+
+glm::vec3 Heightfield::sampleNormal(float worldX, float worldZ) const {
+    float hl = sampleHeight(worldX - m_gridScale, worldZ);
+    float hr = sampleHeight(worldX + m_gridScale, worldZ);
+    float hd = sampleHeight(worldX, worldZ - m_gridScale);
+    float hu = sampleHeight(worldX, worldZ + m_gridScale);
+    return glm::normalize(glm::vec3(hl - hr, 2.0f * m_gridScale, hd - hu));
+}
+
+uint64_t Heightfield::contentHash() const {
+    uint64_t hash = fnv1a(&m_width, sizeof(m_width));
+    hash = fnv1a(&m_depth, sizeof(m_depth), hash);
+    hash = fnv1a(&m_heightScale, sizeof(m_heightScale), hash);
+    hash = fnv1a(&m_gridScale, sizeof(m_gridScale), hash);
+    return fnv1a(m_heights.data(), m_heights.size() * sizeof(float), hash);
+}
+
+void Heightfield::buildConservativeMesh(int step, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) const {
+    positions.clear();
+    indices.clear();
+    if (!isValid() || step < 1) return;
+
+    // Coarse vertex count per axis; the last vertex is pinned to the map edge.
+    int cols = (m_width - 2) / step + 2;
+    int rows = (m_depth - 2) / step + 2;
+    positions.reserve(static_cast<size_t>(cols) * rows);
+
+    for (int cz = 0; cz < rows; ++cz) {
+        int z = std::min(cz * step, m_depth - 1);
+        for (int cx = 0; cx < cols; ++cx) {
+            int x = std::min(cx * step, m_width - 1);
+
+            // Minimum over every texel covered by the quads touching this vertex.
+            float minHeight = heightAt(x, z);
+            for (int sz = std::max(z - step, 0); sz <= std::min(z + step, m_depth - 1); ++sz)
+                for (int sx = std::max(x - step, 0); sx <= std::min(x + step, m_width - 1); ++sx)
+                    minHeight = std::min(minHeight, m_heights[static_cast<size_t>(sz) * m_width + sx]);
+
+            positions.emplace_back(m_origin.x + x * m_gridScale, minHeight, m_origin.y + z * m_gridScale);
+        }
+    }
+
+    indices.reserve(static_cast<size_t>(cols - 1) * (rows - 1) * 6);
+    for (int cz = 0; cz < rows - 1; ++cz) {
+        for (int cx = 0; cx < cols - 1; ++cx) {
+            uint32_t i0 = cz * cols + cx;
+            uint32_t i1 = i0 + 1;
+            uint32_t i2 = i0 + cols;
+            uint32_t i3 = i2 + 1;
+            indices.insert(indices.end(), { i0, i2, i1, i1, i2, i3 });
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// CPU-side copy of the island heightmap.
+// Uses the same grid layout as Island: texel (x, z) sits at (x * gridScale, h * heightScale, z * gridScale),
+// optionally shifted so the map is centered on the origin.
+class Heightfield {
+public:
+    Heightfield() = default;
+    Heightfield(const char* path, float heightScale, float gridScale, bool center);
+    // From width * depth heights in [0, 1], row-major; for generated terrain.
+    Heightfield(int width, int depth, const std::vector<float>& normalizedHeights, float heightScale, float gridScale, bool center);
+
+    bool isValid() const { return m_width > 1 && m_depth > 1; }
+
+    int width() const { return m_width; }
+    int depth() const { return m_depth; }
+    float heightScale() const { return m_heightScale; }
+    float gridScale() const { return m_gridScale; }
+
+    // World-space height of texel (x, z), clamped to the map edges.
+    float heightAt(int x, int z) const;
+    // World-space position of texel (x, z).
+    glm::vec3 positionAt(int x, int z) const;
+    // Bilinearly interpolated world-space height under (worldX, worldZ).
+    float sampleHeight(float worldX, float worldZ) const;
+    // Surface normal under (worldX, worldZ), from central differences.
+    glm::vec3 sampleNormal(float worldX, float worldZ) const;
+
+    // FNV-1a hash of the dimensions, scales and every height; used to key on-disk caches.
+    uint64_t contentHash() const;
+
+    // Builds a coarse triangle mesh with one vertex every `step` texels.
+    // Each vertex takes the lowest height of the texels it spans, so the mesh never rises
+    // above the full-resolution surface and is safe to use as an occluder.
+    void buildConservativeMesh(int step, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) const;
+
+private:
+    int m_width = 0;
+    int m_depth = 0;
+    float m_heightScale = 1.0f;
+    float m_gridScale = 1.0f;
+    glm::vec2 m_origin = glm::vec2(0.0f);
+    std::vector<float> m_heights; // world-space heights, row-major (z * width + x)
+};
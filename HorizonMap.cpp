@@ -0,0 +1,251 @@
+#include "HorizonMap.hpp"
+#include "Hash.hpp"
+#include "Heightfield.hpp"
+#include "JobSystem.hpp"
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <emmintrin.h>
+
+// Bump when the bake or the cache layout changes.
+static constexpr uint32_t kCacheVersion = 1;
+static constexpr char kCacheMagic[8] = { 'I', 'S', 'L', 'H', 'R', 'Z', '\0', '\0' };
+
+struct HorizonCacheHeader {
+    char magic[8];
+    uint64_t key;
+    int32_t width;
+    int32_t depth;
+};
+
+// The shader and the texture layout pack four directions per RGBA8 layer.
+static_assert(HorizonMap::kDirections == 8 && HorizonMap::kLayers == 3, "horizon layout is hard-wired in the shader");
+
+// Rows handed to a worker at a time.
+static constexpr int kRowsPerTask = 8;
+
+static const char* horizonLibrarySource = R"(
+uniform sampler2DArray horizonMap;
+uniform bool horizonMapEnabled;
+
+// toSun is the unit vector towards the sun. Soft across a small band around the horizon.
+float horizonSunVisibility(vec2 uv, vec3 toSun)
+{
+    if (!horizonMapEnabled) return 1.0;
+    float azimuth = atan(toSun.z, toSun.x) * (HORIZON_DIRECTIONS / 6.28318531);
+    float sector = mod(azimuth, HORIZON_DIRECTIONS);
+    int first = int(sector) % HORIZON_DIRECTIONS;
+    int second = (first + 1) % HORIZON_DIRECTIONS;
+    vec4 low = texture(horizonMap, vec3(uv, 0.0));
+    vec4 high = texture(horizonMap, vec3(uv, 1.0));
+    float horizons[HORIZON_DIRECTIONS] = float[](low.r, low.g, low.b, low.a, high.r, high.g, high.b, high.a);
+    float horizon = mix(horizons[first], horizons[second], fract(sector));
+    return smoothstep(horizon - 0.04, horizon + 0.04, toSun.y);
+}
+
+float horizonAmbient(vec2 uv)
+{
+    if (!horizonMapEnabled) return 1.0;
+    return texture(horizonMap, vec3(uv, 2.0)).r;
+}
+)";
+
+const char* HorizonMap::shaderLibrary() {
+    static const std::string library = "#define HORIZON_DIRECTIONS " + std::to_string(kDirections) + "\n" + horizonLibrarySource;
+    return library.c_str();
+}
+
+void HorizonMap::setupProgram(GLuint program) {
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "horizonMap"), static_cast<GLint>(kTextureUnit));
+    glUseProgram(0);
+}
+
+bool HorizonMap::build(const Heightfield& heightfield, const char* cachePath) {
+    m_texture = GLTexture();
+    if (!heightfield.isValid()) return false;
+
+    m_width = heightfield.width();
+    m_depth = heightfield.depth();
+
+    uint64_t key = heightfield.contentHash();
+    const float heightScale = heightfield.heightScale();
+    key = fnv1a(&heightScale, sizeof(heightScale), key);
+    const int layout[] = { kDirections, kMaxDistanceTexels, kLayers, static_cast<int>(kCacheVersion) };
+    key = fnv1a(layout, sizeof(layout), key);
+
+    auto start = std::chrono::steady_clock::now();
+    bool cached = cachePath && loadCache(cachePath, key);
+    if (!cached) {
+        bake(heightfield);
+        if (cachePath) writeCache(cachePath, key);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Horizon map: " << m_width << "x" << m_depth << ", " << kDirections << " directions ("
+              << (cached ? "loaded from cache" : "baked") << " in " << std::fixed << std::setprecision(1) << ms << " ms)" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    return !m_texels.empty();
+}
+
+void HorizonMap::bake(const Heightfield& heightfield) {
+    // A copy of the heights with a border wide enough for the longest step, so rays never
+    // need bounds checks. The border holds the lowest height: beyond the map nothing occludes.
+    // Rows get three extra columns so the last group of four lanes stays inside.
+    const int border = kMaxDistanceTexels;
+    const size_t stride = static_cast<size_t>(m_width) + 2 * border + 3;
+    const size_t rows = static_cast<size_t>(m_depth) + 2 * border;
+    float lowest = heightfield.heightAt(0, 0);
+    for (int z = 0; z < m_depth; ++z) {
+        for (int x = 0; x < m_width; ++x) {
+            lowest = std::min(lowest, heightfield.heightAt(x, z));
+        }
+    }
+    std::vector<float> padded(stride * rows, lowest);
+    for (int z = 0; z < m_depth; ++z) {
+        float* row = padded.data() + (z + border) * stride + border;
+        for (int x = 0; x < m_width; ++x) {
+            row[x] = heightfield.heightAt(x, z);
+        }
+    }
+
+    // Steps along each direction, spaced further apart with distance. Offsets are rounded to
+    // whole texels, so four neighbouring texels sample four neighbouring heights with one load.
+    struct Step {
+        ptrdiff_t offset;
+        float inverseDistance; // world units
+    };
+    std::vector<Step> steps[kDirections];
+    for (int k = 0; k < kDirections; ++k) {
+        const float angle = 6.28318531f * k / kDirections;
+        const float dirX = std::cos(angle);
+        const float dirZ = std::sin(angle);
+        int lastX = 0, lastZ = 0;
+        for (float distance = 1.0f; distance <= kMaxDistanceTexels; distance = std::max(distance + 1.0f, distance * 1.15f)) {
+            int dx = static_cast<int>(std::lround(dirX * distance));
+            int dz = static_cast<int>(std::lround(dirZ * distance));
+            if ((dx == lastX && dz == lastZ) || std::abs(dx) > border || std::abs(dz) > border) continue;
+            lastX = dx;
+            lastZ = dz;
+            float world = std::sqrt(static_cast<float>(dx * dx + dz * dz)) * heightfield.gridScale();
+            steps[k].push_back({ dz * static_cast<ptrdiff_t>(stride) + dx, 1.0f / world });
+        }
+    }
+
+    m_texels.assign(static_cast<size_t>(kLayers) * m_width * m_depth * 4, 0);
+    const size_t layerBytes = static_cast<size_t>(m_width) * m_depth * 4;
+
+    auto bakeRow = [&](int z) {
+        const float* row = padded.data() + (z + border) * stride + border;
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 inverseDirections = _mm_set1_ps(1.0f / kDirections);
+        alignas(16) int32_t lanes[4];
+
+        for (int x = 0; x < m_width; x += 4) {
+            const float* base = row + x;
+            const __m128 h0 = _mm_loadu_ps(base);
+            const int count = std::min(4, m_width - x);
+            __m128 ambient = zero;
+
+            for (int k = 0; k < kDirections; ++k) {
+                // Tangent of the steepest elevation seen; below the horizontal counts as open sky.
+                __m128 maxTangent = zero;
+                for (const Step& step : steps[k]) {
+                    __m128 rise = _mm_sub_ps(_mm_loadu_ps(base + step.offset), h0);
+                    maxTangent = _mm_max_ps(maxTangent, _mm_mul_ps(rise, _mm_set1_ps(step.inverseDistance)));
+                }
+                // sin(atan(t)) = t / sqrt(1 + t^2)
+                __m128 tangentSquared = _mm_mul_ps(maxTangent, maxTangent);
+                __m128 sine = _mm_div_ps(maxTangent, _mm_sqrt_ps(_mm_add_ps(one, tangentSquared)));
+                // Cosine-weighted sky visible above the horizon of this slice: cos^2 = 1 - sin^2.
+                ambient = _mm_add_ps(ambient, _mm_sub_ps(one, _mm_mul_ps(sine, sine)));
+
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sine, scale), half)));
+                uint8_t* out = m_texels.data() + (k / 4) * layerBytes + (static_cast<size_t>(z) * m_width + x) * 4 + (k % 4);
+                for (int i = 0; i < count; ++i) out[i * 4] = static_cast<uint8_t>(lanes[i]);
+            }
+
+            ambient = _mm_mul_ps(ambient, inverseDirections);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(ambient, scale), half)));
+            uint8_t* out = m_texels.data() + 2 * layerBytes + (static_cast<size_t>(z) * m_width + x) * 4;
+            for (int i = 0; i < count; ++i) out[i * 4] = static_cast<uint8_t>(lanes[i]);
+        }
+    };
+
+    // Rows are independent; bands of kRowsPerTask rows spread over the job system.
+    JobSystem::instance().parallelFor("Horizon rows", m_depth, kRowsPerTask, [&](int begin, int end) {
+        for (int z = begin; z < end; ++z) bakeRow(z);
+    });
+}
+
+void HorizonMap::upload() {
+    if (m_texels.empty()) return;
+
+    m_texture = GLTexture::create("HorizonMap");
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture.id());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, m_width, m_depth, kLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_texels.data());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    m_texture.setStorage(glTextureBytes(GL_RGBA8, m_width, m_depth, kLayers), "RGBA8 horizons + ambient");
+    telemetry::add(telemetry::Counter::BytesUploaded, m_texels.size());
+
+    // The GPU copy is all the shaders need.
+    std::vector<uint8_t>().swap(m_texels);
+}
+
+void HorizonMap::bind() const {
+    glActiveTexture(GL_TEXTURE0 + kTextureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture.id());
+    glActiveTexture(GL_TEXTURE0);
+    telemetry::add(telemetry::Counter::TextureBinds);
+}
+
+bool HorizonMap::loadCache(const char* path, uint64_t key) {
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    if (!stream.is_open()) return false;
+
+    HorizonCacheHeader header;
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+        header.key != key || header.width != m_width || header.depth != m_depth) {
+        std::cout << "Horizon cache " << path << " is stale, rebaking." << std::endl;
+        return false;
+    }
+
+    m_texels.resize(static_cast<size_t>(kLayers) * m_width * m_depth * 4);
+    if (!stream.read(reinterpret_cast<char*>(m_texels.data()), m_texels.size())) {
+        std::cerr << "Horizon cache " << path << " is truncated, rebaking." << std::endl;
+        m_texels.clear();
+        return false;
+    }
+    return true;
+}
+
+void HorizonMap::writeCache(const char* path, uint64_t key) const {
+    std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        std::cerr << "Failed to write horizon cache: " << path << std::endl;
+        return;
+    }
+
+    HorizonCacheHeader header;
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.key = key;
+    header.width = m_width;
+    header.depth = m_depth;
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(m_texels.data()), m_texels.size());
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+
+#include "GLResource.hpp"
+
+class Heightfield;
+
+// Per-texel terrain horizons and ambient occlusion, baked once from the heightfield.
+//
+// For kDirections compass directions the bake marches away from every texel and keeps the
+// steepest elevation it sees; the sine of that horizon angle per direction, plus an ambient
+// term integrated from all of them, goes into a small RGBA8 texture array. Shaders then get
+// sun visibility by comparing the sun's elevation with the horizon interpolated at the sun's
+// azimuth, so moving the sun costs two texture fetches instead of a march over the terrain.
+//
+// The bake runs on the job system, four texels at a time with SSE, and is cached on disk
+// keyed by the heightfield's contents and height scale.
+class HorizonMap {
+public:
+    static constexpr int kDirections = 8;
+    static constexpr int kMaxDistanceTexels = 256;
+    // Layers 0 and 1 hold the horizons of directions 0-3 and 4-7, layer 2 the ambient term in red.
+    static constexpr int kLayers = 3;
+    // Left alone by the rest of the renderer, like ClusteredLighting's units.
+    static constexpr GLuint kTextureUnit = 11;
+
+    HorizonMap() = default;
+
+    HorizonMap(const HorizonMap&) = delete;
+    HorizonMap& operator=(const HorizonMap&) = delete;
+
+    // Loads the maps from cachePath if they were baked from the same heights, otherwise bakes
+    // them and rewrites the cache. cachePath may be null to always bake. Makes no GL calls, so
+    // it may run on a job; upload() then creates the texture.
+    bool build(const Heightfield& heightfield, const char* cachePath);
+    // Creates the texture and drops the CPU copy. GL thread only.
+    void upload();
+    bool isValid() const { return static_cast<bool>(m_texture); }
+
+    void bind() const;
+
+    // GLSL, spliced in with withShaderLibrary(): horizonSunVisibility(uv, toSun) and
+    // horizonAmbient(uv), where uv is the map coordinate. Both return 1 while horizonMapEnabled is false.
+    static const char* shaderLibrary();
+    // Points the program's sampler at kTextureUnit.
+    static void setupProgram(GLuint program);
+
+private:
+    void bake(const Heightfield& heightfield);
+    bool loadCache(const char* path, uint64_t key);
+    void writeCache(const char* path, uint64_t key) const;
+
+    int m_width = 0;
+    int m_depth = 0;
+    std::vector<uint8_t> m_texels; // kLayers * depth * width RGBA8, dropped once uploaded
+    GLTexture m_texture;
+};
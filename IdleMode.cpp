@@ -0,0 +1,159 @@
+#include "IdleMode.hpp"
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/type_ptr.hpp>
+
+static bool sameMatrix(const glm::mat4& a, const glm::mat4& b) {
+    return std::memcmp(glm::value_ptr(a), glm::value_ptr(b), sizeof(glm::mat4)) == 0;
+}
+
+IdleMode::IdleMode(const IdleConfig& config)
+    : m_config(config)
+{
+    m_config.staticFramesToIdle = std::max(m_config.staticFramesToIdle, 2);
+}
+
+IdleMode::~IdleMode() = default;
+
+void IdleMode::waitForNextTick() {
+    if (!m_idle) return;
+    if (m_config.animationHz <= 0.0f) {
+        glfwWaitEvents();
+        return;
+    }
+    double period = 1.0 / m_config.animationHz;
+    double now = glfwGetTime();
+    // First idle frame, or more than a tick late: count ticks from now.
+    if (m_nextTick < now - period) m_nextTick = now;
+    if (m_nextTick > now) glfwWaitEventsTimeout(m_nextTick - now);
+    m_nextTick += period;
+}
+
+bool IdleMode::beginScene(const glm::mat4& view, const glm::mat4& projection, int renderWidth, int renderHeight,
+                          int targetWidth, int targetHeight) {
+    if (!m_config.enabled) return false;
+
+    if (targetWidth != m_targetWidth || targetHeight != m_targetHeight) {
+        m_targetWidth = targetWidth;
+        m_targetHeight = targetHeight;
+        // Reallocated at the new size on the next capture.
+        m_cacheFbo.reset();
+        m_cacheColor = GLTexture();
+        m_cacheDepth = GLTexture();
+        m_cacheValid = false;
+    }
+
+    bool unchanged = sameMatrix(view, m_lastView) && sameMatrix(projection, m_lastProjection) &&
+                     renderWidth == m_renderWidth && renderHeight == m_renderHeight;
+    m_lastView = view;
+    m_lastProjection = projection;
+    m_renderWidth = renderWidth;
+    m_renderHeight = renderHeight;
+
+    if (!unchanged) {
+        if (m_idle) std::cout << "Idle mode: off" << std::endl;
+        m_staticFrames = 0;
+        m_idle = false;
+        m_cacheValid = false;
+        return false;
+    }
+    m_staticFrames++;
+    if (m_cacheValid && !m_idle) {
+        m_idle = true;
+        std::cout << "Idle mode: on" << std::endl;
+    }
+    return m_idle;
+}
+
+void IdleMode::allocateCache() {
+    m_cacheColor = GLTexture::create("IdleMode");
+    glBindTexture(GL_TEXTURE_2D, m_cacheColor.id());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_targetWidth, m_targetHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    m_cacheColor.setStorage(glTextureBytes(GL_RGBA8, m_targetWidth, m_targetHeight), "RGBA8 static layers");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // Same format as the scene's depth, which glBlitFramebuffer requires.
+    m_cacheDepth = GLTexture::create("IdleMode");
+    glBindTexture(GL_TEXTURE_2D, m_cacheDepth.id());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, m_targetWidth, m_targetHeight, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    m_cacheDepth.setStorage(glTextureBytes(GL_DEPTH_COMPONENT24, m_targetWidth, m_targetHeight), "D24 static layers");
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_cacheFbo = GLFramebuffer::create("IdleMode");
+    glBindFramebuffer(GL_FRAMEBUFFER, m_cacheFbo.id());
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_cacheColor.id(), 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_cacheDepth.id(), 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Idle mode cache framebuffer is incomplete." << std::endl;
+    }
+}
+
+void IdleMode::blit(GLuint from, GLuint to) const {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, from);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, to);
+    glBlitFramebuffer(0, 0, m_renderWidth, m_renderHeight, 0, 0, m_renderWidth, m_renderHeight,
+                      GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    telemetry::add(telemetry::Counter::StateChanges, 2);
+}
+
+void IdleMode::staticLayersDrawn(GLuint sceneFramebuffer) {
+    if (!m_config.enabled || m_cacheValid || m_staticFrames < m_config.staticFramesToIdle) return;
+    if (!m_cacheFbo) allocateCache();
+    blit(sceneFramebuffer, m_cacheFbo.id());
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+    m_cacheValid = true;
+}
+
+void IdleMode::restoreStaticLayers(GLuint sceneFramebuffer) {
+    blit(m_cacheFbo.id(), sceneFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+}
+
+void IdleMode::beginFrameTiming() {
+    m_gpuTimer.poll([this](bool idle, GLuint64 startNs, GLuint64 endNs) {
+        Stats& stats = m_stats[idle ? 1 : 0];
+        stats.timedFrames++;
+        stats.gpuMs += (endNs - startNs) / 1.0e6;
+    });
+    m_gpuTimer.begin();
+}
+
+void IdleMode::endFrameTiming() {
+    // Wall time since the previous frame, sleep included.
+    double now = glfwGetTime();
+    Stats& stats = m_stats[m_idle ? 1 : 0];
+    stats.frames++;
+    if (m_lastFrameEnd > 0.0) stats.wallMs += (now - m_lastFrameEnd) * 1000.0;
+    m_lastFrameEnd = now;
+
+    m_gpuTimer.end(m_idle);
+}
+
+void IdleMode::printStats() const {
+    if (!m_config.enabled) return;
+    const Stats& active = m_stats[0];
+    const Stats& idle = m_stats[1];
+    auto averageGpuMs = [](const Stats& stats) { return stats.timedFrames ? stats.gpuMs / stats.timedFrames : 0.0; };
+
+    std::cout << std::fixed << std::setprecision(2) << "Idle mode: " << idle.frames << " idle frames over "
+              << (idle.wallMs / 1000.0) << " s";
+    if (idle.frames > 0 && idle.wallMs > 0.0) {
+        double busyMs = averageGpuMs(idle) * idle.frames;
+        std::cout << ", avg GPU " << averageGpuMs(idle) << " ms per frame, GPU busy "
+                  << (100.0 * busyMs / idle.wallMs) << "% of the idle time";
+    }
+    std::cout << "; " << active.frames << " active frames, avg GPU " << averageGpuMs(active) << " ms";
+    if (active.wallMs > 0.0) {
+        std::cout << ", GPU busy " << (100.0 * averageGpuMs(active) * active.frames / active.wallMs) << "%";
+    }
+    std::cout << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
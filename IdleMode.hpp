@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GLResource.hpp"
+#include "GpuTimer.hpp"
+
+struct IdleConfig {
+    bool enabled = true;
+    int staticFramesToIdle = 8; // unchanged frames before the static layers are cached
+    float animationHz = 30.0f;  // redraw rate while idle; 0 redraws only on input
+};
+
+// Render-on-demand for a still camera.
+//
+// While the view, projection and render size stay the same, the sky, terrain and vegetation
+// come out identical every frame and only the windmills turn. After staticFramesToIdle such
+// frames the static layers' colour and depth are copied aside once; idle frames then copy them
+// back and draw only the windmills on top, and the loop sleeps in glfwWaitEventsTimeout()
+// between animation ticks instead of spinning at the display rate. Any change to the view
+// ends idling on the frame it happens.
+//
+// Every frame's GPU time is measured with timestamp queries and kept apart for idle and
+// active frames, along with the wall time spent idle, to report how busy the GPU stays.
+class IdleMode {
+public:
+    explicit IdleMode(const IdleConfig& config = IdleConfig());
+    ~IdleMode();
+
+    IdleMode(const IdleMode&) = delete;
+    IdleMode& operator=(const IdleMode&) = delete;
+
+    bool isIdle() const { return m_idle; }
+    // True once the view has held still for a frame. TAA holds its jitter from then on so the
+    // cached layers and the windmills drawn over them share one sub-pixel offset, and dynamic
+    // resolution holds its scale, since a new render size would throw the cache away.
+    bool isSettling() const { return m_config.enabled && m_staticFrames > 0; }
+
+    // Sleeps until input arrives or the next animation tick is due. Returns immediately unless idle.
+    void waitForNextTick();
+
+    // Compares this frame's camera and render size with the last frame's, decides whether this
+    // frame is idle, and returns true if the static layers can be restored instead of drawn.
+    bool beginScene(const glm::mat4& view, const glm::mat4& projection, int renderWidth, int renderHeight,
+                    int targetWidth, int targetHeight);
+    // Call after the static layers were drawn into sceneFramebuffer; caches them when due.
+    void staticLayersDrawn(GLuint sceneFramebuffer);
+    // Copies the cached layers into sceneFramebuffer.
+    void restoreStaticLayers(GLuint sceneFramebuffer);
+
+    // Bracket everything the frame submits to the GPU.
+    void beginFrameTiming();
+    void endFrameTiming();
+
+    void printStats() const;
+
+private:
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t timedFrames = 0;
+        double gpuMs = 0.0;
+        double wallMs = 0.0;
+    };
+
+    IdleConfig m_config;
+    bool m_idle = false;
+    bool m_cacheValid = false;
+    int m_staticFrames = 0;
+    glm::mat4 m_lastView{ 0.0f };
+    glm::mat4 m_lastProjection{ 0.0f };
+    int m_renderWidth = 0;
+    int m_renderHeight = 0;
+    int m_targetWidth = 0;
+    int m_targetHeight = 0;
+    double m_nextTick = 0.0;
+    double m_lastFrameEnd = 0.0;
+
+    GLFramebuffer m_cacheFbo;
+    GLTexture m_cacheColor;
+    GLTexture m_cacheDepth;
+
+    GpuTimer<bool> m_gpuTimer{ "IdleMode" }; // tagged with whether the frame was idle
+    Stats m_stats[2]; // active, idle
+
+    void allocateCache();
+    void blit(GLuint from, GLuint to) const;
+};
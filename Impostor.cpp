@@ -0,0 +1,365 @@
+#include "Impostor.hpp"
+#include "CameraUniforms.hpp"
+#include "ShaderUtils.hpp"
+#include "Telemetry.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// Same inputs as SimpleColor.vert; writes albedo plus a derivative normal and the orthographic depth.
+static const char* bakeVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec2 aTexCoord;
+
+layout (std140) uniform ObjectBlock
+{
+    mat4 model;
+};
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 vColor;
+out vec2 vTexCoord;
+out vec3 vWorldPos;
+
+void main()
+{
+    vec4 world = model * vec4(aPos, 1.0);
+    vWorldPos = world.xyz;
+    vColor = aColor;
+    vTexCoord = aTexCoord;
+    gl_Position = projection * view * world;
+}
+)";
+
+static const char* bakeFragmentShaderSource = R"(
+#version 330 core
+in vec3 vColor;
+in vec2 vTexCoord;
+in vec3 vWorldPos;
+
+layout (location = 0) out vec4 albedo;
+layout (location = 1) out vec4 normalDepth;
+
+uniform sampler2D textureSampler;
+
+void main()
+{
+    albedo = vec4(texture(textureSampler, vTexCoord).rgb * vColor, 1.0);
+    // Faces are drawn double-sided, so take the normal facing the baking camera.
+    vec3 n = normalize(cross(dFdx(vWorldPos), dFdy(vWorldPos)));
+    normalDepth = vec4(n * 0.5 + 0.5, gl_FragCoord.z);
+}
+)";
+
+// Camera-facing quad from gl_VertexID; the four views around the current direction are chosen here.
+static const char* impostorVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec4 aCenterYaw;
+layout (location = 1) in vec2 aPhaseFade;
+
+uniform float radius;
+uniform float frameCount;
+uniform float gridSize;
+
+out vec2 vUV;
+out vec3 vViewPos;
+flat out vec4 vCells01;
+flat out vec4 vCells23;
+flat out vec4 vWeights;
+flat out float vLayer;
+flat out float vFade;
+flat out float vYaw;
+
+vec2 hemiOctEncode(vec3 d)
+{
+    d /= abs(d.x) + abs(d.y) + abs(d.z);
+    return vec2(d.x + d.z, d.x - d.z);
+}
+
+void main()
+{
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    vec3 center = aCenterYaw.xyz;
+    vec3 toCamera = normalize(cameraPosition.xyz - center);
+    vec3 right = cross(vec3(0.0, 1.0, 0.0), toCamera);
+    right = dot(right, right) < 1e-6 ? vec3(1.0, 0.0, 0.0) : normalize(right);
+    vec3 up = cross(toCamera, right);
+
+    vec3 world = center + (right * corner.x + up * corner.y) * radius;
+    vViewPos = (view * vec4(world, 1.0)).xyz;
+    gl_Position = projection * vec4(vViewPos, 1.0);
+    vUV = corner * 0.5 + 0.5;
+
+    // Direction to the camera in the model's own frame, clamped to the baked hemisphere.
+    float c = cos(aCenterYaw.w);
+    float s = sin(aCenterYaw.w);
+    vec3 local = vec3(c * toCamera.x - s * toCamera.z, max(toCamera.y, 0.0), s * toCamera.x + c * toCamera.z);
+    vec2 grid = clamp((hemiOctEncode(normalize(local)) * 0.5 + 0.5) * gridSize - 0.5, 0.0, gridSize - 1.0);
+    vec2 cell = min(floor(grid), gridSize - 2.0);
+    vec2 t = grid - cell;
+    vCells01 = vec4(cell, cell + vec2(1.0, 0.0)) / gridSize;
+    vCells23 = vec4(cell + vec2(0.0, 1.0), cell + vec2(1.0, 1.0)) / gridSize;
+    vWeights = vec4((1.0 - t.x) * (1.0 - t.y), t.x * (1.0 - t.y), (1.0 - t.x) * t.y, t.x * t.y);
+
+    vLayer = min(floor(aPhaseFade.x * frameCount), frameCount - 1.0);
+    vFade = aPhaseFade.y;
+    vYaw = aCenterYaw.w;
+}
+)";
+
+static const char* impostorFragmentShaderSource = R"(
+#version 330 core
+in vec2 vUV;
+in vec3 vViewPos;
+flat in vec4 vCells01;
+flat in vec4 vCells23;
+flat in vec4 vWeights;
+flat in float vLayer;
+flat in float vFade;
+flat in float vYaw;
+
+out vec4 FragColor;
+
+uniform sampler2DArray albedoAtlas;
+uniform sampler2DArray normalDepthAtlas;
+uniform float radius;
+uniform float gridSize;
+uniform float cellSize;
+uniform vec3 sunDir;
+uniform vec3 sunColor;
+uniform float lighting;
+
+void main()
+{
+    // Flipped dither: covers exactly the pixels the fading mesh LOD discards.
+    if (1.0 - ditherThreshold() >= vFade) discard;
+
+    vec2 inner = clamp(vUV, vec2(0.5 / cellSize), vec2(1.0 - 0.5 / cellSize)) / gridSize;
+    vec4 albedo = texture(albedoAtlas, vec3(vCells01.xy + inner, vLayer)) * vWeights.x +
+                  texture(albedoAtlas, vec3(vCells01.zw + inner, vLayer)) * vWeights.y +
+                  texture(albedoAtlas, vec3(vCells23.xy + inner, vLayer)) * vWeights.z +
+                  texture(albedoAtlas, vec3(vCells23.zw + inner, vLayer)) * vWeights.w;
+    if (albedo.a < 0.5) discard;
+    vec4 normalDepth = texture(normalDepthAtlas, vec3(vCells01.xy + inner, vLayer)) * vWeights.x +
+                       texture(normalDepthAtlas, vec3(vCells01.zw + inner, vLayer)) * vWeights.y +
+                       texture(normalDepthAtlas, vec3(vCells23.xy + inner, vLayer)) * vWeights.z +
+                       texture(normalDepthAtlas, vec3(vCells23.zw + inner, vLayer)) * vWeights.w;
+    // Empty texels are zero in both atlases, so dividing by coverage undoes the partial blend.
+    albedo.rgb /= albedo.a;
+    normalDepth /= albedo.a;
+
+    // Baked depth is linear over [center - radius, center + radius] along the view axis.
+    vec3 viewPos = vViewPos;
+    viewPos.z += radius * (1.0 - 2.0 * normalDepth.a);
+    vec4 clip = projection * vec4(viewPos, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+    vec3 n = normalDepth.xyz * 2.0 - 1.0;
+    float c = cos(vYaw);
+    float s = sin(vYaw);
+    n = normalize(vec3(c * n.x + s * n.z, n.y, -s * n.x + c * n.z));
+    vec3 lit = albedo.rgb * (0.35 + 0.65 * max(dot(n, -sunDir), 0.0) * sunColor);
+    FragColor = vec4(mix(albedo.rgb, lit, lighting), 1.0);
+}
+)";
+
+// Inverse of hemiOctEncode in the shader: grid cell center -> direction on the upper hemisphere.
+static glm::vec3 hemiOctDecode(float u, float v) {
+    float x = (u + v) * 0.5f;
+    float z = (u - v) * 0.5f;
+    return glm::normalize(glm::vec3(x, 1.0f - std::fabs(x) - std::fabs(z), z));
+}
+
+Impostor::Impostor() {
+    m_bakeProgram = GLProgram::adopt(createShaderProgram(bakeVertexShaderSource, bakeFragmentShaderSource), "Impostor");
+    std::string vertexSource = withShaderLibrary(impostorVertexShaderSource, CameraUniforms::shaderLibrary());
+    std::string fragmentLibrary = std::string(CameraUniforms::shaderLibrary()) + ditherShaderLibrary();
+    std::string fragmentSource = withShaderLibrary(impostorFragmentShaderSource, fragmentLibrary.c_str());
+    m_program = GLProgram::adopt(createShaderProgram(vertexSource.c_str(), fragmentSource.c_str()), "Impostor");
+    if (!m_bakeProgram || !m_program) {
+        std::cerr << "Failed to create impostor shader programs." << std::endl;
+        return;
+    }
+
+    m_bakeViewLoc = glGetUniformLocation(m_bakeProgram.id(), "view");
+    m_bakeProjLoc = glGetUniformLocation(m_bakeProgram.id(), "projection");
+    m_bakeSamplerLoc = glGetUniformLocation(m_bakeProgram.id(), "textureSampler");
+
+    GLuint program = m_program.id();
+    CameraUniforms::setupProgram(program);
+    m_radiusLoc = glGetUniformLocation(program, "radius");
+    m_frameCountLoc = glGetUniformLocation(program, "frameCount");
+    m_sunDirLoc = glGetUniformLocation(program, "sunDir");
+    m_sunColorLoc = glGetUniformLocation(program, "sunColor");
+    m_lightingLoc = glGetUniformLocation(program, "lighting");
+
+    // Constant uniforms
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "albedoAtlas"), 0);
+    glUniform1i(glGetUniformLocation(program, "normalDepthAtlas"), 1);
+    glUniform1f(glGetUniformLocation(program, "gridSize"), static_cast<float>(kViewGrid));
+    glUniform1f(glGetUniformLocation(program, "cellSize"), static_cast<float>(kCellSize));
+    glUseProgram(0);
+
+    // Instance attributes only; their pointers are set per draw into the stream buffer.
+    m_vao = GLVertexArray::create("Impostor");
+    glBindVertexArray(m_vao.id());
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glBindVertexArray(0);
+}
+
+Impostor::~Impostor() = default;
+
+GLTexture Impostor::createAtlas(int size, int layers) {
+    GLTexture atlas = GLTexture::create("Impostor");
+    glBindTexture(GL_TEXTURE_2D_ARRAY, atlas.id());
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Stop while a view is still 8 texels wide so neighbouring views don't bleed into each other.
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 4);
+    atlas.setStorage(glTextureBytes(GL_RGBA8, size, size, layers, true), "RGBA8 array mipmapped");
+    return atlas;
+}
+
+bool Impostor::bake(const AABB& bounds, int frameCount, const DrawModelFn& drawModel) {
+    if (!m_bakeProgram || !m_program || frameCount < 1) return false;
+
+    const int atlasSize = kViewGrid * kCellSize;
+    const glm::vec3 center = bounds.center();
+    m_radius = glm::length(bounds.extents());
+
+    m_albedoAtlas = createAtlas(atlasSize, frameCount);
+    m_normalDepthAtlas = createAtlas(atlasSize, frameCount);
+
+    GLFramebuffer fbo = GLFramebuffer::create("ImpostorBake");
+    GLRenderbuffer depth = GLRenderbuffer::create("ImpostorBake");
+    glBindRenderbuffer(GL_RENDERBUFFER, depth.id());
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasSize, atlasSize);
+    depth.setStorage(glTextureBytes(GL_DEPTH_COMPONENT24, atlasSize, atlasSize), "DEPTH24");
+
+    GLint previousFramebuffer = 0;
+    GLint previousViewport[4] = {};
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo.id());
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth.id());
+    const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+
+    glUseProgram(m_bakeProgram.id());
+    glUniform1i(m_bakeSamplerLoc, 0);
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    // The orthographic box spans the bounding sphere, so baked depth maps linearly onto it.
+    const glm::mat4 projection = glm::ortho(-m_radius, m_radius, -m_radius, m_radius, m_radius, 3.0f * m_radius);
+    glUniformMatrix4fv(m_bakeProjLoc, 1, GL_FALSE, glm::value_ptr(projection));
+
+    bool complete = true;
+    for (int frame = 0; frame < frameCount && complete; ++frame) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_albedoAtlas.id(), 0, frame);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, m_normalDepthAtlas.id(), 0, frame);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Impostor bake framebuffer is incomplete." << std::endl;
+            complete = false;
+            break;
+        }
+        glViewport(0, 0, atlasSize, atlasSize);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        for (int j = 0; j < kViewGrid; ++j) {
+            for (int i = 0; i < kViewGrid; ++i) {
+                float u = (i + 0.5f) / kViewGrid * 2.0f - 1.0f;
+                float v = (j + 0.5f) / kViewGrid * 2.0f - 1.0f;
+                glm::vec3 direction = hemiOctDecode(u, v);
+                glm::mat4 view = glm::lookAt(center + direction * (2.0f * m_radius), center, glm::vec3(0.0f, 1.0f, 0.0f));
+
+                glViewport(i * kCellSize, j * kCellSize, kCellSize, kCellSize);
+                glUseProgram(m_bakeProgram.id());
+                glUniformMatrix4fv(m_bakeViewLoc, 1, GL_FALSE, glm::value_ptr(view));
+                drawModel(m_bakeProgram.id(), frame);
+            }
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+    glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    glUseProgram(0);
+
+    if (!complete) {
+        m_albedoAtlas.reset();
+        m_normalDepthAtlas.reset();
+        return false;
+    }
+
+    for (GLTexture* atlas : { &m_albedoAtlas, &m_normalDepthAtlas }) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, atlas->id());
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    m_frameCount = frameCount;
+    std::cout << "Impostor baked: " << kViewGrid * kViewGrid << " views x " << frameCount << " frames, "
+              << atlasSize << "x" << atlasSize << " atlases, radius " << m_radius << std::endl;
+    return true;
+}
+
+void Impostor::setSun(const glm::vec3& direction, const glm::vec3& color, float amount) {
+    m_sunDirection = glm::normalize(direction);
+    m_sunColor = color;
+    m_lighting = amount;
+}
+
+void Impostor::draw(const ImpostorInstance* instances, GLsizei count, StreamBuffer& stream) {
+    if (!isBaked() || count <= 0) return;
+
+    StreamAllocation allocation = stream.allocate(count * sizeof(ImpostorInstance));
+    if (!allocation) return;
+    std::memcpy(allocation.data, instances, count * sizeof(ImpostorInstance));
+    stream.flush();
+
+    glUseProgram(m_program.id());
+    glUniform1f(m_radiusLoc, m_radius);
+    glUniform1f(m_frameCountLoc, static_cast<float>(m_frameCount));
+    glUniform3fv(m_sunDirLoc, 1, glm::value_ptr(m_sunDirection));
+    glUniform3fv(m_sunColorLoc, 1, glm::value_ptr(m_sunColor));
+    glUniform1f(m_lightingLoc, m_lighting);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_albedoAtlas.id());
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_normalDepthAtlas.id());
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(m_vao.id());
+    glBindBuffer(GL_ARRAY_BUFFER, stream.buffer());
+    const size_t base = static_cast<size_t>(allocation.offset);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance), (void*)(base + offsetof(ImpostorInstance, center)));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance), (void*)(base + offsetof(ImpostorInstance, phase)));
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    telemetry::countDraw(2ull * count);
+    telemetry::add(telemetry::Counter::StateChanges, 3);
+    telemetry::add(telemetry::Counter::TextureBinds, 2);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+
+    m_frameStats.instancesDrawn += count;
+    m_frameStats.drawCalls++;
+}
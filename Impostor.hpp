@@ -0,0 +1,89 @@
+#pragma once
+
+#include <functional>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "GLResource.hpp"
+#include "StreamBuffer.hpp"
+
+// One impostor quad. Laid out as the per-instance vertex attributes.
+struct ImpostorInstance {
+    glm::vec3 center; // world-space center of the baked bounds
+    float yaw;        // model rotation about the vertical axis through center, radians
+    float phase;      // animation phase in [0, 1), selects the baked frame
+    float fade;       // 1 = fully drawn; below 1 it is dithered against the mesh LOD
+};
+
+struct ImpostorStats {
+    uint32_t instancesDrawn = 0;
+    uint32_t drawCalls = 0;
+};
+
+// Pre-rendered stand-in for a distant model.
+// bake() renders the model from kViewGrid x kViewGrid directions spread over the upper hemisphere
+// (hemi-octahedral mapping) into an albedo atlas and a normal/depth atlas, one texture array layer
+// per animation frame. draw() then renders every instance as a single camera-facing quad that
+// blends the four nearest baked views and writes the baked depth, so it still intersects terrain.
+class Impostor {
+public:
+    static constexpr int kViewGrid = 8;   // views per atlas axis
+    static constexpr int kCellSize = 128; // texels per view
+
+    // Draws the model for animation frame `frame` with `program`. The program takes the
+    // PosColorUV vertex layout, the ObjectBlock model matrix and textureSampler on unit 0;
+    // its view and projection are already set.
+    using DrawModelFn = std::function<void(GLuint program, int frame)>;
+
+    Impostor();
+    ~Impostor();
+
+    Impostor(const Impostor&) = delete;
+    Impostor& operator=(const Impostor&) = delete;
+
+    // Renders the atlases offscreen. bounds is the model's world-space box as drawn by drawModel.
+    bool bake(const AABB& bounds, int frameCount, const DrawModelFn& drawModel);
+    bool isBaked() const { return m_frameCount > 0; }
+
+    // Radius of the baked bounds; instance quads are twice this wide.
+    float radius() const { return m_radius; }
+    int frameCount() const { return m_frameCount; }
+
+    // Impostors match the unlit mesh shader by default; amount > 0 shades them with the baked normals.
+    void setSun(const glm::vec3& direction, const glm::vec3& color, float amount);
+
+    // Instances are copied into stream, which must be between beginFrame/endFrame.
+    // The camera comes from CameraUniforms.
+    void draw(const ImpostorInstance* instances, GLsizei count, StreamBuffer& stream);
+
+    const ImpostorStats& frameStats() const { return m_frameStats; }
+    void resetFrameStats() { m_frameStats = ImpostorStats(); }
+
+private:
+    GLProgram m_bakeProgram;
+    GLint m_bakeViewLoc = -1;
+    GLint m_bakeProjLoc = -1;
+    GLint m_bakeSamplerLoc = -1;
+
+    GLProgram m_program;
+    GLint m_radiusLoc = -1;
+    GLint m_frameCountLoc = -1;
+    GLint m_sunDirLoc = -1;
+    GLint m_sunColorLoc = -1;
+    GLint m_lightingLoc = -1;
+
+    GLVertexArray m_vao;
+    GLTexture m_albedoAtlas;
+    GLTexture m_normalDepthAtlas;
+
+    float m_radius = 1.0f;
+    int m_frameCount = 0;
+    glm::vec3 m_sunDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 m_sunColor = glm::vec3(1.0f);
+    float m_lighting = 0.0f;
+
+    ImpostorStats m_frameStats;
+
+    static GLTexture createAtlas(int size, int layers);
+};
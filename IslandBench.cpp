@@ -0,0 +1,332 @@
+// Microbenchmarks of the CPU-side pieces of the renderer, plus scaling runs over generated scenes.
+//
+//   island_bench [--benchmark_filter=<regex>] [google benchmark flags...]
+//
+// Results are written as JSON to island_bench.json unless --benchmark_out is given, so runs can
+// be compared over time (e.g. with benchmark's tools/compare.py). Scaling benchmarks report a
+// fitted complexity; a family whose fit is worse than its expected order is where scaling breaks.
+// Run from the build directory, where the assets are copied, for the decode benchmarks.
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <stb_image.h>
+
+#include "AABB.hpp"
+#include "Camera.hpp"
+#include "Frustum.hpp"
+#include "Heightfield.hpp"
+#include "JobSystem.hpp"
+#include "OcclusionCuller.hpp"
+#include "Windmill.hpp"
+
+namespace {
+
+// Same scales as the island in main.cpp.
+constexpr float kHeightScale = 350.0f;
+constexpr float kGridScale = 1.5f;
+
+// A terrain, objects standing on it and a camera looking across it, all from a seed.
+struct SyntheticScene {
+    Heightfield terrain;
+    std::vector<AABB> objects;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+};
+
+float latticeValue(int x, int z, uint32_t seed) {
+    uint32_t h = static_cast<uint32_t>(x) * 374761393u + static_cast<uint32_t>(z) * 668265263u + seed * 2246822519u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return static_cast<float>((h ^ (h >> 16)) & 0xffffff) / static_cast<float>(0xffffff);
+}
+
+float valueNoise(float x, float z, uint32_t seed) {
+    int x0 = static_cast<int>(std::floor(x));
+    int z0 = static_cast<int>(std::floor(z));
+    float tx = x - x0, tz = z - z0;
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+    float a = latticeValue(x0, z0, seed), b = latticeValue(x0 + 1, z0, seed);
+    float c = latticeValue(x0, z0 + 1, seed), d = latticeValue(x0 + 1, z0 + 1, seed);
+    return (a + (b - a) * tx) + ((c + (d - c) * tx) - (a + (b - a) * tx)) * tz;
+}
+
+// Five octaves of value noise under a radial falloff, so the map is an island like the real one.
+std::vector<float> generateIslandHeights(int size, uint32_t seed) {
+    std::vector<float> heights(static_cast<size_t>(size) * size);
+    const float frequency = 6.0f / size;
+    for (int z = 0; z < size; ++z) {
+        for (int x = 0; x < size; ++x) {
+            float sum = 0.0f, amplitude = 0.5f, scale = frequency;
+            for (int octave = 0; octave < 5; ++octave) {
+                sum += amplitude * valueNoise(x * scale, z * scale, seed + octave);
+                amplitude *= 0.5f;
+                scale *= 2.0f;
+            }
+            float dx = (x - size * 0.5f) / (size * 0.5f);
+            float dz = (z - size * 0.5f) / (size * 0.5f);
+            float falloff = std::max(0.0f, 1.0f - std::sqrt(dx * dx + dz * dz));
+            heights[static_cast<size_t>(z) * size + x] = std::min(1.0f, sum * falloff * 1.6f);
+        }
+    }
+    return heights;
+}
+
+std::unique_ptr<SyntheticScene> generateScene(int terrainSize, int objectCount, uint32_t seed) {
+    auto scene = std::make_unique<SyntheticScene>();
+    scene->terrain = Heightfield(terrainSize, terrainSize, generateIslandHeights(terrainSize, seed), kHeightScale, kGridScale, true);
+
+    // Windmill- to tree-sized boxes scattered over the map.
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float halfExtent = (terrainSize - 1) * kGridScale * 0.5f;
+    scene->objects.reserve(objectCount);
+    for (int i = 0; i < objectCount; ++i) {
+        float x = (unit(rng) * 2.0f - 1.0f) * halfExtent;
+        float z = (unit(rng) * 2.0f - 1.0f) * halfExtent;
+        float y = scene->terrain.sampleHeight(x, z);
+        float radius = 1.0f + 4.0f * unit(rng);
+        float height = 2.0f + 18.0f * unit(rng);
+        scene->objects.push_back({ glm::vec3(x - radius, y, z - radius), glm::vec3(x + radius, y + height, z + radius) });
+    }
+
+    // Standing above the southern shore, looking north across the island.
+    glm::vec3 eye(0.0f, kHeightScale * 0.4f, halfExtent * 0.9f);
+    glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 4000.0f);
+    scene->viewProjection = projection * view;
+    return scene;
+}
+
+// Scenes are expensive to generate at the large sizes, so every benchmark shares them.
+const SyntheticScene& sceneFor(int terrainSize, int objectCount) {
+    static std::map<std::pair<int, int>, std::unique_ptr<SyntheticScene>> scenes;
+    std::unique_ptr<SyntheticScene>& scene = scenes[{ terrainSize, objectCount }];
+    if (!scene) scene = generateScene(terrainSize, objectCount, /*seed=*/1);
+    return *scene;
+}
+
+bool readFile(const char* path, std::vector<unsigned char>& data) {
+    std::ifstream stream(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!stream.is_open()) return false;
+    data.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(data.data()), data.size()));
+}
+
+const char* const kSkyboxFaces[] = {
+    "assets/right.png", "assets/left.png", "assets/top.png",
+    "assets/bottom.png", "assets/front.png", "assets/back.png",
+};
+
+} // namespace
+
+
+// --- Camera ------------------------------------------------------------------------------------
+
+// updateCameraVectors is private; mouse movement is the path that runs it every frame.
+static void BM_CameraUpdateVectors(benchmark::State& state) {
+    Camera camera(glm::vec3(0.0f, 50.0f, 0.0f));
+    float direction = 1.0f;
+    for (auto _ : state) {
+        camera.ProcessMouseMovement(direction, 0.5f * direction);
+        direction = -direction;
+        benchmark::DoNotOptimize(camera.Front);
+    }
+}
+BENCHMARK(BM_CameraUpdateVectors);
+
+static void BM_CameraViewMatrix(benchmark::State& state) {
+    Camera camera(glm::vec3(0.0f, 50.0f, 0.0f));
+    for (auto _ : state) {
+        glm::mat4 view = camera.GetViewMatrix();
+        benchmark::DoNotOptimize(view);
+        camera.Position.x += 0.001f;
+    }
+}
+BENCHMARK(BM_CameraViewMatrix);
+
+// --- Terrain -----------------------------------------------------------------------------------
+
+static void BM_GenerateTerrain(benchmark::State& state) {
+    const int size = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        std::vector<float> heights = generateIslandHeights(size, 1);
+        benchmark::DoNotOptimize(heights.data());
+    }
+    state.SetComplexityN(static_cast<int64_t>(size) * size);
+    state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_GenerateTerrain)->Arg(257)->Arg(513)->Arg(1025)->Unit(benchmark::kMillisecond)->Complexity(benchmark::oN);
+
+// Heightmap to triangle mesh, at several map sizes and sample steps.
+static void BM_HeightfieldMesh(benchmark::State& state) {
+    const Heightfield& terrain = sceneFor(static_cast<int>(state.range(0)), 0).terrain;
+    const int step = static_cast<int>(state.range(1));
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    for (auto _ : state) {
+        terrain.buildConservativeMesh(step, positions, indices);
+        benchmark::DoNotOptimize(indices.data());
+    }
+    state.counters["vertices"] = static_cast<double>(positions.size());
+    state.counters["triangles"] = static_cast<double>(indices.size() / 3);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(indices.size() / 3));
+}
+BENCHMARK(BM_HeightfieldMesh)
+    ->ArgsProduct({ { 257, 513, 1025, 2049 }, { 1, 2, 4, 8, 16 } })
+    ->ArgNames({ "size", "step" })
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_HeightfieldMeshScaling(benchmark::State& state) {
+    const Heightfield& terrain = sceneFor(static_cast<int>(state.range(0)), 0).terrain;
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    for (auto _ : state) {
+        terrain.buildConservativeMesh(1, positions, indices);
+        benchmark::DoNotOptimize(indices.data());
+    }
+    state.SetComplexityN(state.range(0) * state.range(0));
+}
+BENCHMARK(BM_HeightfieldMeshScaling)
+    ->Arg(129)->Arg(257)->Arg(513)->Arg(1025)->Arg(2049)
+    ->Unit(benchmark::kMicrosecond)
+    ->Complexity(benchmark::oN);
+
+// --- Image decode ------------------------------------------------------------------------------
+
+static void decodeImages(benchmark::State& state, const char* const* paths, size_t count) {
+    std::vector<std::vector<unsigned char>> files(count);
+    int64_t encodedBytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!readFile(paths[i], files[i])) {
+            state.SkipWithError((std::string("missing ") + paths[i]).c_str());
+            return;
+        }
+        encodedBytes += static_cast<int64_t>(files[i].size());
+    }
+    int64_t decodedBytes = 0;
+    for (auto _ : state) {
+        for (const std::vector<unsigned char>& file : files) {
+            int width, height, channels;
+            unsigned char* pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, 0);
+            benchmark::DoNotOptimize(pixels);
+            if (pixels) decodedBytes += static_cast<int64_t>(width) * height * channels;
+            stbi_image_free(pixels);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * encodedBytes);
+    state.counters["decoded_MB"] = benchmark::Counter(static_cast<double>(decodedBytes) / (1 << 20), benchmark::Counter::kAvgIterations);
+}
+
+static void BM_DecodeCubemap(benchmark::State& state) {
+    decodeImages(state, kSkyboxFaces, std::size(kSkyboxFaces));
+}
+BENCHMARK(BM_DecodeCubemap)->Unit(benchmark::kMillisecond);
+
+static void BM_DecodeTexture(benchmark::State& state) {
+    const char* const bricks[] = { "assets/bricks.jpg" };
+    decodeImages(state, bricks, 1);
+}
+BENCHMARK(BM_DecodeTexture)->Unit(benchmark::kMillisecond);
+
+// --- Windmills ---------------------------------------------------------------------------------
+
+// The per-frame hierarchy (base, head, hub, blades) for a field of windmills.
+static void BM_WindmillTransforms(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    const std::vector<AABB>& sites = sceneFor(513, count).objects;
+    glm::mat4 parts[Windmill::kPartCount];
+    float time = 0.0f;
+    for (auto _ : state) {
+        for (const AABB& site : sites) {
+            Windmill::computePartTransforms(site.center(), 1.0f, Windmill::headAngleAt(time), Windmill::bladeAngleAt(time), parts);
+            benchmark::DoNotOptimize(parts);
+        }
+        time += 1.0f / 60.0f;
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetComplexityN(count);
+}
+BENCHMARK(BM_WindmillTransforms)->RangeMultiplier(8)->Range(1, 32768)->Complexity(benchmark::oN);
+
+// --- Culling -----------------------------------------------------------------------------------
+
+static void BM_FrustumCull(benchmark::State& state) {
+    const SyntheticScene& scene = sceneFor(1025, static_cast<int>(state.range(0)));
+    size_t visible = 0;
+    for (auto _ : state) {
+        const Frustum frustum(scene.viewProjection);
+        visible = 0;
+        for (const AABB& box : scene.objects) {
+            visible += frustum.intersects(box) ? 1 : 0;
+        }
+        benchmark::DoNotOptimize(visible);
+    }
+    state.counters["visible"] = static_cast<double>(visible);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_FrustumCull)->RangeMultiplier(4)->Range(1 << 10, 1 << 20)->Unit(benchmark::kMicrosecond)->Complexity(benchmark::oN);
+
+// A whole occlusion frame: rasterize the terrain occluder, then test every box in the frustum.
+static void BM_OcclusionCull(benchmark::State& state) {
+    const SyntheticScene& scene = sceneFor(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    OcclusionCuller culler;
+    culler.setOccluder(scene.terrain, /*step=*/16);
+    const Frustum frustum(scene.viewProjection);
+    size_t visible = 0;
+    for (auto _ : state) {
+        culler.beginFrame(scene.viewProjection);
+        visible = 0;
+        for (const AABB& box : scene.objects) {
+            if (frustum.intersects(box) && culler.isVisible(box)) visible++;
+        }
+        culler.endFrame();
+        benchmark::DoNotOptimize(visible);
+    }
+    state.counters["visible"] = static_cast<double>(visible);
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_OcclusionCull)
+    ->ArgsProduct({ { 513, 1025, 2049 }, { 1 << 10, 1 << 14, 1 << 18 } })
+    ->ArgNames({ "terrain", "objects" })
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+
+// Like BENCHMARK_MAIN(), but writes JSON to island_bench.json unless told otherwise.
+int main(int argc, char** argv) {
+    std::vector<char*> args(argv, argv + argc);
+    bool hasOutput = false;
+    for (int i = 1; i < argc; ++i) {
+        hasOutput = hasOutput || std::strncmp(argv[i], "--benchmark_out=", 16) == 0;
+    }
+    char outArg[] = "--benchmark_out=island_bench.json";
+    char formatArg[] = "--benchmark_out_format=json";
+    if (!hasOutput) {
+        args.push_back(outArg);
+        args.push_back(formatArg);
+    }
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) return 1;
+    // The occluder rasterizes on a job, as it does in the program.
+    JobSystem::instance().start();
+    benchmark::RunSpecifiedBenchmarks();
+    JobSystem::instance().stop();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,320 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Index into m_threads of the calling thread; -1 for threads the job system did not start.
+static thread_local int t_thread = -1;
+
+JobSystem& JobSystem::instance() {
+    static JobSystem system;
+    return system;
+}
+
+JobSystem::~JobSystem() {
+    stop();
+}
+
+void JobSystem::start(int workerCount) {
+    if (!m_threads.empty()) return;
+    if (workerCount <= 0) {
+        workerCount = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+    }
+
+    m_quit = false;
+    t_thread = 0;
+    for (int i = 0; i <= workerCount; ++i) {
+        m_threads.push_back(std::make_unique<ThreadState>());
+        if (m_tracing) m_threads.back()->trace.reserve(kTraceCapacity);
+    }
+    for (int i = 1; i <= workerCount; ++i) {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+    std::cout << "Job system: " << workerCount << " workers" << std::endl;
+}
+
+void JobSystem::stop() {
+    if (m_workers.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        if (worker.joinable()) worker.join();
+    }
+    m_workers.clear();
+    m_threads.clear();
+}
+
+bool JobSystem::isMainThread() const {
+    return t_thread == 0;
+}
+
+void JobSystem::submit(const char* name, JobFunction function, void* context, JobCounter* counter,
+                       JobAffinity affinity, int begin, int end) {
+    if (counter) counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    Job job{ name, function, context, counter, begin, end };
+
+    // Before start() there is nobody else to run it.
+    if (m_threads.empty()) {
+        execute(job, t_thread);
+        return;
+    }
+    if (affinity == JobAffinity::MainThread) {
+        pushMainThreadJob(job);
+        return;
+    }
+    // Threads outside the system hand their jobs to the main thread's queue, where workers steal them.
+    if (!push(m_threads[std::max(t_thread, 0)]->queue, job)) {
+        execute(job, t_thread);
+        return;
+    }
+    m_queued.fetch_add(1, std::memory_order_release);
+    wake(1);
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    const int thread = t_thread;
+    while (!counter.done()) {
+        if (thread == 0 && runMainThreadJob()) continue;
+        if (runOne(thread)) continue;
+        std::this_thread::yield();
+    }
+}
+
+void JobSystem::runMainThreadJobs() {
+    while (runMainThreadJob()) {
+    }
+}
+
+void JobSystem::parallelFor(const char* name, int count, int grain, JobFunction function, void* context) {
+    if (count <= 0) return;
+    grain = std::max(grain, 1);
+    const int chunks = (count + grain - 1) / grain;
+    if (chunks == 1 || m_threads.empty()) {
+        execute({ name, function, context, nullptr, 0, count }, t_thread);
+        return;
+    }
+
+    // Pushed last to first: the caller pops its own queue from the back and so works front to
+    // back, while thieves take the far end.
+    JobCounter counter;
+    counter.m_pending.store(chunks - 1, std::memory_order_relaxed);
+    Queue& queue = m_threads[std::max(t_thread, 0)]->queue;
+    int pushed = 0;
+    for (int chunk = chunks - 1; chunk >= 1; --chunk) {
+        Job job{ name, function, context, &counter, chunk * grain, std::min((chunk + 1) * grain, count) };
+        if (push(queue, job)) {
+            pushed++;
+        } else {
+            execute(job, t_thread);
+        }
+    }
+    m_queued.fetch_add(pushed, std::memory_order_release);
+    wake(pushed);
+
+    execute({ name, function, context, nullptr, 0, std::min(grain, count) }, t_thread);
+    wait(counter);
+}
+
+bool JobSystem::push(Queue& queue, const Job& job) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.size == kQueueCapacity) return false;
+    queue.jobs[(queue.head + queue.size) % kQueueCapacity] = job;
+    queue.size++;
+    return true;
+}
+
+bool JobSystem::popOwn(int thread, Job& job) {
+    Queue& queue = m_threads[thread]->queue;
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.size == 0) return false;
+    queue.size--;
+    job = queue.jobs[(queue.head + queue.size) % kQueueCapacity];
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool JobSystem::steal(int thief, Job& job) {
+    const int threadCount = static_cast<int>(m_threads.size());
+    // Start past the thief so workers spread over different victims.
+    for (int i = 1; i <= threadCount; ++i) {
+        int victim = (std::max(thief, 0) + i) % threadCount;
+        if (victim == thief) continue;
+        Queue& queue = m_threads[victim]->queue;
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.size == 0) continue;
+        job = queue.jobs[queue.head];
+        queue.head = (queue.head + 1) % kQueueCapacity;
+        queue.size--;
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::runOne(int thread) {
+    if (m_threads.empty()) return false;
+    Job job;
+    if (thread >= 0 && popOwn(thread, job)) {
+        execute(job, thread);
+        return true;
+    }
+    if (steal(thread, job)) {
+        if (thread >= 0) m_threads[thread]->jobsStolen.fetch_add(1, std::memory_order_relaxed);
+        execute(job, thread);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::pushMainThreadJob(const Job& job) {
+    while (!push(m_mainJobs, job)) {
+        // Full: the main thread makes room by running one, anyone else waits for it to.
+        if (isMainThread()) {
+            runMainThreadJob();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::runMainThreadJob() {
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(m_mainJobs.mutex);
+        if (m_mainJobs.size == 0) return false;
+        job = m_mainJobs.jobs[m_mainJobs.head];
+        m_mainJobs.head = (m_mainJobs.head + 1) % kQueueCapacity;
+        m_mainJobs.size--;
+    }
+    execute(job, 0);
+    return true;
+}
+
+void JobSystem::execute(const Job& job, int thread) {
+    const bool tracing = thread >= 0 && m_tracing.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+
+    job.function(job.context, job.begin, job.end);
+
+    if (thread >= 0 && thread < static_cast<int>(m_threads.size())) {
+        ThreadState& state = *m_threads[thread];
+        state.jobsRun.fetch_add(1, std::memory_order_relaxed);
+        // Never grows past what start() reserved.
+        if (tracing && state.trace.size() < state.trace.capacity()) {
+            auto end = std::chrono::steady_clock::now();
+            state.trace.push_back({ job.name, std::chrono::duration_cast<std::chrono::nanoseconds>(start - m_epoch).count(),
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() });
+        }
+    }
+    if (job.counter) job.counter->m_pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::wake(int jobs) {
+    if (jobs <= 0) return;
+    // Taking the lock orders this against a worker that has just found nothing and is about to sleep.
+    { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+    if (jobs == 1) {
+        m_wake.notify_one();
+    } else {
+        m_wake.notify_all();
+    }
+}
+
+void JobSystem::workerLoop(int thread) {
+    t_thread = thread;
+    while (true) {
+        if (runOne(thread)) continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this] { return m_quit || m_queued.load(std::memory_order_acquire) > 0; });
+        if (m_quit) break;
+    }
+}
+
+void JobSystem::setTracing(bool enabled) {
+    m_tracing.store(enabled, std::memory_order_relaxed);
+}
+
+bool JobSystem::writeTimeline(const char* path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Failed to write job timeline: " << path << std::endl;
+        return false;
+    }
+    size_t events = 0;
+    out << "{\"traceEvents\":[\n";
+    for (size_t thread = 0; thread < m_threads.size(); ++thread) {
+        if (thread > 0) out << ",\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread << ",\"args\":{\"name\":\""
+            << (thread == 0 ? "main" : "worker ") << (thread == 0 ? "" : std::to_string(thread)) << "\"}}";
+        for (const TraceEvent& event : m_threads[thread]->trace) {
+            out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+                << ",\"ts\":" << event.startNs / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+            events++;
+        }
+    }
+    out << "\n]}\n";
+    std::cout << "Job timeline written: " << path << " (" << events << " jobs)" << std::endl;
+    return true;
+}
+
+void JobSystem::printStats() const {
+    if (m_threads.empty()) return;
+    uint64_t run = 0, stolen = 0;
+    for (const auto& state : m_threads) {
+        run += state->jobsRun.load(std::memory_order_relaxed);
+        stolen += state->jobsStolen.load(std::memory_order_relaxed);
+    }
+    std::cout << "Job system: " << run << " jobs on " << m_threads.size() << " threads, " << stolen
+              << " stolen, " << m_threads[0]->jobsRun.load(std::memory_order_relaxed) << " run by the main thread" << std::endl;
+}
+
+
+TaskGraph::TaskId TaskGraph::add(const char* name, std::function<void()> task, JobAffinity affinity) {
+    Task& entry = m_tasks.emplace_back();
+    entry.name = name;
+    entry.function = std::move(task);
+    entry.affinity = affinity;
+    entry.graph = this;
+    return static_cast<TaskId>(m_tasks.size() - 1);
+}
+
+void TaskGraph::precede(TaskId before, TaskId after) {
+    m_tasks[before].successors.push_back(after);
+    m_tasks[after].dependencies++;
+}
+
+void TaskGraph::run() {
+    for (Task& task : m_tasks) {
+        task.remaining.store(task.dependencies, std::memory_order_relaxed);
+    }
+    for (Task& task : m_tasks) {
+        if (task.dependencies == 0) submit(task);
+    }
+}
+
+void TaskGraph::wait() {
+    JobSystem::instance().wait(m_counter);
+}
+
+void TaskGraph::submit(Task& task) {
+    JobSystem::instance().submit(task.name, &TaskGraph::runTask, &task, &m_counter, task.affinity);
+}
+
+void TaskGraph::runTask(void* context, int, int) {
+    Task& task = *static_cast<Task*>(context);
+    task.function();
+    // Successors are submitted before this task counts as finished, so the graph's counter
+    // cannot reach zero while any of them is still to come.
+    for (TaskId id : task.successors) {
+        Task& next = task.graph->m_tasks[id];
+        if (next.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            task.graph->submit(next);
+        }
+    }
+}
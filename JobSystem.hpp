@@ -0,0 +1,189 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs a job's function on [begin, end); context is whatever the submitter passed along.
+using JobFunction = void (*)(void* context, int begin, int end);
+
+enum class JobAffinity : uint8_t {
+    Any,        // any worker, or a thread that is waiting
+    MainThread, // only the thread that owns the GL context
+};
+
+// Number of jobs submitted against it that have not finished yet.
+class JobCounter {
+public:
+    bool done() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> m_pending{ 0 };
+};
+
+// Work-stealing job system shared by load-time and per-frame work.
+//
+// Every thread, the main thread included, owns a fixed-size deque: it pushes and pops its own
+// jobs at the back, newest first, while idle workers steal from the front of the others'.
+// Waiting on a JobCounter never blocks outright; the waiter runs queued jobs until the counter
+// drains, so nested parallelFor() calls and jobs waiting on other jobs cannot deadlock.
+// Jobs with MainThread affinity go to a separate queue that only the main thread runs, from
+// wait() or runMainThreadJobs(), since it alone may make GL calls.
+//
+// Submitting does not allocate: jobs are a function pointer, a context pointer and a range,
+// and a full deque runs the job inline instead of growing. That keeps per-frame use inside
+// the render loop's no-heap rule.
+//
+// With tracing on, every job's start and duration is recorded per thread into preallocated
+// buffers; writeTimeline() dumps them in the Chrome trace event format (chrome://tracing or
+// ui.perfetto.dev).
+class JobSystem {
+public:
+    static JobSystem& instance();
+
+    // Starts the workers; call once from the main thread before anything is submitted.
+    // workerCount 0 picks one less than the hardware concurrency.
+    void start(int workerCount = 0);
+    // Joins the workers. Everything submitted must have been waited on.
+    void stop();
+
+    int workerCount() const { return static_cast<int>(m_workers.size()); }
+    // Workers plus the main thread, which runs jobs while it waits.
+    int threadCount() const { return workerCount() + 1; }
+    bool isMainThread() const;
+
+    // counter may be null for fire-and-forget jobs; context must outlive the job either way.
+    void submit(const char* name, JobFunction function, void* context, JobCounter* counter,
+                JobAffinity affinity = JobAffinity::Any, int begin = 0, int end = 0);
+    // Runs queued jobs until every job submitted against counter has finished.
+    void wait(JobCounter& counter);
+    // Runs the main-thread jobs queued so far. Main thread only.
+    void runMainThreadJobs();
+
+    // Splits [0, count) into ranges of at most grain items and runs fn on them across all
+    // threads, the caller included. Returns once every range is done.
+    void parallelFor(const char* name, int count, int grain, JobFunction function, void* context);
+    // fn(begin, end) may be any callable; it is only referenced, never copied.
+    template <typename Fn>
+    void parallelFor(const char* name, int count, int grain, const Fn& fn) {
+        parallelFor(name, count, grain, [](void* context, int begin, int end) {
+            (*static_cast<const Fn*>(context))(begin, end);
+        }, const_cast<Fn*>(&fn));
+    }
+
+    // Trace buffers are reserved by start(), so tracing has to be enabled before it.
+    void setTracing(bool enabled);
+    bool isTracing() const { return m_tracing.load(std::memory_order_relaxed); }
+    // Writes the recorded jobs as a Chrome trace JSON file.
+    bool writeTimeline(const char* path) const;
+    void printStats() const;
+
+private:
+    static constexpr int kQueueCapacity = 1024;         // per thread; a full queue runs jobs inline
+    static constexpr size_t kTraceCapacity = 1 << 16;   // events per thread; later ones are dropped
+
+    struct Job {
+        const char* name;
+        JobFunction function;
+        void* context;
+        JobCounter* counter;
+        int begin, end;
+    };
+
+    // Ring buffer; the owner works the back, thieves take the front.
+    struct Queue {
+        std::mutex mutex;
+        Job jobs[kQueueCapacity];
+        uint32_t head = 0;
+        uint32_t size = 0;
+    };
+
+    struct TraceEvent {
+        const char* name;
+        int64_t startNs; // since m_epoch
+        int64_t durationNs;
+    };
+
+    struct ThreadState {
+        Queue queue;
+        std::vector<TraceEvent> trace; // reserved up front
+        // Written by the owning thread, read by printStats() while workers may still run.
+        std::atomic<uint64_t> jobsRun{ 0 };
+        std::atomic<uint64_t> jobsStolen{ 0 };
+    };
+
+    JobSystem() = default;
+    ~JobSystem();
+
+    // Index 0 is the main thread, then one per worker.
+    std::vector<std::unique_ptr<ThreadState>> m_threads;
+    std::vector<std::thread> m_workers;
+    Queue m_mainJobs; // first in, first out
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<int> m_queued{ 0 }; // jobs sitting in the thread queues
+    std::atomic<bool> m_quit{ false };
+    std::atomic<bool> m_tracing{ false };
+    std::chrono::steady_clock::time_point m_epoch = std::chrono::steady_clock::now();
+
+    static bool push(Queue& queue, const Job& job);
+    bool popOwn(int thread, Job& job);
+    bool steal(int thief, Job& job);
+    bool runOne(int thread);
+    void pushMainThreadJob(const Job& job);
+    bool runMainThreadJob();
+    void execute(const Job& job, int thread);
+    void wake(int jobs);
+    void workerLoop(int thread);
+};
+
+// Dependency-aware group of tasks: each runs once every task it depends on has finished.
+// Tasks may call GL only with MainThread affinity. Building a graph allocates; running it
+// adds nothing beyond the submits.
+class TaskGraph {
+public:
+    using TaskId = int;
+
+    TaskGraph() = default;
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // name must outlive the graph's timeline; string literals do.
+    TaskId add(const char* name, std::function<void()> task, JobAffinity affinity = JobAffinity::Any);
+    // after starts only once before has finished.
+    void precede(TaskId before, TaskId after);
+
+    // Submits every task that has no dependencies and returns.
+    void run();
+    // Helps run the graph until every task has finished. Call from the main thread if any
+    // task has MainThread affinity.
+    void wait();
+
+private:
+    struct Task {
+        const char* name;
+        std::function<void()> function;
+        JobAffinity affinity;
+        std::vector<TaskId> successors;
+        int dependencies = 0;
+        std::atomic<int> remaining{ 0 };
+        TaskGraph* graph = nullptr;
+    };
+
+    std::deque<Task> m_tasks; // stable addresses; jobs point into it
+    JobCounter m_counter;
+
+    void submit(Task& task);
+    static void runTask(void* context, int begin, int end);
+};
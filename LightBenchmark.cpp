@@ -0,0 +1,84 @@
+#include "LightBenchmark.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+LightBenchmark::LightBenchmark(std::vector<uint32_t> lightCounts, uint32_t warmupFrames, uint32_t measuredFrames)
+    : m_warmupFrames(warmupFrames), m_measuredFrames(std::max(measuredFrames, 1u))
+{
+    for (uint32_t lights : lightCounts) {
+        Step step;
+        step.lights = lights;
+        step.frameMs.reserve(m_measuredFrames);
+        m_steps.push_back(std::move(step));
+    }
+}
+
+bool LightBenchmark::recordFrame(double frameMs, double clusterMs, double gpuMs) {
+    if (finished()) return false;
+
+    Step& step = m_steps[m_step];
+    if (m_frame++ >= m_warmupFrames) {
+        step.frameMs.push_back(static_cast<float>(frameMs));
+        step.clusterMs += clusterMs;
+        if (gpuMs > 0.0) {
+            step.gpuMs += gpuMs;
+            step.gpuSamples++;
+        }
+    }
+    if (step.frameMs.size() < m_measuredFrames) return false;
+
+    std::cout << "Light benchmark: " << step.lights << " lights done" << std::endl;
+    m_step++;
+    m_frame = 0;
+    return true;
+}
+
+double LightBenchmark::mean(const std::vector<float>& values) {
+    if (values.empty()) return 0.0;
+    double sum = 0.0;
+    for (float value : values) sum += value;
+    return sum / values.size();
+}
+
+double LightBenchmark::percentile(std::vector<float> values, double fraction) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void LightBenchmark::printResults() const {
+    std::cout << "Light benchmark (" << m_measuredFrames << " frames per step):" << std::endl
+              << "  lights   frame ms   p95 ms   cluster ms   gpu ms" << std::endl
+              << std::fixed << std::setprecision(3);
+    for (const Step& step : m_steps) {
+        if (step.frameMs.empty()) continue;
+        size_t frames = step.frameMs.size();
+        std::cout << "  " << std::setw(6) << step.lights
+                  << std::setw(11) << mean(step.frameMs)
+                  << std::setw(9) << percentile(step.frameMs, 0.95)
+                  << std::setw(13) << (step.clusterMs / frames)
+                  << std::setw(9) << (step.gpuSamples ? step.gpuMs / step.gpuSamples : 0.0) << std::endl;
+    }
+    std::cout.unsetf(std::ios::fixed);
+}
+
+bool LightBenchmark::writeCsv(const char* path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Failed to write light benchmark: " << path << std::endl;
+        return false;
+    }
+    out << "lights,frames,frame_ms,frame_ms_p95,cluster_ms,gpu_ms\n";
+    for (const Step& step : m_steps) {
+        if (step.frameMs.empty()) continue;
+        size_t frames = step.frameMs.size();
+        out << step.lights << ',' << frames << ',' << mean(step.frameMs) << ',' << percentile(step.frameMs, 0.95) << ','
+            << (step.clusterMs / frames) << ',' << (step.gpuSamples ? step.gpuMs / step.gpuSamples : 0.0) << '\n';
+    }
+    std::cout << "Light benchmark written: " << path << std::endl;
+    return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Steps the scene through a list of light counts and measures frame time at each one:
+// warmupFrames are skipped after every change (GPU timer results lag a few frames), then
+// measuredFrames are averaged. Drive it from the frame loop with recordFrame().
+class LightBenchmark {
+public:
+    LightBenchmark(std::vector<uint32_t> lightCounts, uint32_t warmupFrames = 60, uint32_t measuredFrames = 240);
+
+    bool finished() const { return m_step >= m_steps.size(); }
+    // Light count the current frame should be rendered with.
+    uint32_t lightCount() const { return finished() ? 0 : m_steps[m_step].lights; }
+
+    // Records one frame. Returns true when the benchmark moved to the next light count (or finished).
+    bool recordFrame(double frameMs, double clusterMs, double gpuMs);
+
+    void printResults() const;
+    bool writeCsv(const char* path) const;
+
+private:
+    struct Step {
+        uint32_t lights = 0;
+        double clusterMs = 0.0; // summed over the measured frames
+        double gpuMs = 0.0;
+        uint32_t gpuSamples = 0;
+        std::vector<float> frameMs; // one entry per measured frame, preallocated
+    };
+
+    std::vector<Step> m_steps;
+    uint32_t m_warmupFrames;
+    uint32_t m_measuredFrames;
+    size_t m_step = 0;
+    uint32_t m_frame = 0; // within the current step, warm-up included
+
+    static double mean(const std::vector<float>& values);
+    static double percentile(std::vector<float> values, double fraction);
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Procedural primitives evaluated at compile time.
+// Every generator returns a MeshData with fixed-size vertex and 16-bit index arrays, so
+//   static constexpr auto kHub = mesh::cylinder<mesh::PosColorUV, 12>(0.5f, 1.0f, color);
+// lives in read-only static storage and can be uploaded without touching the heap.
+// All primitives are centered on the origin and wound counter-clockwise seen from outside.
+namespace mesh {
+
+struct Vec2 { float x, y; };
+struct Vec3 { float x, y, z; };
+
+constexpr float kPi = 3.14159265358979f;
+
+namespace detail {
+
+constexpr Vec3 add(Vec3 a, Vec3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+constexpr Vec3 mul(Vec3 a, Vec3 b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+constexpr Vec3 mul(Vec3 a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+
+constexpr float sqrt(float x) {
+    if (x <= 0.0f) return 0.0f;
+    float r = x > 1.0f ? x : 1.0f;
+    for (int i = 0; i < 24; ++i) r = 0.5f * (r + x / r);
+    return r;
+}
+
+constexpr float sin(float x) {
+    while (x > kPi) x -= 2.0f * kPi;
+    while (x < -kPi) x += 2.0f * kPi;
+    float term = x;
+    float sum = x;
+    for (int i = 1; i < 10; ++i) {
+        term *= -x * x / ((2.0f * i) * (2.0f * i + 1.0f));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr float cos(float x) { return sin(x + 0.5f * kPi); }
+
+} // namespace detail
+
+// --- Vertex formats ---
+
+struct PosColorUV {
+    float position[3];
+    float color[3];
+    float uv[2];
+};
+
+struct PosNormalUV {
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+struct PosNormalColor {
+    float position[3];
+    float normal[3];
+    float color[3];
+};
+
+struct VertexAttribute {
+    unsigned location;
+    int components;
+    size_t offset;
+};
+
+// Maps generator output onto a vertex format and describes its float attributes.
+template <typename V>
+struct VertexFormat;
+
+template <>
+struct VertexFormat<PosColorUV> {
+    static constexpr PosColorUV make(Vec3 p, Vec3 /*normal*/, Vec3 color, Vec2 uv) {
+        return { { p.x, p.y, p.z }, { color.x, color.y, color.z }, { uv.x, uv.y } };
+    }
+    static constexpr std::array<VertexAttribute, 3> attributes = { {
+        { 0, 3, offsetof(PosColorUV, position) },
+        { 1, 3, offsetof(PosColorUV, color) },
+        { 2, 2, offsetof(PosColorUV, uv) },
+    } };
+};
+
+template <>
+struct VertexFormat<PosNormalUV> {
+    static constexpr PosNormalUV make(Vec3 p, Vec3 normal, Vec3 /*color*/, Vec2 uv) {
+        return { { p.x, p.y, p.z }, { normal.x, normal.y, normal.z }, { uv.x, uv.y } };
+    }
+    static constexpr std::array<VertexAttribute, 3> attributes = { {
+        { 0, 3, offsetof(PosNormalUV, position) },
+        { 1, 3, offsetof(PosNormalUV, normal) },
+        { 2, 2, offsetof(PosNormalUV, uv) },
+    } };
+};
+
+template <>
+struct VertexFormat<PosNormalColor> {
+    static constexpr PosNormalColor make(Vec3 p, Vec3 normal, Vec3 color, Vec2 /*uv*/) {
+        return { { p.x, p.y, p.z }, { normal.x, normal.y, normal.z }, { color.x, color.y, color.z } };
+    }
+    static constexpr std::array<VertexAttribute, 3> attributes = { {
+        { 0, 3, offsetof(PosNormalColor, position) },
+        { 1, 3, offsetof(PosNormalColor, normal) },
+        { 2, 3, offsetof(PosNormalColor, color) },
+    } };
+};
+
+// --- Mesh storage ---
+
+template <typename V, size_t NV, size_t NI>
+struct MeshData {
+    static_assert(NV <= 65536, "MeshData uses 16-bit indices");
+
+    using Vertex = V;
+    static constexpr size_t kVertexCount = NV;
+    static constexpr size_t kIndexCount = NI;
+
+    std::array<V, NV> vertices{};
+    std::array<uint16_t, NI> indices{};
+};
+
+namespace detail {
+
+// Fills a MeshData in order; overrunning either array fails constant evaluation.
+template <typename V, size_t NV, size_t NI>
+struct Builder {
+    MeshData<V, NV, NI> mesh{};
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+
+    constexpr uint16_t vertex(Vec3 p, Vec3 normal, Vec3 color, Vec2 uv) {
+        mesh.vertices[vertexCount] = VertexFormat<V>::make(p, normal, color, uv);
+        return static_cast<uint16_t>(vertexCount++);
+    }
+    constexpr void triangle(uint16_t a, uint16_t b, uint16_t c) {
+        mesh.indices[indexCount++] = a;
+        mesh.indices[indexCount++] = b;
+        mesh.indices[indexCount++] = c;
+    }
+    constexpr void quad(uint16_t a, uint16_t b, uint16_t c, uint16_t d) {
+        triangle(a, b, c);
+        triangle(a, c, d);
+    }
+    constexpr MeshData<V, NV, NI> finish() const {
+        // Every slot must have been written exactly once.
+        if (vertexCount != NV || indexCount != NI) throw "mesh generator size mismatch";
+        return mesh;
+    }
+};
+
+} // namespace detail
+
+// --- Primitives ---
+
+struct BoxDesc {
+    Vec3 size;
+    Vec3 color;
+    Vec2 sideUV;   // texture repeats across each side face (u along the face, v up)
+    Vec2 bottomUV;
+    Vec2 topUV;
+};
+
+// Box with one quad per face, so each face gets its own normal and UV scale.
+template <typename V>
+constexpr MeshData<V, 24, 36> box(const BoxDesc& desc) {
+    struct Face { Vec3 n, u, v; Vec2 uvScale; };
+    const Face faces[6] = {
+        { { 0, 0, -1 }, { -1, 0, 0 }, { 0, 1, 0 }, desc.sideUV },
+        { { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 }, desc.sideUV },
+        { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 }, desc.sideUV },
+        { { 1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 }, desc.sideUV },
+        { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 }, desc.bottomUV },
+        { { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, -1 }, desc.topUV },
+    };
+    const Vec3 half = detail::mul(desc.size, 0.5f);
+
+    detail::Builder<V, 24, 36> b;
+    for (const Face& f : faces) {
+        uint16_t corner[4] = {};
+        const float s[4] = { -1, 1, 1, -1 };
+        const float t[4] = { -1, -1, 1, 1 };
+        for (int i = 0; i < 4; ++i) {
+            Vec3 p = detail::mul(detail::add(f.n, detail::add(detail::mul(f.u, s[i]), detail::mul(f.v, t[i]))), half);
+            Vec2 uv = { (s[i] + 1.0f) * 0.5f * f.uvScale.x, (t[i] + 1.0f) * 0.5f * f.uvScale.y };
+            corner[i] = b.vertex(p, f.n, desc.color, uv);
+        }
+        b.quad(corner[0], corner[1], corner[2], corner[3]);
+    }
+    return b.finish();
+}
+
+// Triangular prism (gable roof): the triangle lies in XY with its apex up and is extruded along Z.
+template <typename V>
+constexpr MeshData<V, 18, 24> prism(float width, float height, float depth, Vec3 color) {
+    const float hw = width * 0.5f, hh = height * 0.5f, hd = depth * 0.5f;
+    const Vec3 left = { -hw, -hh, 0 }, right = { hw, -hh, 0 }, apex = { 0, hh, 0 };
+    const float slope = detail::sqrt(hw * hw + height * height);
+    const Vec3 leftNormal = { -height / slope, hw / slope, 0 };
+    const Vec3 rightNormal = { height / slope, hw / slope, 0 };
+
+    detail::Builder<V, 18, 24> b;
+    auto at = [&](Vec3 p, float z) { return Vec3{ p.x, p.y, z }; };
+
+    // Caps
+    uint16_t f0 = b.vertex(at(left, hd), { 0, 0, 1 }, color, { 0, 0 });
+    uint16_t f1 = b.vertex(at(right, hd), { 0, 0, 1 }, color, { 1, 0 });
+    uint16_t f2 = b.vertex(at(apex, hd), { 0, 0, 1 }, color, { 0.5f, 1 });
+    b.triangle(f0, f1, f2);
+    uint16_t k0 = b.vertex(at(right, -hd), { 0, 0, -1 }, color, { 0, 0 });
+    uint16_t k1 = b.vertex(at(left, -hd), { 0, 0, -1 }, color, { 1, 0 });
+    uint16_t k2 = b.vertex(at(apex, -hd), { 0, 0, -1 }, color, { 0.5f, 1 });
+    b.triangle(k0, k1, k2);
+
+    // Bottom, then the two slopes
+    struct Side { Vec3 a, c; Vec3 n; };
+    const Side sides[3] = { { left, right, { 0, -1, 0 } }, { right, apex, rightNormal }, { apex, left, leftNormal } };
+    for (const Side& side : sides) {
+        uint16_t a = b.vertex(at(side.a, hd), side.n, color, { 0, 0 });
+        uint16_t c = b.vertex(at(side.a, -hd), side.n, color, { 0, 1 });
+        uint16_t d = b.vertex(at(side.c, -hd), side.n, color, { 1, 1 });
+        uint16_t e = b.vertex(at(side.c, hd), side.n, color, { 1, 0 });
+        b.quad(a, c, d, e);
+    }
+    return b.finish();
+}
+
+// Capped cylinder along Y.
+template <typename V, int Segments>
+constexpr MeshData<V, 4 * (Segments + 1), 12 * Segments> cylinder(float radius, float height, Vec3 color) {
+    static_assert(Segments >= 3, "cylinder needs at least 3 segments");
+    const float hh = height * 0.5f;
+    detail::Builder<V, 4 * (Segments + 1), 12 * Segments> b;
+
+    // Side: one extra column so the seam gets u = 1.
+    for (int i = 0; i <= Segments; ++i) {
+        float a = 2.0f * kPi * i / Segments;
+        Vec3 n = { detail::cos(a), 0, -detail::sin(a) };
+        float u = static_cast<float>(i) / Segments;
+        b.vertex({ n.x * radius, -hh, n.z * radius }, n, color, { u, 0 });
+        b.vertex({ n.x * radius, hh, n.z * radius }, n, color, { u, 1 });
+    }
+    for (int i = 0; i < Segments; ++i) {
+        uint16_t base = static_cast<uint16_t>(2 * i);
+        b.quad(base, base + 2, base + 3, base + 1);
+    }
+
+    // Caps
+    for (int cap = 0; cap < 2; ++cap) {
+        float y = cap ? hh : -hh;
+        Vec3 n = { 0, cap ? 1.0f : -1.0f, 0 };
+        uint16_t center = b.vertex({ 0, y, 0 }, n, color, { 0.5f, 0.5f });
+        for (int i = 0; i < Segments; ++i) {
+            float a = 2.0f * kPi * i / Segments;
+            float c = detail::cos(a), s = -detail::sin(a);
+            b.vertex({ c * radius, y, s * radius }, n, color, { 0.5f + 0.5f * c, 0.5f + 0.5f * s });
+        }
+        for (int i = 0; i < Segments; ++i) {
+            uint16_t r0 = static_cast<uint16_t>(center + 1 + i);
+            uint16_t r1 = static_cast<uint16_t>(center + 1 + (i + 1) % Segments);
+            if (cap) b.triangle(center, r0, r1);
+            else b.triangle(center, r1, r0);
+        }
+    }
+    return b.finish();
+}
+
+// Cone along Y with its apex up and a capped base.
+template <typename V, int Segments>
+constexpr MeshData<V, 3 * Segments + 2, 6 * Segments> cone(float radius, float height, Vec3 color) {
+    static_assert(Segments >= 3, "cone needs at least 3 segments");
+    const float hh = height * 0.5f;
+    const float slope = detail::sqrt(radius * radius + height * height);
+    detail::Builder<V, 3 * Segments + 2, 6 * Segments> b;
+
+    // Side: ring with a seam column, plus one apex vertex per segment for smooth normals.
+    for (int i = 0; i <= Segments; ++i) {
+        float a = 2.0f * kPi * i / Segments;
+        float c = detail::cos(a), s = -detail::sin(a);
+        Vec3 n = { c * height / slope, radius / slope, s * height / slope };
+        b.vertex({ c * radius, -hh, s * radius }, n, color, { static_cast<float>(i) / Segments, 0 });
+    }
+    for (int i = 0; i < Segments; ++i) {
+        float a = 2.0f * kPi * (i + 0.5f) / Segments;
+        float c = detail::cos(a), s = -detail::sin(a);
+        Vec3 n = { c * height / slope, radius / slope, s * height / slope };
+        uint16_t apex = b.vertex({ 0, hh, 0 }, n, color, { (i + 0.5f) / Segments, 1 });
+        b.triangle(static_cast<uint16_t>(i), static_cast<uint16_t>(i + 1), apex);
+    }
+
+    // Base
+    uint16_t center = b.vertex({ 0, -hh, 0 }, { 0, -1, 0 }, color, { 0.5f, 0.5f });
+    for (int i = 0; i < Segments; ++i) {
+        float a = 2.0f * kPi * i / Segments;
+        float c = detail::cos(a), s = -detail::sin(a);
+        b.vertex({ c * radius, -hh, s * radius }, { 0, -1, 0 }, color, { 0.5f + 0.5f * c, 0.5f + 0.5f * s });
+    }
+    for (int i = 0; i < Segments; ++i) {
+        b.triangle(center, static_cast<uint16_t>(center + 1 + (i + 1) % Segments), static_cast<uint16_t>(center + 1 + i));
+    }
+    return b.finish();
+}
+
+// Flat disc in the XY plane facing +Z.
+template <typename V, int Segments>
+constexpr MeshData<V, Segments + 1, 3 * Segments> fan(float radius, Vec3 color) {
+    static_assert(Segments >= 3, "fan needs at least 3 segments");
+    detail::Builder<V, Segments + 1, 3 * Segments> b;
+
+    uint16_t center = b.vertex({ 0, 0, 0 }, { 0, 0, 1 }, color, { 0.5f, 0.5f });
+    for (int i = 0; i < Segments; ++i) {
+        float a = 2.0f * kPi * i / Segments;
+        float c = detail::cos(a), s = detail::sin(a);
+        b.vertex({ c * radius, s * radius, 0 }, { 0, 0, 1 }, color, { 0.5f + 0.5f * c, 0.5f + 0.5f * s });
+    }
+    for (int i = 0; i < Segments; ++i) {
+        b.triangle(center, static_cast<uint16_t>(center + 1 + i), static_cast<uint16_t>(center + 1 + (i + 1) % Segments));
+    }
+    return b.finish();
+}
+
+// Flat blade in the XY plane facing +Z, centered on the origin and running along Y.
+template <typename V>
+constexpr MeshData<V, 4, 6> blade(float width, float length, Vec3 color) {
+    const float hw = width * 0.5f, hl = length * 0.5f;
+    detail::Builder<V, 4, 6> b;
+    uint16_t a = b.vertex({ -hw, -hl, 0 }, { 0, 0, 1 }, color, { 0, 0 });
+    uint16_t c = b.vertex({ hw, -hl, 0 }, { 0, 0, 1 }, color, { 1, 0 });
+    uint16_t d = b.vertex({ hw, hl, 0 }, { 0, 0, 1 }, color, { 1, 1 });
+    uint16_t e = b.vertex({ -hw, hl, 0 }, { 0, 0, 1 }, color, { 0, 1 });
+    b.quad(a, c, d, e);
+    return b.finish();
+}
+
+} // namespace mesh
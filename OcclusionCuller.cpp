@@ -0,0 +1,262 @@
+#include "OcclusionCuller.hpp"
+#include "Heightfield.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define OCCLUSION_USE_SSE2 1
+#endif
+
+OcclusionCuller::OcclusionCuller() {
+    // Allocate every pyramid level up front so the worker never touches the heap.
+    for (int w = kWidth, h = kHeight; w >= 1 && h >= 1; w /= 2, h /= 2) {
+        m_hiZ.emplace_back(static_cast<size_t>(w) * h, 1.0f);
+    }
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    JobSystem::instance().wait(m_raster);
+}
+
+void OcclusionCuller::setOccluder(const Heightfield& heightfield, int step) {
+    JobSystem::instance().wait(m_raster);
+
+    heightfield.buildConservativeMesh(step, m_occluderPositions, m_occluderIndices);
+    m_clipVertices.resize(m_occluderPositions.size());
+    m_enabled = !m_occluderIndices.empty();
+    std::cout << "Occluder mesh built: " << m_occluderPositions.size() << " vertices, "
+              << m_occluderIndices.size() / 3 << " triangles (step " << step << ")" << std::endl;
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& viewProjection) {
+    if (!m_enabled) return;
+
+    JobSystem::instance().wait(m_raster);
+    m_viewProjection = viewProjection;
+    m_frameStats.tested = 0;
+    m_frameStats.occluded = 0;
+    JobSystem::instance().submit("Occluder raster", &OcclusionCuller::rasterJob, this, &m_raster);
+}
+
+bool OcclusionCuller::isVisible(const AABB& box) {
+    if (!m_enabled) return true;
+
+    if (!m_raster.done()) JobSystem::instance().wait(m_raster);
+    m_frameStats.tested++;
+
+    float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+    float minDepth = 1.0f;
+    for (int i = 0; i < 8; ++i) {
+        glm::vec4 clip = m_viewProjection * glm::vec4(box.corner(i), 1.0f);
+        // Any corner in front of the near plane means the box straddles the camera.
+        if (clip.w <= 1e-5f || clip.z < -clip.w) return true;
+
+        float invW = 1.0f / clip.w;
+        float x = clip.x * invW;
+        float y = clip.y * invW;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minDepth = std::min(minDepth, clip.z * invW * 0.5f + 0.5f);
+    }
+
+    // Off-screen boxes are left to frustum culling.
+    if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) return true;
+
+    int x0 = std::clamp(static_cast<int>(std::floor((minX * 0.5f + 0.5f) * kWidth)), 0, kWidth - 1);
+    int x1 = std::clamp(static_cast<int>(std::floor((maxX * 0.5f + 0.5f) * kWidth)), 0, kWidth - 1);
+    int y0 = std::clamp(static_cast<int>(std::floor((minY * 0.5f + 0.5f) * kHeight)), 0, kHeight - 1);
+    int y1 = std::clamp(static_cast<int>(std::floor((maxY * 0.5f + 0.5f) * kHeight)), 0, kHeight - 1);
+
+    // Pick the finest level where the box covers at most 4x4 texels.
+    int level = 0;
+    while (level + 1 < static_cast<int>(m_hiZ.size()) &&
+           ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3)) {
+        ++level;
+    }
+
+    const std::vector<float>& depth = m_hiZ[level];
+    int levelWidth = kWidth >> level;
+    for (int y = y0 >> level; y <= (y1 >> level); ++y) {
+        for (int x = x0 >> level; x <= (x1 >> level); ++x) {
+            if (depth[static_cast<size_t>(y) * levelWidth + x] >= minDepth) return true;
+        }
+    }
+
+    m_frameStats.occluded++;
+    return false;
+}
+
+void OcclusionCuller::endFrame() {
+    if (!m_enabled) return;
+
+    JobSystem::instance().wait(m_raster);
+    m_totalTested += m_frameStats.tested;
+    m_totalOccluded += m_frameStats.occluded;
+    m_totalRasterMs += m_frameStats.rasterMs;
+    m_frames++;
+}
+
+void OcclusionCuller::printStats() const {
+    if (m_frames == 0) return;
+
+    double occludedPercent = m_totalTested ? 100.0 * m_totalOccluded / m_totalTested : 0.0;
+    std::cout << std::fixed << std::setprecision(2)
+              << "Occlusion culling: " << occludedPercent << "% of " << m_totalTested << " tested objects occluded, "
+              << "avg raster " << (m_totalRasterMs / m_frames) << " ms/frame over " << m_frames << " frames" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
+
+void OcclusionCuller::rasterJob(void* context, int, int) {
+    OcclusionCuller& culler = *static_cast<OcclusionCuller*>(context);
+    auto start = std::chrono::steady_clock::now();
+    culler.rasterizeOccluder();
+    culler.buildHiZ();
+    auto end = std::chrono::steady_clock::now();
+    culler.m_frameStats.rasterMs = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void OcclusionCuller::rasterizeOccluder() {
+    std::fill(m_hiZ[0].begin(), m_hiZ[0].end(), 1.0f);
+    m_frameStats.trianglesRasterized = 0;
+
+    for (size_t i = 0; i < m_occluderPositions.size(); ++i) {
+        glm::vec4 clip = m_viewProjection * glm::vec4(m_occluderPositions[i], 1.0f);
+        m_clipVertices[i] = { clip.x, clip.y, clip.z, clip.w };
+    }
+
+    for (size_t i = 0; i + 2 < m_occluderIndices.size(); i += 3) {
+        const Vertex& a = m_clipVertices[m_occluderIndices[i]];
+        const Vertex& b = m_clipVertices[m_occluderIndices[i + 1]];
+        const Vertex& c = m_clipVertices[m_occluderIndices[i + 2]];
+
+        // Trivially reject triangles entirely outside one of the side or far planes.
+        if ((a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w) ||
+            (a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w) ||
+            (a.z > a.w && b.z > b.w && c.z > c.w)) {
+            continue;
+        }
+        clipAndRasterize(a, b, c);
+    }
+}
+
+void OcclusionCuller::clipAndRasterize(const Vertex& a, const Vertex& b, const Vertex& c) {
+    // Clip against the near plane (z >= -w); a triangle becomes at most a quad.
+    const Vertex in[3] = { a, b, c };
+    Vertex out[4];
+    int count = 0;
+    for (int i = 0; i < 3; ++i) {
+        const Vertex& p = in[i];
+        const Vertex& q = in[(i + 1) % 3];
+        float dp = p.z + p.w;
+        float dq = q.z + q.w;
+        if (dp >= 0.0f) out[count++] = p;
+        if ((dp >= 0.0f) != (dq >= 0.0f)) {
+            float t = dp / (dp - dq);
+            out[count++] = { p.x + (q.x - p.x) * t, p.y + (q.y - p.y) * t,
+                             p.z + (q.z - p.z) * t, p.w + (q.w - p.w) * t };
+        }
+    }
+    if (count < 3) return;
+
+    // Project to buffer pixels; z becomes the [0, 1] window depth.
+    for (int i = 0; i < count; ++i) {
+        float invW = 1.0f / std::max(out[i].w, 1e-6f);
+        out[i] = { (out[i].x * invW * 0.5f + 0.5f) * kWidth,
+                   (out[i].y * invW * 0.5f + 0.5f) * kHeight,
+                   out[i].z * invW * 0.5f + 0.5f, 1.0f };
+    }
+
+    rasterizeTriangle(out[0], out[1], out[2]);
+    if (count == 4) rasterizeTriangle(out[0], out[2], out[3]);
+}
+
+void OcclusionCuller::rasterizeTriangle(const Vertex& a, const Vertex& v1, const Vertex& v2) {
+    float area = (v1.x - a.x) * (v2.y - a.y) - (v1.y - a.y) * (v2.x - a.x);
+    if (std::fabs(area) < 1e-8f) return;
+
+    // Terrain is seen from both sides, so orient every triangle counter-clockwise instead of culling.
+    const Vertex& b = area > 0.0f ? v1 : v2;
+    const Vertex& c = area > 0.0f ? v2 : v1;
+    area = std::fabs(area);
+
+    int minX = std::max(0, static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))));
+    int maxX = std::min(kWidth - 1, static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))));
+    int minY = std::max(0, static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))));
+    int maxY = std::min(kHeight - 1, static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))));
+    if (minX > maxX || minY > maxY) return;
+    minX &= ~3; // rows are processed four pixels at a time
+
+    // Edge functions E(x, y) = A * x + B * y + C, positive inside. Each edge weights the opposite vertex.
+    float A0 = b.y - c.y, B0 = c.x - b.x, C0 = b.x * c.y - b.y * c.x;
+    float A1 = c.y - a.y, B1 = a.x - c.x, C1 = c.x * a.y - c.y * a.x;
+    float A2 = a.y - b.y, B2 = b.x - a.x, C2 = a.x * b.y - a.y * b.x;
+
+    // Depth is affine in screen space: Z(x, y) = ZA * x + ZB * y + ZC.
+    float invArea = 1.0f / area;
+    float ZA = (A0 * a.z + A1 * b.z + A2 * c.z) * invArea;
+    float ZB = (B0 * a.z + B1 * b.z + B2 * c.z) * invArea;
+    float ZC = (C0 * a.z + C1 * b.z + C2 * c.z) * invArea;
+
+    std::vector<float>& depth = m_hiZ[0];
+    m_frameStats.trianglesRasterized++;
+
+#ifdef OCCLUSION_USE_SSE2
+    const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 vA0 = _mm_set1_ps(A0), vA1 = _mm_set1_ps(A1), vA2 = _mm_set1_ps(A2), vZA = _mm_set1_ps(ZA);
+
+    for (int y = minY; y <= maxY; ++y) {
+        float fy = y + 0.5f;
+        float* row = depth.data() + static_cast<size_t>(y) * kWidth;
+        for (int x = minX; x <= maxX; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(vA0, px), _mm_set1_ps(B0 * fy + C0));
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(vA1, px), _mm_set1_ps(B1 * fy + C1));
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(vA2, px), _mm_set1_ps(B2 * fy + C2));
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+            if (_mm_movemask_ps(inside) == 0) continue;
+
+            __m128 z = _mm_add_ps(_mm_mul_ps(vZA, px), _mm_set1_ps(ZB * fy + ZC));
+            __m128 current = _mm_loadu_ps(row + x);
+            __m128 nearest = _mm_min_ps(current, z);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+        }
+    }
+#else
+    for (int y = minY; y <= maxY; ++y) {
+        float fy = y + 0.5f;
+        float* row = depth.data() + static_cast<size_t>(y) * kWidth;
+        for (int x = minX; x <= maxX; ++x) {
+            float fx = x + 0.5f;
+            if (A0 * fx + B0 * fy + C0 < 0.0f || A1 * fx + B1 * fy + C1 < 0.0f || A2 * fx + B2 * fy + C2 < 0.0f) continue;
+            row[x] = std::min(row[x], ZA * fx + ZB * fy + ZC);
+        }
+    }
+#endif
+}
+
+void OcclusionCuller::buildHiZ() {
+    for (size_t level = 1; level < m_hiZ.size(); ++level) {
+        const std::vector<float>& src = m_hiZ[level - 1];
+        std::vector<float>& dst = m_hiZ[level];
+        int srcWidth = kWidth >> (level - 1);
+        int dstWidth = kWidth >> level;
+        int dstHeight = kHeight >> level;
+        for (int y = 0; y < dstHeight; ++y) {
+            const float* r0 = src.data() + static_cast<size_t>(2 * y) * srcWidth;
+            const float* r1 = r0 + srcWidth;
+            for (int x = 0; x < dstWidth; ++x) {
+                dst[static_cast<size_t>(y) * dstWidth + x] =
+                    std::max(std::max(r0[2 * x], r0[2 * x + 1]), std::max(r1[2 * x], r1[2 * x + 1]));
+            }
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "JobSystem.hpp"
+
+class Heightfield;
+
+struct OcclusionStats {
+    uint32_t tested = 0;
+    uint32_t occluded = 0;
+    uint32_t trianglesRasterized = 0;
+    double rasterMs = 0.0;
+
+    float occludedPercent() const { return tested ? 100.0f * occluded / tested : 0.0f; }
+};
+
+// Software occlusion culling against the terrain.
+// A coarse, conservative terrain mesh is rasterized into a small depth buffer by a job while the
+// GPU is busy with the sky and terrain; bounding boxes are then tested against a max-depth
+// pyramid built from it before their draw calls are submitted.
+class OcclusionCuller {
+public:
+    static constexpr int kWidth = 256;
+    static constexpr int kHeight = 128;
+
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    // Builds the occluder mesh from the heightfield, one vertex every `step` texels.
+    void setOccluder(const Heightfield& heightfield, int step);
+
+    // Starts rasterizing the occluder for this frame's camera.
+    void beginFrame(const glm::mat4& viewProjection);
+    // Returns false if the box is entirely hidden behind the occluder. Waits for the rasterizer if needed.
+    bool isVisible(const AABB& box);
+    // Folds this frame's stats into the running totals.
+    void endFrame();
+
+    const OcclusionStats& frameStats() const { return m_frameStats; }
+    void printStats() const;
+
+private:
+    struct Vertex { float x, y, z, w; };
+
+    std::vector<glm::vec3> m_occluderPositions;
+    std::vector<uint32_t> m_occluderIndices;
+    std::vector<Vertex> m_clipVertices;
+
+    // Level 0 holds the per-pixel nearest occluder depth; each further level holds the
+    // farthest depth of the 2x2 block below it.
+    std::vector<std::vector<float>> m_hiZ;
+
+    glm::mat4 m_viewProjection = glm::mat4(1.0f);
+    bool m_enabled = false;
+    JobCounter m_raster; // this frame's rasterization, while it runs
+
+    OcclusionStats m_frameStats;
+    uint64_t m_totalTested = 0;
+    uint64_t m_totalOccluded = 0;
+    double m_totalRasterMs = 0.0;
+    uint32_t m_frames = 0;
+
+    static void rasterJob(void* context, int begin, int end);
+    void rasterizeOccluder();
+    void rasterizeTriangle(const Vertex& a, const Vertex& b, const Vertex& c);
+    void clipAndRasterize(const Vertex& a, const Vertex& b, const Vertex& c);
+    void buildHiZ();
+};
@@ -0,0 +1,464 @@
+#include "RenderGraph.hpp"
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+static bool isDepthFormat(GLenum format) {
+    return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F ||
+           format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+}
+
+// Pixel format and type glTexImage2D accepts alongside a sized internal format.
+static void uploadFormatFor(GLenum internalFormat, GLenum& format, GLenum& type) {
+    switch (internalFormat) {
+        case GL_DEPTH_COMPONENT16:
+        case GL_DEPTH_COMPONENT24:   format = GL_DEPTH_COMPONENT; type = GL_UNSIGNED_INT; break;
+        case GL_DEPTH_COMPONENT32F:  format = GL_DEPTH_COMPONENT; type = GL_FLOAT; break;
+        case GL_DEPTH24_STENCIL8:    format = GL_DEPTH_STENCIL; type = GL_UNSIGNED_INT_24_8; break;
+        case GL_DEPTH32F_STENCIL8:   format = GL_DEPTH_STENCIL; type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV; break;
+        case GL_R8: case GL_R16F: case GL_R32F:       format = GL_RED; type = GL_FLOAT; break;
+        case GL_RG8: case GL_RG16F: case GL_RG32F:    format = GL_RG; type = GL_FLOAT; break;
+        case GL_RGBA16F: case GL_RGBA32F:             format = GL_RGBA; type = GL_FLOAT; break;
+        default:                                      format = GL_RGBA; type = GL_UNSIGNED_BYTE; break;
+    }
+}
+
+static const char* formatName(GLenum format) {
+    switch (format) {
+        case GL_RGBA8:              return "RGBA8";
+        case GL_RGBA16F:            return "RGBA16F";
+        case GL_RGBA32F:            return "RGBA32F";
+        case GL_R8:                 return "R8";
+        case GL_R16F:               return "R16F";
+        case GL_R32F:               return "R32F";
+        case GL_RG16F:              return "RG16F";
+        case GL_DEPTH_COMPONENT24:  return "D24";
+        case GL_DEPTH_COMPONENT32F: return "D32F";
+        case GL_DEPTH24_STENCIL8:   return "D24S8";
+        default:                    return "other";
+    }
+}
+
+
+RenderGraphResource RenderGraph::PassBuilder::create(const char* name, const RenderTargetDesc& desc) {
+    Resource resource{};
+    resource.name = name;
+    resource.kind = ResourceKind::Transient;
+    resource.desc = desc;
+    return write(m_graph.addResource(resource));
+}
+
+RenderGraphResource RenderGraph::PassBuilder::read(RenderGraphResource resource) {
+    if (resource) m_graph.m_passes[m_pass].reads.push_back(resource.index);
+    return resource;
+}
+
+RenderGraphResource RenderGraph::PassBuilder::write(RenderGraphResource resource) {
+    if (resource) m_graph.m_passes[m_pass].writes.push_back(resource.index);
+    return resource;
+}
+
+void RenderGraph::PassBuilder::setSideEffect() {
+    m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+GLuint RenderGraph::PassContext::resource(RenderGraphResource resource) const {
+    const Resource& entry = m_graph.m_resources[resource.index];
+    if (entry.kind == ResourceKind::Transient) return m_graph.m_physical[entry.physical].texture.id();
+    return entry.object;
+}
+
+GLuint RenderGraph::PassContext::framebuffer(RenderGraphResource resource) const {
+    return m_graph.m_resources[resource.index].framebuffer;
+}
+
+int RenderGraph::PassContext::width(RenderGraphResource resource) const {
+    return m_graph.m_resources[resource.index].width;
+}
+
+int RenderGraph::PassContext::height(RenderGraphResource resource) const {
+    return m_graph.m_resources[resource.index].height;
+}
+
+
+RenderGraphResource RenderGraph::addResource(const Resource& resource) {
+    m_resources.push_back(resource);
+    m_dirty = true;
+    return RenderGraphResource{ static_cast<uint32_t>(m_resources.size() - 1) };
+}
+
+RenderGraphResource RenderGraph::importBackbuffer(const char* name) {
+    Resource resource{};
+    resource.name = name;
+    resource.kind = ResourceKind::Backbuffer;
+    return addResource(resource);
+}
+
+RenderGraphResource RenderGraph::importTexture(const char* name, GLuint texture, int width, int height,
+                                               GLenum format, GLuint framebuffer) {
+    Resource resource{};
+    resource.name = name;
+    resource.kind = ResourceKind::Texture;
+    resource.desc.format = format;
+    resource.object = texture;
+    resource.framebuffer = framebuffer;
+    resource.width = width;
+    resource.height = height;
+    return addResource(resource);
+}
+
+RenderGraphResource RenderGraph::importBuffer(const char* name, GLuint buffer) {
+    Resource resource{};
+    resource.name = name;
+    resource.kind = ResourceKind::Buffer;
+    resource.object = buffer;
+    return addResource(resource);
+}
+
+void RenderGraph::updateImport(RenderGraphResource resource, GLuint object, int width, int height, GLuint framebuffer) {
+    Resource& entry = m_resources[resource.index];
+    // Viewports follow the size, and framebuffers built around the old object are stale;
+    // an import's own framebuffer is looked up when its pass runs.
+    if (entry.width != width || entry.height != height || (entry.attached && entry.object != object)) {
+        m_dirty = true;
+    }
+    entry.object = object;
+    entry.width = width;
+    entry.height = height;
+    entry.framebuffer = framebuffer;
+}
+
+void RenderGraph::addPass(const char* name, const SetupFunction& setup, ExecuteFunction execute) {
+    m_passes.emplace_back();
+    m_passes.back().name = name;
+    m_passes.back().execute = std::move(execute);
+    PassBuilder builder(*this, static_cast<uint32_t>(m_passes.size() - 1));
+    setup(builder);
+    m_dirty = true;
+}
+
+void RenderGraph::setReferenceSize(int width, int height) {
+    width = std::max(width, 1);
+    height = std::max(height, 1);
+    if (width == m_referenceWidth && height == m_referenceHeight) return;
+    m_referenceWidth = width;
+    m_referenceHeight = height;
+    m_dirty = true;
+}
+
+void RenderGraph::reset() {
+    m_order.clear();
+    m_passes.clear();
+    m_resources.clear();
+    m_physical.clear();
+    m_declaredBytes = 0;
+    m_allocatedBytes = 0;
+    m_compiled = false;
+    m_dirty = true;
+}
+
+bool RenderGraph::compile() {
+    for (Resource& resource : m_resources) {
+        resource.firstUse = resource.lastUse = -1;
+        if (resource.kind != ResourceKind::Transient) continue;
+        const RenderTargetDesc& desc = resource.desc;
+        resource.width = desc.width > 0 ? desc.width : std::max(1, static_cast<int>(std::lround(m_referenceWidth * desc.scale)));
+        resource.height = desc.height > 0 ? desc.height : std::max(1, static_cast<int>(std::lround(m_referenceHeight * desc.scale)));
+    }
+
+    cullPasses();
+    if (!orderPasses()) {
+        m_compiled = false;
+        return false;
+    }
+    allocateTransients();
+    buildFramebuffers();
+
+    m_dirty = false;
+    m_compiled = true;
+    return true;
+}
+
+void RenderGraph::cullPasses() {
+    // Walk back from the roots: a pass is needed if a needed pass reads something it writes.
+    std::vector<uint32_t> pending;
+    for (uint32_t p = 0; p < m_passes.size(); ++p) {
+        Pass& pass = m_passes[p];
+        pass.culled = true;
+        bool root = pass.sideEffect;
+        for (uint32_t resource : pass.writes) {
+            root = root || m_resources[resource].kind != ResourceKind::Transient;
+        }
+        if (root) {
+            pass.culled = false;
+            pending.push_back(p);
+        }
+    }
+    while (!pending.empty()) {
+        uint32_t reader = pending.back();
+        pending.pop_back();
+        for (uint32_t resource : m_passes[reader].reads) {
+            for (uint32_t p = 0; p < m_passes.size(); ++p) {
+                Pass& writer = m_passes[p];
+                if (!writer.culled) continue;
+                if (std::find(writer.writes.begin(), writer.writes.end(), resource) != writer.writes.end()) {
+                    writer.culled = false;
+                    pending.push_back(p);
+                }
+            }
+        }
+    }
+}
+
+bool RenderGraph::orderPasses() {
+    // Dependencies: every writer of a resource runs before every pass that only reads it, and
+    // writers of the same resource keep their declaration order.
+    const size_t count = m_passes.size();
+    std::vector<std::vector<uint32_t>> after(count);
+    std::vector<int> incoming(count, 0);
+    auto writes = [this](uint32_t pass, uint32_t resource) {
+        const std::vector<uint32_t>& list = m_passes[pass].writes;
+        return std::find(list.begin(), list.end(), resource) != list.end();
+    };
+    for (uint32_t a = 0; a < count; ++a) {
+        if (m_passes[a].culled) continue;
+        for (uint32_t b = 0; b < count; ++b) {
+            if (a == b || m_passes[b].culled) continue;
+            bool edge = false;
+            for (uint32_t resource : m_passes[a].writes) {
+                bool bReads = std::find(m_passes[b].reads.begin(), m_passes[b].reads.end(), resource) != m_passes[b].reads.end();
+                if ((bReads && !writes(b, resource)) || (writes(b, resource) && a < b)) edge = true;
+            }
+            if (edge) {
+                after[a].push_back(b);
+                incoming[b]++;
+            }
+        }
+    }
+
+    // Kahn's algorithm, always taking the earliest declared pass that is ready.
+    m_order.clear();
+    std::vector<bool> done(count, false);
+    size_t kept = 0;
+    for (const Pass& pass : m_passes) kept += pass.culled ? 0 : 1;
+    while (m_order.size() < kept) {
+        uint32_t next = RenderGraphResource::kInvalid;
+        for (uint32_t p = 0; p < count && next == RenderGraphResource::kInvalid; ++p) {
+            if (!m_passes[p].culled && !done[p] && incoming[p] == 0) next = p;
+        }
+        if (next == RenderGraphResource::kInvalid) {
+            std::cerr << "Render graph has a dependency cycle; not compiled." << std::endl;
+            return false;
+        }
+        done[next] = true;
+        m_order.push_back(next);
+        for (uint32_t b : after[next]) incoming[b]--;
+    }
+
+    for (int position = 0; position < static_cast<int>(m_order.size()); ++position) {
+        const Pass& pass = m_passes[m_order[position]];
+        auto touch = [&](uint32_t index, bool isRead) {
+            Resource& resource = m_resources[index];
+            if (resource.firstUse < 0) {
+                resource.firstUse = position;
+                if (isRead && resource.kind == ResourceKind::Transient) {
+                    std::cerr << "Render graph: pass " << pass.name << " reads " << resource.name
+                              << " before anything writes it." << std::endl;
+                }
+            }
+            resource.lastUse = position;
+        };
+        for (uint32_t index : pass.reads) touch(index, true);
+        for (uint32_t index : pass.writes) touch(index, false);
+    }
+    return true;
+}
+
+void RenderGraph::allocateTransients() {
+    // Greedy interval packing: in order of first use, reuse the first texture of the same format
+    // and size that its previous occupant has finished with.
+    std::vector<uint32_t> transients;
+    for (uint32_t index = 0; index < m_resources.size(); ++index) {
+        const Resource& resource = m_resources[index];
+        if (resource.kind == ResourceKind::Transient && resource.firstUse >= 0) transients.push_back(index);
+    }
+    std::stable_sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b) {
+        return m_resources[a].firstUse < m_resources[b].firstUse;
+    });
+
+    m_physical.clear();
+    m_declaredBytes = 0;
+    m_allocatedBytes = 0;
+    for (uint32_t index : transients) {
+        Resource& resource = m_resources[index];
+        const size_t bytes = glTextureBytes(resource.desc.format, resource.width, resource.height);
+        m_declaredBytes += bytes;
+
+        uint32_t slot = static_cast<uint32_t>(m_physical.size());
+        for (uint32_t i = 0; i < m_physical.size(); ++i) {
+            const PhysicalTexture& physical = m_physical[i];
+            if (physical.format == resource.desc.format && physical.width == resource.width &&
+                physical.height == resource.height && physical.lastUse < resource.firstUse) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot == m_physical.size()) {
+            PhysicalTexture physical{ GLTexture::create("RenderGraph"), resource.desc.format, resource.width, resource.height, -1 };
+            GLenum format, type;
+            uploadFormatFor(physical.format, format, type);
+            glBindTexture(GL_TEXTURE_2D, physical.texture.id());
+            glTexImage2D(GL_TEXTURE_2D, 0, physical.format, physical.width, physical.height, 0, format, type, nullptr);
+            const bool depth = isDepthFormat(physical.format);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, depth ? GL_NEAREST : GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, depth ? GL_NEAREST : GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            physical.texture.setStorage(bytes, "transient render target");
+            m_allocatedBytes += bytes;
+            m_physical.push_back(std::move(physical));
+        }
+        m_physical[slot].lastUse = resource.lastUse;
+        resource.physical = slot;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void RenderGraph::buildFramebuffers() {
+    for (Resource& resource : m_resources) {
+        resource.attached = false;
+        if (resource.kind == ResourceKind::Transient) resource.framebuffer = 0;
+    }
+    for (Pass& pass : m_passes) {
+        pass.ownedFramebuffer.reset();
+        pass.framebuffer = 0;
+        pass.framebufferResource = RenderGraphResource::kInvalid;
+        pass.bindsFramebuffer = false;
+        if (pass.culled) continue;
+
+        // The backbuffer, or an import that brings its own framebuffer, is bound as is.
+        // Otherwise the pass gets a framebuffer of everything it writes.
+        GLuint attachments[8];
+        int colorCount = 0;
+        GLuint depth = 0;
+        for (uint32_t index : pass.writes) {
+            const Resource& resource = m_resources[index];
+            if (resource.kind == ResourceKind::Buffer) continue;
+            pass.bindsFramebuffer = true;
+            pass.viewportWidth = resource.width;
+            pass.viewportHeight = resource.height;
+            if (resource.kind == ResourceKind::Backbuffer) {
+                pass.framebuffer = 0;
+                colorCount = -1;
+                break;
+            }
+            if (resource.kind == ResourceKind::Texture && resource.framebuffer != 0) {
+                pass.framebufferResource = index;
+                colorCount = -1;
+                break;
+            }
+            m_resources[index].attached = true;
+            GLuint texture = resource.kind == ResourceKind::Transient ? m_physical[resource.physical].texture.id() : resource.object;
+            if (isDepthFormat(resource.desc.format)) {
+                depth = texture;
+            } else if (colorCount < 8) {
+                attachments[colorCount++] = texture;
+            }
+        }
+        if (!pass.bindsFramebuffer || colorCount < 0) continue;
+
+        pass.ownedFramebuffer = GLFramebuffer::create("RenderGraph");
+        pass.framebuffer = pass.ownedFramebuffer.id();
+        for (uint32_t index : pass.writes) {
+            if (m_resources[index].kind == ResourceKind::Transient) m_resources[index].framebuffer = pass.framebuffer;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, pass.framebuffer);
+        GLenum drawBuffers[8];
+        for (int i = 0; i < colorCount; ++i) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, attachments[i], 0);
+            drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+        }
+        if (depth) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+        }
+        if (colorCount > 0) {
+            glDrawBuffers(colorCount, drawBuffers);
+        } else {
+            glDrawBuffer(GL_NONE);
+        }
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "Render graph framebuffer for pass " << pass.name << " is incomplete." << std::endl;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderGraph::execute() {
+    if (m_dirty && !compile()) return;
+    if (!m_compiled) return;
+
+    const PassContext context(*this);
+    for (uint32_t index : m_order) {
+        Pass& pass = m_passes[index];
+        if (pass.bindsFramebuffer) {
+            GLuint framebuffer = pass.framebuffer;
+            if (pass.framebufferResource != RenderGraphResource::kInvalid) {
+                framebuffer = m_resources[pass.framebufferResource].framebuffer;
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glViewport(0, 0, pass.viewportWidth, pass.viewportHeight);
+            telemetry::add(telemetry::Counter::StateChanges);
+        }
+        pass.execute(context);
+    }
+}
+
+void RenderGraph::printCompiled() const {
+    if (!m_compiled) {
+        std::cout << "Render graph: not compiled" << std::endl;
+        return;
+    }
+
+    std::cout << "Render graph: " << m_order.size() << " of " << m_passes.size() << " passes scheduled, "
+              << m_referenceWidth << "x" << m_referenceHeight << " reference size" << std::endl;
+    auto printList = [this](const char* label, const std::vector<uint32_t>& list) {
+        if (list.empty()) return;
+        std::cout << "  " << label;
+        for (uint32_t index : list) std::cout << " " << m_resources[index].name;
+    };
+    for (size_t position = 0; position < m_order.size(); ++position) {
+        const Pass& pass = m_passes[m_order[position]];
+        std::cout << "  " << std::setw(2) << position << ". " << std::left << std::setw(16) << pass.name << std::right;
+        printList("reads", pass.reads);
+        printList("writes", pass.writes);
+        if (pass.sideEffect) std::cout << "  (side effect)";
+        std::cout << std::endl;
+    }
+    for (const Pass& pass : m_passes) {
+        if (pass.culled) std::cout << "  culled: " << pass.name << std::endl;
+    }
+
+    bool anyTransient = false;
+    for (const Resource& resource : m_resources) {
+        if (resource.kind != ResourceKind::Transient || resource.firstUse < 0) continue;
+        if (!anyTransient) std::cout << "  transient targets:" << std::endl;
+        anyTransient = true;
+        std::cout << "    " << std::left << std::setw(16) << resource.name << std::right << " "
+                  << formatName(resource.desc.format) << " " << resource.width << "x" << resource.height
+                  << "  passes " << resource.firstUse << "-" << resource.lastUse
+                  << "  -> texture " << resource.physical << std::endl;
+    }
+    const double declaredMiB = m_declaredBytes / double(1 << 20);
+    const double allocatedMiB = m_allocatedBytes / double(1 << 20);
+    std::cout << std::fixed << std::setprecision(2)
+              << "  transient memory: " << allocatedMiB << " MiB in " << m_physical.size() << " textures for "
+              << declaredMiB << " MiB declared";
+    if (m_declaredBytes > 0) {
+        std::cout << " (" << std::setprecision(0) << 100.0 * (1.0 - double(m_allocatedBytes) / m_declaredBytes) << "% saved by aliasing)";
+    }
+    std::cout << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
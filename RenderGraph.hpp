@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <GL/glew.h>
+
+#include "GLResource.hpp"
+
+// Handle to a texture or buffer declared in a RenderGraph.
+struct RenderGraphResource {
+    static constexpr uint32_t kInvalid = ~0u;
+    uint32_t index = kInvalid;
+    explicit operator bool() const { return index != kInvalid; }
+};
+
+// A transient render target. Width and height of 0 mean `scale` times the graph's reference size.
+struct RenderTargetDesc {
+    GLenum format = GL_RGBA8;
+    float scale = 1.0f;
+    int width = 0;
+    int height = 0;
+};
+
+// Declares the frame as passes that read and write textures and buffers, and runs them.
+//
+// The graph is declared once, or again after reset(); compile() then
+//   - culls passes whose results nothing needs (a pass is kept if it has side effects, writes an
+//     imported resource, or writes something a kept pass reads),
+//   - orders the kept passes so every pass runs after the passes that write what it reads
+//     (declaration order breaks ties, and passes writing the same resource keep their order),
+//   - allocates the transient targets, letting targets of the same format and size whose
+//     lifetimes do not overlap share one texture,
+//   - builds a framebuffer per pass from the targets it writes.
+// execute() recompiles only when the declaration or the reference size changed, so a steady
+// frame touches no heap memory. Buffers can only be imported; they order passes but are never
+// allocated by the graph.
+class RenderGraph {
+public:
+    class PassBuilder {
+    public:
+        RenderGraphResource create(const char* name, const RenderTargetDesc& desc);
+        RenderGraphResource read(RenderGraphResource resource);
+        RenderGraphResource write(RenderGraphResource resource);
+        // Keeps the pass even if nothing reads its output (presenting, readbacks, CPU work).
+        void setSideEffect();
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, uint32_t pass) : m_graph(graph), m_pass(pass) {}
+        RenderGraph& m_graph;
+        uint32_t m_pass;
+    };
+
+    class PassContext {
+    public:
+        // GL name of a texture or buffer this pass declared.
+        GLuint resource(RenderGraphResource resource) const;
+        // A framebuffer with the texture attached, for glBlitFramebuffer or glReadPixels: the
+        // import's own, or the one built for the pass that writes the transient.
+        GLuint framebuffer(RenderGraphResource resource) const;
+        int width(RenderGraphResource resource) const;
+        int height(RenderGraphResource resource) const;
+
+    private:
+        friend class RenderGraph;
+        explicit PassContext(const RenderGraph& graph) : m_graph(graph) {}
+        const RenderGraph& m_graph;
+    };
+
+    using SetupFunction = std::function<void(PassBuilder&)>;
+    using ExecuteFunction = std::function<void(const PassContext&)>;
+
+    RenderGraph() = default;
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // The window's framebuffer. Writing it makes a pass a root.
+    RenderGraphResource importBackbuffer(const char* name);
+    // A texture owned elsewhere. framebuffer, if not 0, is bound for passes that write it.
+    RenderGraphResource importTexture(const char* name, GLuint texture, int width, int height,
+                                      GLenum format, GLuint framebuffer = 0);
+    RenderGraphResource importBuffer(const char* name, GLuint buffer);
+    // Points an import at a new object or size, e.g. after its owner reallocated it or swapped
+    // ping-pong targets. Only a new size, or a new texture inside a graph-built framebuffer, recompiles.
+    void updateImport(RenderGraphResource resource, GLuint object, int width, int height, GLuint framebuffer = 0);
+
+    // setup runs immediately and declares what the pass reads and writes; execute runs every frame.
+    void addPass(const char* name, const SetupFunction& setup, ExecuteFunction execute);
+
+    // Size that relative transient targets scale from, usually the window's.
+    void setReferenceSize(int width, int height);
+    // Drops every pass, resource and transient texture, to declare the frame again.
+    void reset();
+
+    // True when execute() would recompile; compile() ahead of it to keep the work out of the frame.
+    bool isDirty() const { return m_dirty; }
+    bool compile();
+    void execute();
+
+    // Prints the schedule, culled passes, transient lifetimes and what aliasing saved.
+    void printCompiled() const;
+
+private:
+    enum class ResourceKind : uint8_t { Transient, Texture, Buffer, Backbuffer };
+
+    struct Resource {
+        const char* name;
+        ResourceKind kind;
+        RenderTargetDesc desc;
+        GLuint object = 0;         // imported texture or buffer
+        GLuint framebuffer = 0;    // an import's own, or the graph-built one a transient is attached to
+        int width = 0;
+        int height = 0;
+        uint32_t physical = 0;     // transients: index into m_physical
+        int firstUse = -1;         // positions in m_order
+        int lastUse = -1;
+        bool attached = false;     // inside a framebuffer built by the graph
+    };
+
+    struct Pass {
+        const char* name;
+        ExecuteFunction execute;
+        std::vector<uint32_t> reads;
+        std::vector<uint32_t> writes;
+        bool sideEffect = false;
+        bool culled = false;
+        // Filled by compile().
+        GLFramebuffer ownedFramebuffer;
+        GLuint framebuffer = 0;
+        uint32_t framebufferResource = RenderGraphResource::kInvalid; // import whose framebuffer is bound instead
+        bool bindsFramebuffer = false;
+        int viewportWidth = 0;
+        int viewportHeight = 0;
+    };
+
+    struct PhysicalTexture {
+        GLTexture texture;
+        GLenum format;
+        int width;
+        int height;
+        int lastUse;
+    };
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<uint32_t> m_order;    // kept passes, in execution order
+    std::vector<PhysicalTexture> m_physical;
+    int m_referenceWidth = 1;
+    int m_referenceHeight = 1;
+    bool m_dirty = true;
+    bool m_compiled = false;
+    size_t m_declaredBytes = 0;
+    size_t m_allocatedBytes = 0;
+
+    RenderGraphResource addResource(const Resource& resource);
+    void cullPasses();
+    bool orderPasses();
+    void allocateTransients();
+    void buildFramebuffers();
+};
@@ -0,0 +1,74 @@
+#include "ShaderUtils.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+GLuint compileShader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+GLuint createShaderProgram(const char* vsSource, const char* fsSource) {
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, vsSource);
+    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, fsSource);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cerr << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        program = 0;
+    }
+
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    return program;
+}
+
+static const char* ditherShaderSource = R"(
+const float bayer4x4[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0,
+                                     3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);
+
+// In (0, 1); discard where it reaches the fade. 1.0 - ditherThreshold() covers the other pixels.
+float ditherThreshold()
+{
+    ivec2 p = ivec2(gl_FragCoord.xy) & 3;
+    return (bayer4x4[p.y * 4 + p.x] + 0.5) / 16.0;
+}
+)";
+
+const char* ditherShaderLibrary() {
+    return ditherShaderSource;
+}
+
+std::string withShaderLibrary(const char* source, const char* library) {
+    std::string text(source);
+    size_t version = text.find("#version");
+    if (version == std::string::npos) {
+        return std::string(library) + "\n#line 1\n" + text;
+    }
+    size_t lineEnd = text.find('\n', version);
+    if (lineEnd == std::string::npos) {
+        return text + "\n" + library;
+    }
+    // Restore the original numbering for the lines after #version.
+    size_t versionLine = 1 + static_cast<size_t>(std::count(text.begin(), text.begin() + version, '\n'));
+    return text.substr(0, lineEnd + 1) + library + "\n#line " + std::to_string(versionLine + 1) + "\n" + text.substr(lineEnd + 1);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <GL/glew.h>
+
+// Compiles a single shader. Returns the shader even on failure, after logging the info log.
+GLuint compileShader(GLenum type, const char* source);
+// Creates a shader program from vertex and fragment shader sources. Returns 0 on link failure.
+GLuint createShaderProgram(const char* vsSource, const char* fsSource);
+// Inserts `library` (shared GLSL functions and declarations) right after the #version line of
+// `source`, keeping the line numbers of the rest of the source in compiler messages.
+std::string withShaderLibrary(const char* source, const char* library);
+// GLSL library with ditherThreshold(): the ordered 4x4 dither every screen-door fade shares, so
+// a fading mesh and the impostor replacing it discard complementary pixels.
+const char* ditherShaderLibrary();
@@ -1,8 +1,12 @@
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
 #include "Skybox.hpp"
+#include "CameraUniforms.hpp"
+#include "ShaderUtils.hpp"
+#include "Telemetry.hpp"
+#include "AssetBundle.hpp"
 #include <iostream>
+#include <string>
 
 // Define GL_CHECK_ERROR for internal use within Skybox.cpp
 #define GL_CHECK_ERROR() \
@@ -65,15 +69,13 @@ const char* skyboxVertexShaderSource = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 projection;
-uniform mat4 view;
-
 out vec3 TexCoords;
 
 void main()
 {
     TexCoords = aPos;
-    vec4 clipPos = projection * view * vec4(aPos, 1.0);
+    // Rotation only: the sky stays centred on the camera.
+    vec4 clipPos = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
     gl_Position = vec4(clipPos.xy, 1.0, 1.0);
 }
 )";
@@ -98,48 +100,21 @@ Skybox::Skybox() {
     createGLResources();
 }
 
-Skybox::~Skybox() {
-    destroyGLResources();
-}
-
-Skybox::Skybox(Skybox&& other) noexcept
-    : m_vao(other.m_vao), m_vbo(other.m_vbo),
-      m_textureID(other.m_textureID), m_shaderProgram(other.m_shaderProgram)
-{
-    other.m_vao = 0;
-    other.m_vbo = 0;
-    other.m_textureID = 0;
-    other.m_shaderProgram = 0;
-}
-
-Skybox& Skybox::operator=(Skybox&& other) noexcept {
-    if (this != &other) {
-        destroyGLResources();
-        m_vao = other.m_vao;
-        m_vbo = other.m_vbo;
-        m_textureID = other.m_textureID;
-        m_shaderProgram = other.m_shaderProgram;
-
-        other.m_vao = 0;
-        other.m_vbo = 0;
-        other.m_textureID = 0;
-        other.m_shaderProgram = 0;
-    }
-    return *this;
-}
+Skybox::~Skybox() = default;
 
 void Skybox::createGLResources() {
-    glGenVertexArrays(1, &m_vao);
+    m_vao = GLVertexArray::create("Skybox");
     GL_CHECK_ERROR();
-    glGenBuffers(1, &m_vbo);
+    m_vbo = GLBuffer::create("Skybox");
     GL_CHECK_ERROR();
 
-    glBindVertexArray(m_vao);
+    glBindVertexArray(m_vao.id());
     GL_CHECK_ERROR();
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo.id());
     GL_CHECK_ERROR();
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
     GL_CHECK_ERROR();
+    m_vbo.setStorage(sizeof(skyboxVertices), "vec3 positions");
     glEnableVertexAttribArray(0);
     GL_CHECK_ERROR();
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -149,12 +124,14 @@ void Skybox::createGLResources() {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     GL_CHECK_ERROR();
 
-    m_shaderProgram = createShaderProgram(skyboxVertexShaderSource, skyboxFragmentShaderSource);
+    std::string vertexSource = withShaderLibrary(skyboxVertexShaderSource, CameraUniforms::shaderLibrary());
+    m_shaderProgram = GLProgram::adopt(createShaderProgram(vertexSource.c_str(), skyboxFragmentShaderSource), "Skybox");
     GL_CHECK_ERROR();
-    if (m_shaderProgram == 0) {
+    if (!m_shaderProgram) {
         std::cerr << "Failed to create skybox shader program." << std::endl;
     } else {
-        GLint aPosLoc = glGetAttribLocation(m_shaderProgram, "aPos");
+        CameraUniforms::setupProgram(m_shaderProgram.id());
+        GLint aPosLoc = glGetAttribLocation(m_shaderProgram.id(), "aPos");
         std::cout << "Skybox Shader aPos location: " << aPosLoc << std::endl;
         if (aPosLoc != 0) {
             std::cerr << "WARNING: aPos attribute location is not 0, it's " << aPosLoc << ". This might be an issue." << std::endl;
@@ -163,24 +140,20 @@ void Skybox::createGLResources() {
     }
 }
 
-void Skybox::destroyGLResources() {
-    if (m_vao != 0) glDeleteVertexArrays(1, &m_vao);
-    if (m_vbo != 0) glDeleteBuffers(1, &m_vbo);
-    if (m_textureID != 0) glDeleteTextures(1, &m_textureID);
-    if (m_shaderProgram != 0) glDeleteProgram(m_shaderProgram);
-}
-
 bool Skybox::load(const std::vector<std::string>& faces) {
     if (faces.size() != 6) {
         std::cerr << "Skybox requires 6 faces." << std::endl;
         return false;
     }
-    m_textureID = loadCubemap(faces);
-    return m_textureID != 0;
+    Face decoded[kFaceCount];
+    for (int i = 0; i < kFaceCount; ++i) {
+        if (!decoded[i].decode(faces[i])) return false;
+    }
+    return upload(decoded);
 }
 
-void Skybox::draw(const glm::mat4& view, const glm::mat4& projection) {
-    if (m_vao == 0 || m_shaderProgram == 0 || m_textureID == 0) {
+void Skybox::draw() {
+    if (!m_vao || !m_shaderProgram || !m_texture) {
         std::cerr << "Skybox not initialized or loaded properly. Skipping draw." << std::endl;
         return;
     }
@@ -190,30 +163,26 @@ void Skybox::draw(const glm::mat4& view, const glm::mat4& projection) {
     glDisable(GL_CULL_FACE);
     GL_CHECK_ERROR();
 
-    glUseProgram(m_shaderProgram);
+    glUseProgram(m_shaderProgram.id());
     GL_CHECK_ERROR();
 
     glDepthFunc(GL_LEQUAL);
     GL_CHECK_ERROR();
 
-    // Remove translation from the view matrix for the skybox
-    glm::mat4 skyboxView = glm::mat4(glm::mat3(view));
-    glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(skyboxView));
-    GL_CHECK_ERROR();
-    glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1i(glGetUniformLocation(m_shaderProgram.id(), "skybox"), 0);
     GL_CHECK_ERROR();
 
-    glUniform1i(glGetUniformLocation(m_shaderProgram, "skybox"), 0);
-    GL_CHECK_ERROR();
-
-    glBindVertexArray(m_vao);
+    glBindVertexArray(m_vao.id());
     GL_CHECK_ERROR();
     glActiveTexture(GL_TEXTURE0);
     GL_CHECK_ERROR();
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_textureID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, m_texture.id());
     GL_CHECK_ERROR();
     glDrawArrays(GL_TRIANGLES, 0, 36);
     GL_CHECK_ERROR();
+    telemetry::countDraw(12);
+    telemetry::add(telemetry::Counter::StateChanges, 2);
+    telemetry::add(telemetry::Counter::TextureBinds);
     glBindVertexArray(0);
     GL_CHECK_ERROR();
 
@@ -228,73 +197,44 @@ void Skybox::draw(const glm::mat4& view, const glm::mat4& projection) {
     GL_CHECK_ERROR();
 }
 
-// Static helper functions
-GLuint Skybox::compileShader(GLenum type, const char* source) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
-
-    int success;
-    char infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-    return shader;
+Skybox::Face::~Face() {
+    if (pixels) stbi_image_free(pixels);
 }
 
-GLuint Skybox::createShaderProgram(const char* vsSource, const char* fsSource) {
-    GLuint vertex = compileShader(GL_VERTEX_SHADER, vsSource);
-    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, fsSource);
-
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertex);
-    glAttachShader(program, fragment);
-    glLinkProgram(program);
-
-    int success;
-    char infoLog[512];
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(program, 512, NULL, infoLog);
-        std::cerr << "ERROR::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        program = 0;
+bool Skybox::Face::decode(const std::string& path) {
+    // Cubemap faces are stored top row first.
+    pixels = loadImage(path.c_str(), &width, &height, &channels, 0, /*flipVertically=*/false);
+    if (!pixels) {
+        std::cerr << "Cubemap texture failed to load at path: " << path << ". Reason: " << stbi_failure_reason() << std::endl;
+        return false;
     }
-
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-    return program;
+    return true;
 }
 
-GLuint Skybox::loadCubemap(const std::vector<std::string>& faces) {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
+bool Skybox::upload(Face (&faces)[kFaceCount]) {
+    for (const Face& face : faces) {
+        if (!face.pixels) return false;
+    }
+
+    GLTexture texture = GLTexture::create("Skybox");
     GL_CHECK_ERROR();
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture.id());
     GL_CHECK_ERROR();
 
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(false);
-    for (unsigned int i = 0; i < faces.size(); i++) {
-        unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data) {
-            GLenum format = GL_RGB;
-            if (nrChannels == 4) format = GL_RGBA;
-            else if (nrChannels == 1) format = GL_RED;
-
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-            GL_CHECK_ERROR();
-            stbi_image_free(data);
-        } else {
-            std::cerr << "Cubemap texture failed to load at path: " << faces[i] << ". Reason: " << stbi_failure_reason() << std::endl;
-            stbi_image_free(data);
-            return 0;
-        }
+    size_t totalBytes = 0;
+    for (int i = 0; i < kFaceCount; i++) {
+        Face& face = faces[i];
+        GLenum format = GL_RGB;
+        if (face.channels == 4) format = GL_RGBA;
+        else if (face.channels == 1) format = GL_RED;
+
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, face.width, face.height, 0, format, GL_UNSIGNED_BYTE, face.pixels);
+        GL_CHECK_ERROR();
+        totalBytes += glTextureBytes(format, face.width, face.height);
+        telemetry::add(telemetry::Counter::BytesUploaded, static_cast<uint64_t>(face.width) * face.height * face.channels);
+        stbi_image_free(face.pixels);
+        face.pixels = nullptr;
     }
-    stbi_set_flip_vertically_on_load(true);
 
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     GL_CHECK_ERROR();
@@ -307,5 +247,7 @@ GLuint Skybox::loadCubemap(const std::vector<std::string>& faces) {
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     GL_CHECK_ERROR();
 
-    return textureID;
-}
\ No newline at end of file
+    texture.setStorage(totalBytes, "cubemap RGB8/RGBA8");
+    m_texture = std::move(texture);
+    return true;
+}
@@ -7,40 +7,52 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "GLResource.hpp"
+
 class Skybox {
 public:
+    static constexpr int kFaceCount = 6;
+
+    // One cubemap face decoded into memory. Decoding makes no GL calls, so the faces can be
+    // decoded on different threads and then handed to upload() on the GL thread.
+    struct Face {
+        unsigned char* pixels = nullptr; // freed with stbi_image_free()
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+
+        Face() = default;
+        ~Face();
+        Face(const Face&) = delete;
+        Face& operator=(const Face&) = delete;
+
+        bool decode(const std::string& path);
+    };
+
     Skybox();
     ~Skybox();
 
     Skybox(const Skybox&) = delete;
     Skybox& operator=(const Skybox&) = delete;
-    Skybox(Skybox&&) noexcept;
-    Skybox& operator=(Skybox&&) noexcept;
+    Skybox(Skybox&&) noexcept = default;
+    Skybox& operator=(Skybox&&) noexcept = default;
 
-    // Loads the cubemap textures.
+    // Loads the cubemap textures, decoding one face after the other.
     bool load(const std::vector<std::string>& faces);
-    // Draws the skybox.
-    void draw(const glm::mat4& view, const glm::mat4& projection);
+    // Uploads decoded faces in +X, -X, +Y, -Y, +Z, -Z order and frees their pixels.
+    bool upload(Face (&faces)[kFaceCount]);
+    // Draws the skybox with the camera from CameraUniforms.
+    void draw();
 
     // Getter for texture ID for debugging
-    GLuint getTextureID() const { return m_textureID; }
+    GLuint getTextureID() const { return m_texture.id(); }
 
 private:
-    GLuint m_vao = 0;
-    GLuint m_vbo = 0;
-    GLuint m_textureID = 0;
-    GLuint m_shaderProgram = 0;
+    GLVertexArray m_vao;
+    GLBuffer m_vbo;
+    GLTexture m_texture;
+    GLProgram m_shaderProgram;
 
     // Creates OpenGL resources (VAO, VBO, Shader Program).
     void createGLResources();
-    // Destroys OpenGL resources.
-    void destroyGLResources();
-
-    // Helper functions (implemented in .cpp)
-    // Compiles a single shader.
-    static GLuint compileShader(GLenum type, const char* source);
-    // Creates a shader program from vertex and fragment shader sources.
-    static GLuint createShaderProgram(const char* vsSource, const char* fsSource);
-    // Loads a cubemap texture from a list of face paths.
-    static GLuint loadCubemap(const std::vector<std::string>& faces);
 };
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "StreamBuffer.hpp"
+#include "Telemetry.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+StreamBuffer::StreamBuffer(size_t bytesPerFrame, const char* owner)
+    : m_regionSize(bytesPerFrame)
+{
+    GLint uniformAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    if (uniformAlignment > 0) m_uniformAlignment = static_cast<size_t>(uniformAlignment);
+
+    m_buffer = GLBuffer::create(owner);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.id());
+
+    m_persistent = GLEW_ARB_buffer_storage != 0;
+    if (m_persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, m_regionSize * kRegionCount, nullptr, flags);
+        m_persistentBase = static_cast<std::byte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_regionSize * kRegionCount, flags));
+        if (!m_persistentBase) {
+            std::cerr << "Persistent mapping failed, falling back to buffer orphaning." << std::endl;
+            m_persistent = false;
+            m_buffer = GLBuffer::create(owner);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.id());
+        }
+    }
+    if (m_persistent) {
+        m_buffer.setStorage(m_regionSize * kRegionCount, "persistent stream ring");
+    } else {
+        glBufferData(GL_COPY_WRITE_BUFFER, m_regionSize, nullptr, GL_STREAM_DRAW);
+        m_buffer.setStorage(m_regionSize, "orphaned stream buffer");
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    std::cout << "Stream buffer created: " << (m_persistent ? "persistent, " : "orphaning, ")
+              << m_regionSize << " bytes per frame" << std::endl;
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (GLsync& fence : m_fences) {
+        if (fence) glDeleteSync(fence);
+    }
+    if (m_buffer && (m_persistentBase || m_mappedBase)) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.id());
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+void StreamBuffer::beginFrame() {
+    m_offset = 0;
+    m_frames++;
+
+    if (m_persistent) {
+        m_region = (m_region + 1) % kRegionCount;
+        GLsync& fence = m_fences[m_region];
+        if (fence) {
+            // Only count it as a wait if the GPU is actually still reading this region.
+            GLenum status = glClientWaitSync(fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                auto start = std::chrono::steady_clock::now();
+                do {
+                    status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+                } while (status == GL_TIMEOUT_EXPIRED);
+                m_fenceWaits++;
+                m_fenceWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    } else {
+        // Orphan: the driver hands us fresh storage while the GPU keeps reading the old one.
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.id());
+        glBufferData(GL_COPY_WRITE_BUFFER, m_regionSize, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+StreamAllocation StreamBuffer::allocate(size_t bytes, size_t alignment) {
+    size_t start = (m_offset + alignment - 1) / alignment * alignment;
+    if (start + bytes > m_regionSize) {
+        if (!m_reportedOverflow) {
+            std::cerr << "Stream buffer full: " << bytes << " bytes requested, " << (m_regionSize - m_offset)
+                      << " of " << m_regionSize << " left this frame." << std::endl;
+            m_reportedOverflow = true;
+        }
+        return StreamAllocation();
+    }
+
+    StreamAllocation allocation;
+    allocation.size = static_cast<GLsizeiptr>(bytes);
+    if (m_persistent) {
+        allocation.offset = static_cast<GLintptr>(m_region * m_regionSize + start);
+        allocation.data = m_persistentBase + allocation.offset;
+    } else {
+        if (!m_mappedBase) {
+            // Everything before m_offset may already be in use by submitted draws, so map only the tail.
+            m_mappedFrom = m_offset;
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.id());
+            m_mappedBase = static_cast<std::byte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, m_mappedFrom, m_regionSize - m_mappedFrom,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            if (!m_mappedBase) return StreamAllocation();
+        }
+        allocation.offset = static_cast<GLintptr>(start);
+        allocation.data = m_mappedBase + (start - m_mappedFrom);
+    }
+
+    m_offset = start + bytes;
+    m_totalBytes += bytes;
+    telemetry::add(telemetry::Counter::BytesUploaded, bytes);
+    return allocation;
+}
+
+void StreamBuffer::flush() {
+    // Persistent coherent mappings need nothing; the orphaned buffer must be unmapped before use.
+    if (!m_persistent && m_mappedBase) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.id());
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        m_mappedBase = nullptr;
+    }
+}
+
+void StreamBuffer::endFrame() {
+    flush();
+    if (m_persistent) {
+        m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void StreamBuffer::printStats() const {
+    if (m_frames == 0) return;
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "Stream buffer (" << (m_persistent ? "persistent" : "orphaning") << "): "
+              << (m_totalBytes / 1024.0) << " KiB streamed, " << (static_cast<double>(m_totalBytes) / m_frames)
+              << " bytes/frame, " << m_fenceWaits << " fence waits (" << m_fenceWaitMs << " ms total)" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <GL/glew.h>
+
+#include "GLResource.hpp"
+
+// A slice of the stream buffer handed out for this frame.
+struct StreamAllocation {
+    void* data = nullptr;  // CPU write pointer, valid until flush()
+    GLintptr offset = 0;   // byte offset inside buffer()
+    GLsizeiptr size = 0;
+
+    explicit operator bool() const { return data != nullptr; }
+};
+
+// Ring buffer for per-frame dynamic GPU data (uniform blocks, instance transforms, dynamic vertices).
+//
+// With ARB_buffer_storage the buffer holds three frame regions, mapped once persistently and
+// coherently; each region is fenced at endFrame() and waited on before it is reused.
+// On plain GL 3.3 the buffer is orphaned every frame and mapped unsynchronized instead.
+//
+// Usage per frame: beginFrame(), allocate() and write, flush() before the draws that read the
+// data (further allocations after a flush are fine), endFrame() after the last such draw.
+class StreamBuffer {
+public:
+    StreamBuffer(size_t bytesPerFrame, const char* owner);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    void beginFrame();
+    // Returns an empty allocation (and logs once) when the frame's region is full.
+    StreamAllocation allocate(size_t bytes, size_t alignment = 16);
+    // Allocation aligned for glBindBufferRange(GL_UNIFORM_BUFFER, ...).
+    StreamAllocation allocateUniform(size_t bytes) { return allocate(bytes, m_uniformAlignment); }
+    // Makes everything written so far visible to the GPU.
+    void flush();
+    void endFrame();
+
+    GLuint buffer() const { return m_buffer.id(); }
+    bool isPersistent() const { return m_persistent; }
+
+    uint64_t bytesStreamed() const { return m_totalBytes; }
+    uint64_t fenceWaits() const { return m_fenceWaits; }
+    void printStats() const;
+
+private:
+    static constexpr int kRegionCount = 3;
+
+    GLBuffer m_buffer;
+    size_t m_regionSize;
+    size_t m_uniformAlignment = 256;
+    bool m_persistent = false;
+
+    // Persistent mode
+    std::byte* m_persistentBase = nullptr;
+    GLsync m_fences[kRegionCount] = {};
+    int m_region = 0;
+
+    // Orphaning mode: the currently mapped window [m_mappedFrom, m_regionSize).
+    std::byte* m_mappedBase = nullptr;
+    size_t m_mappedFrom = 0;
+
+    size_t m_offset = 0;
+    bool m_reportedOverflow = false;
+
+    uint64_t m_totalBytes = 0;
+    uint64_t m_frames = 0;
+    uint64_t m_fenceWaits = 0;
+    double m_fenceWaitMs = 0.0;
+};
@@ -0,0 +1,251 @@
+#include "Telemetry.hpp"
+#include "GLResource.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace telemetry {
+
+namespace {
+
+struct RegisteredThread {
+    ThreadCounters counters;
+    uint64_t lastSeen[kCounterCount] = {}; // touched only by the merge, under the registry lock
+};
+
+std::mutex& registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+// A deque never moves its elements, so the references handed out stay valid.
+std::deque<RegisteredThread>& registry() {
+    static std::deque<RegisteredThread> threads;
+    return threads;
+}
+
+const char* counterHelp(Counter counter) {
+    switch (counter) {
+        case Counter::DrawCalls:     return "Draw calls submitted";
+        case Counter::Triangles:     return "Triangles submitted";
+        case Counter::StateChanges:  return "Program, vertex array, framebuffer and buffer binds";
+        case Counter::TextureBinds:  return "Texture binds";
+        case Counter::BytesUploaded: return "Bytes handed to the GPU";
+        default:                     return "";
+    }
+}
+
+} // namespace
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+        case Counter::DrawCalls:     return "draw_calls";
+        case Counter::Triangles:     return "triangles";
+        case Counter::StateChanges:  return "state_changes";
+        case Counter::TextureBinds:  return "texture_binds";
+        case Counter::BytesUploaded: return "bytes_uploaded";
+        default:                     return "unknown";
+    }
+}
+
+ThreadCounters& registerThread() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    return registry().emplace_back().counters;
+}
+
+} // namespace telemetry
+
+
+Telemetry& Telemetry::instance() {
+    static Telemetry telemetry;
+    return telemetry;
+}
+
+Telemetry::~Telemetry() {
+    stopServer();
+}
+
+void Telemetry::endFrame(double frameMs) {
+    using namespace telemetry;
+
+    uint64_t frameValues[kCounterCount] = {};
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (RegisteredThread& thread : registry()) {
+            for (int i = 0; i < kCounterCount; ++i) {
+                uint64_t value = thread.counters.values[i].load(std::memory_order_relaxed);
+                frameValues[i] += value - thread.lastSeen[i];
+                thread.lastSeen[i] = value;
+            }
+        }
+    }
+
+    TelemetrySnapshot snapshot;
+    {
+        std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        for (int i = 0; i < kCounterCount; ++i) {
+            m_totals[i] += frameValues[i];
+            m_snapshot.frameCounters[i] = frameValues[i];
+            m_snapshot.totalCounters[i] = m_totals[i];
+        }
+        m_snapshot.frame++;
+        m_snapshot.frameMs = frameMs;
+        m_snapshot.gpuResidentBytes = GpuMemoryRegistry::instance().residentBytes();
+        m_snapshot.gpuPeakBytes = GpuMemoryRegistry::instance().peakBytes();
+        snapshot = m_snapshot;
+    }
+
+    if (m_csv.is_open()) {
+        m_csv << snapshot.frame << ',' << snapshot.frameMs;
+        for (int i = 0; i < kCounterCount; ++i) {
+            m_csv << ',' << snapshot.frameCounters[i];
+        }
+        m_csv << ',' << snapshot.gpuResidentBytes << '\n';
+    }
+}
+
+TelemetrySnapshot Telemetry::lastFrame() const {
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    return m_snapshot;
+}
+
+bool Telemetry::openCsv(const char* path) {
+    m_csv.open(path, std::ios::out | std::ios::trunc);
+    if (!m_csv.is_open()) {
+        std::cerr << "Failed to open telemetry CSV: " << path << std::endl;
+        return false;
+    }
+    m_csv << "frame,frame_ms";
+    for (int i = 0; i < telemetry::kCounterCount; ++i) {
+        m_csv << ',' << telemetry::counterName(static_cast<telemetry::Counter>(i));
+    }
+    m_csv << ",gpu_resident_bytes\n";
+    std::cout << "Telemetry logged to " << path << std::endl;
+    return true;
+}
+
+std::string Telemetry::formatPrometheus(const TelemetrySnapshot& snapshot) {
+    using namespace telemetry;
+
+    std::ostringstream out;
+    auto metric = [&out](const std::string& name, const char* type, const std::string& help, auto value) {
+        out << "# HELP " << name << ' ' << help << "\n"
+            << "# TYPE " << name << ' ' << type << "\n"
+            << name << ' ' << value << "\n";
+    };
+
+    for (int i = 0; i < kCounterCount; ++i) {
+        Counter counter = static_cast<Counter>(i);
+        std::string name = std::string("island_") + counterName(counter);
+        metric(name + "_total", "counter", std::string(counterHelp(counter)) + " since startup.", snapshot.totalCounters[i]);
+        metric(name + "_per_frame", "gauge", std::string(counterHelp(counter)) + " in the last frame.", snapshot.frameCounters[i]);
+    }
+    metric("island_frames_total", "counter", "Frames rendered since startup.", snapshot.frame);
+    out << std::fixed << std::setprecision(3);
+    metric("island_frame_time_ms", "gauge", "CPU time of the last frame in milliseconds.", snapshot.frameMs);
+    metric("island_gpu_resident_bytes", "gauge", "GPU memory held by live GL objects.", snapshot.gpuResidentBytes);
+    metric("island_gpu_peak_bytes", "gauge", "Highest GPU memory held so far.", snapshot.gpuPeakBytes);
+    return out.str();
+}
+
+bool Telemetry::startServer(const char* socketPath) {
+#ifdef _WIN32
+    std::cerr << "Telemetry socket is not supported on this platform: " << socketPath << std::endl;
+    return false;
+#else
+    if (m_server.joinable()) return true;
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (std::strlen(socketPath) >= sizeof(address.sun_path)) {
+        std::cerr << "Telemetry socket path is too long: " << socketPath << std::endl;
+        return false;
+    }
+    std::strcpy(address.sun_path, socketPath);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        std::cerr << "Failed to create telemetry socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // A socket file left behind by an earlier run would make bind() fail.
+    unlink(socketPath);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        std::cerr << "Failed to bind telemetry socket " << socketPath << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    m_listenFd = fd;
+    m_socketPath = socketPath;
+    m_serverQuit = false;
+    m_server = std::thread(&Telemetry::serverLoop, this);
+    std::cout << "Telemetry served on " << socketPath << std::endl;
+    return true;
+#endif
+}
+
+void Telemetry::stopServer() {
+    if (!m_server.joinable()) return;
+    m_serverQuit = true;
+    m_server.join();
+#ifndef _WIN32
+    close(m_listenFd);
+    unlink(m_socketPath.c_str());
+#endif
+    m_listenFd = -1;
+}
+
+void Telemetry::serverLoop() {
+#ifndef _WIN32
+#ifdef MSG_NOSIGNAL
+    const int sendFlags = MSG_NOSIGNAL; // a scraper hanging up early must not kill the app
+#else
+    const int sendFlags = 0;
+#endif
+
+    while (!m_serverQuit) {
+        // Wake up regularly so stopServer() never waits long.
+        pollfd listener{ m_listenFd, POLLIN, 0 };
+        if (poll(&listener, 1, 200) <= 0) continue;
+        int client = accept(m_listenFd, nullptr, nullptr);
+        if (client < 0) continue;
+
+        // Clients may send an HTTP request (e.g. curl --unix-socket) or just read.
+        char request[1024];
+        ssize_t received = 0;
+        pollfd reader{ client, POLLIN, 0 };
+        if (poll(&reader, 1, 100) > 0) {
+            received = recv(client, request, sizeof(request) - 1, 0);
+        }
+        bool http = received >= 4 && std::memcmp(request, "GET ", 4) == 0;
+
+        std::string body = formatPrometheus(lastFrame());
+        std::string response;
+        if (http) {
+            response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                       std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+        }
+        response += body;
+
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, sendFlags);
+            if (n <= 0) break;
+            sent += static_cast<size_t>(n);
+        }
+        close(client);
+    }
+#endif
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Renderer counters, cheap enough to leave on in release builds.
+//
+// Any thread bumps its own cache-line-sized block with telemetry::add(); the render thread
+// folds every block into a per-frame snapshot in Telemetry::endFrame(). Snapshots can be
+// scraped in Prometheus text format over a local Unix domain socket and/or appended to a CSV.
+namespace telemetry {
+
+enum class Counter : int {
+    DrawCalls,
+    Triangles,
+    StateChanges,  // program, vertex array, framebuffer and buffer binds
+    TextureBinds,
+    BytesUploaded, // data handed to the GPU: streamed per frame and static uploads
+    Count
+};
+constexpr int kCounterCount = static_cast<int>(Counter::Count);
+
+const char* counterName(Counter counter);
+
+// Written only by its owning thread; read (never reset) by the merge.
+struct alignas(64) ThreadCounters {
+    std::atomic<uint64_t> values[kCounterCount] = {};
+};
+
+// Allocates the calling thread's block on first use; blocks live for the rest of the program.
+ThreadCounters& registerThread();
+
+inline ThreadCounters& threadCounters() {
+    thread_local ThreadCounters* counters = &registerThread();
+    return *counters;
+}
+
+inline void add(Counter counter, uint64_t value = 1) {
+    // Single writer, so a relaxed load/store pair is enough and avoids a locked add.
+    std::atomic<uint64_t>& slot = threadCounters().values[static_cast<int>(counter)];
+    slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// One draw call producing `triangles` triangles.
+inline void countDraw(uint64_t triangles) {
+    add(Counter::DrawCalls);
+    add(Counter::Triangles, triangles);
+}
+
+} // namespace telemetry
+
+struct TelemetrySnapshot {
+    uint64_t frame = 0;
+    double frameMs = 0.0;
+    uint64_t gpuResidentBytes = 0;
+    uint64_t gpuPeakBytes = 0;
+    uint64_t frameCounters[telemetry::kCounterCount] = {}; // during the last frame
+    uint64_t totalCounters[telemetry::kCounterCount] = {}; // since startup
+};
+
+class Telemetry {
+public:
+    static Telemetry& instance();
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    // Merges every thread's counters into a new snapshot. Call once per frame on the render thread.
+    void endFrame(double frameMs);
+    TelemetrySnapshot lastFrame() const;
+
+    // Serves the latest snapshot to every client that connects to socketPath (HTTP GET or raw).
+    // Returns false where Unix domain sockets are unavailable or the socket cannot be bound.
+    bool startServer(const char* socketPath);
+    void stopServer();
+
+    // Appends one row per frame to path, with a header row.
+    bool openCsv(const char* path);
+
+    static std::string formatPrometheus(const TelemetrySnapshot& snapshot);
+
+private:
+    Telemetry() = default;
+    ~Telemetry();
+
+    mutable std::mutex m_snapshotMutex;
+    TelemetrySnapshot m_snapshot;
+    uint64_t m_totals[telemetry::kCounterCount] = {};
+
+    std::ofstream m_csv;
+
+    std::thread m_server;
+    std::atomic<bool> m_serverQuit{ false };
+    int m_listenFd = -1;
+    std::string m_socketPath;
+
+    void serverLoop();
+};
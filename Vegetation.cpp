@@ -0,0 +1,557 @@
+#include "Vegetation.hpp"
+#include "CameraUniforms.hpp"
+#include "ClusteredLighting.hpp"
+#include "Frustum.hpp"
+#include "Hash.hpp"
+#include "Heightfield.hpp"
+#include "JobSystem.hpp"
+#include "MeshPrimitives.hpp"
+#include "OcclusionCuller.hpp"
+#include "ShaderUtils.hpp"
+#include "Telemetry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <glm/gtc/type_ptr.hpp>
+
+static const char* vegetationVertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec3 aColor;
+layout(location = 3) in vec4 aInstance; // xyz position, w scale
+layout(location = 4) in float aYaw;
+
+uniform vec4 fade; // fade-in start/end, fade-out start/end (distance to the instance)
+
+out vec3 vNormal;
+out vec3 vColor;
+out float vAlpha;
+out vec3 vWorldPos;
+out float vViewDepth;
+
+void main()
+{
+    float d = distance(cameraPosition.xyz, aInstance.xyz);
+    float fadeIn = clamp((d - fade.x) / max(fade.y - fade.x, 0.001), 0.0, 1.0);
+    float fadeOut = 1.0 - clamp((d - fade.z) / max(fade.w - fade.z, 0.001), 0.0, 1.0);
+    vAlpha = fadeIn * fadeOut;
+    if (vAlpha <= 0.0) {
+        // Fully faded: move the vertex outside the clip volume so the triangle is dropped.
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
+    float c = cos(aYaw);
+    float s = sin(aYaw);
+    mat3 rotation = mat3(c, 0.0, -s, 0.0, 1.0, 0.0, s, 0.0, c);
+    vec3 world = aInstance.xyz + rotation * (aPos * aInstance.w);
+
+    vNormal = rotation * aNormal;
+    vColor = aColor * (0.85 + 0.15 * fract(aYaw * 7.31));
+    vWorldPos = world;
+    vec4 viewPos = view * vec4(world, 1.0);
+    vViewDepth = -viewPos.z;
+    gl_Position = projection * viewPos;
+}
+)";
+
+// Screen-door transparency: an ordered 4x4 dither keeps the fade in the opaque pass.
+// The far LOD uses the flipped pattern, so during a cross-fade the two LODs cover
+// complementary pixels instead of overlapping. Local lights come from ClusteredLighting.
+static const char* vegetationFragmentShaderSource = R"(
+#version 330 core
+in vec3 vNormal;
+in vec3 vColor;
+in float vAlpha;
+in vec3 vWorldPos;
+in float vViewDepth;
+out vec4 FragColor;
+
+uniform vec3 sunDir;
+uniform vec3 sunColor;
+uniform int ditherFlip;
+
+void main()
+{
+    float threshold = ditherThreshold();
+    if (ditherFlip != 0) threshold = 1.0 - threshold;
+    if (threshold >= vAlpha) discard;
+
+    vec3 normal = normalize(vNormal);
+    float diffuse = max(dot(normal, -sunDir), 0.0);
+    vec3 lights = clusteredPointLights(vWorldPos, normal, vViewDepth);
+    FragColor = vec4(vColor * (0.35 + 0.65 * diffuse * sunColor + lights), 1.0);
+}
+)";
+
+
+// Prop geometry. Every mesh stands on y = 0 at scale 1.
+using VegetationVertex = mesh::PosNormalColor;
+
+static constexpr mesh::Vec3 kTrunkColor = { 0.40f, 0.27f, 0.15f };
+static constexpr mesh::Vec3 kFoliageColor = { 0.16f, 0.38f, 0.14f };
+static constexpr mesh::Vec3 kRockColor = { 0.45f, 0.44f, 0.42f };
+
+static constexpr auto kTrunkMesh = mesh::cylinder<VegetationVertex, 6>(0.35f, 2.0f, kTrunkColor);
+static constexpr auto kFoliageMesh = mesh::cone<VegetationVertex, 12>(2.0f, 6.0f, kFoliageColor);
+static constexpr auto kFarTreeMesh = mesh::cone<VegetationVertex, 5>(2.0f, 7.0f, kFoliageColor);
+static constexpr auto kRockMesh = mesh::cone<VegetationVertex, 8>(1.4f, 1.6f, kRockColor);
+static constexpr auto kFarRockMesh = mesh::cone<VegetationVertex, 4>(1.4f, 1.6f, kRockColor);
+
+// Extents at scale 1, used for tile bounds.
+static constexpr float kTreeRadius = 2.0f;
+static constexpr float kTreeHeight = 8.0f;
+static constexpr float kRockRadius = 1.4f;
+static constexpr float kRockHeight = 1.6f;
+
+// Bump when the placement algorithm or cache layout changes.
+static constexpr uint32_t kCacheVersion = 1;
+static constexpr char kCacheMagic[8] = { 'I', 'S', 'L', 'V', 'E', 'G', '\0', '\0' };
+
+struct VegetationCacheHeader {
+    char magic[8];
+    uint64_t key;
+    uint32_t tileCount;
+    uint32_t instanceSize;
+};
+
+// Appends a mesh, lifted by yOffset, with indices relative to the first vertex of the current model.
+template <typename Mesh>
+static void appendMesh(const Mesh& part, float yOffset, size_t modelFirstVertex,
+                       std::vector<VegetationVertex>& vertices, std::vector<uint16_t>& indices) {
+    uint16_t base = static_cast<uint16_t>(vertices.size() - modelFirstVertex);
+    for (VegetationVertex vertex : part.vertices) {
+        vertex.position[1] += yOffset;
+        vertices.push_back(vertex);
+    }
+    for (uint16_t index : part.indices) {
+        indices.push_back(static_cast<uint16_t>(base + index));
+    }
+}
+
+static float saturate(float x) { return std::clamp(x, 0.0f, 1.0f); }
+
+static float smoothStep(float edge0, float edge1, float x) {
+    float t = saturate((x - edge0) / (edge1 - edge0));
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// 1 inside [low, high], ramping to 0 over `ramp` at both ends.
+static float heightBand(float h, float low, float high, float ramp) {
+    return saturate((h - low) / ramp) * saturate((high - h) / ramp);
+}
+
+// Bridson's Poisson-disk sampling over the rectangle [minX, maxX] x [minZ, maxZ]:
+// every emitted point is at least `radius` from every other one.
+template <typename Emit>
+static void poissonDisk(float minX, float minZ, float maxX, float maxZ, float radius, std::mt19937& rng, Emit&& emit) {
+    const int kAttempts = 30;
+    if (maxX <= minX || maxZ <= minZ || radius <= 0.0f) return;
+
+    const float cell = radius / std::sqrt(2.0f);
+    const int gridW = static_cast<int>(std::ceil((maxX - minX) / cell));
+    const int gridH = static_cast<int>(std::ceil((maxZ - minZ) / cell));
+    std::vector<int> grid(static_cast<size_t>(gridW) * gridH, -1);
+    std::vector<glm::vec2> points;
+    std::vector<int> active;
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    auto insert = [&](glm::vec2 p) {
+        int gx = std::min(static_cast<int>((p.x - minX) / cell), gridW - 1);
+        int gz = std::min(static_cast<int>((p.y - minZ) / cell), gridH - 1);
+        grid[static_cast<size_t>(gz) * gridW + gx] = static_cast<int>(points.size());
+        active.push_back(static_cast<int>(points.size()));
+        points.push_back(p);
+        emit(p.x, p.y);
+    };
+    auto farEnough = [&](glm::vec2 p) {
+        int gx = static_cast<int>((p.x - minX) / cell);
+        int gz = static_cast<int>((p.y - minZ) / cell);
+        for (int z = std::max(gz - 2, 0); z <= std::min(gz + 2, gridH - 1); ++z) {
+            for (int x = std::max(gx - 2, 0); x <= std::min(gx + 2, gridW - 1); ++x) {
+                int other = grid[static_cast<size_t>(z) * gridW + x];
+                if (other < 0) continue;
+                glm::vec2 d = points[other] - p;
+                if (d.x * d.x + d.y * d.y < radius * radius) return false;
+            }
+        }
+        return true;
+    };
+
+    insert(glm::vec2(minX + unit(rng) * (maxX - minX), minZ + unit(rng) * (maxZ - minZ)));
+    while (!active.empty()) {
+        size_t slot = static_cast<size_t>(unit(rng) * active.size()) % active.size();
+        glm::vec2 origin = points[active[slot]];
+        bool placed = false;
+        for (int attempt = 0; attempt < kAttempts && !placed; ++attempt) {
+            float angle = unit(rng) * 2.0f * mesh::kPi;
+            float distance = radius * (1.0f + unit(rng));
+            glm::vec2 candidate(origin.x + std::cos(angle) * distance, origin.y + std::sin(angle) * distance);
+            if (candidate.x < minX || candidate.x >= maxX || candidate.y < minZ || candidate.y >= maxZ) continue;
+            if (farEnough(candidate)) {
+                insert(candidate);
+                placed = true;
+            }
+        }
+        if (!placed) {
+            active[slot] = active.back();
+            active.pop_back();
+        }
+    }
+}
+
+
+Vegetation::Vegetation() {
+    std::string vertexSource = withShaderLibrary(vegetationVertexShaderSource, CameraUniforms::shaderLibrary());
+    std::string fragmentLibrary = std::string(ClusteredLighting::shaderLibrary()) + ditherShaderLibrary();
+    std::string fragmentSource = withShaderLibrary(vegetationFragmentShaderSource, fragmentLibrary.c_str());
+    m_program = GLProgram::adopt(createShaderProgram(vertexSource.c_str(), fragmentSource.c_str()), "Vegetation");
+    if (!m_program) {
+        std::cerr << "Failed to create vegetation shader program." << std::endl;
+    } else {
+        CameraUniforms::setupProgram(m_program.id());
+        ClusteredLighting::setupProgram(m_program.id());
+        m_fadeLoc = glGetUniformLocation(m_program.id(), "fade");
+        m_ditherFlipLoc = glGetUniformLocation(m_program.id(), "ditherFlip");
+        m_sunDirLoc = glGetUniformLocation(m_program.id(), "sunDir");
+        m_sunColorLoc = glGetUniformLocation(m_program.id(), "sunColor");
+    }
+    createMeshes();
+}
+
+Vegetation::~Vegetation() = default;
+
+void Vegetation::createMeshes() {
+    std::vector<VegetationVertex> vertices;
+    std::vector<uint16_t> indices;
+
+    // Each model is its own index range addressed through a base vertex.
+    auto beginModel = [&](MeshRange& range) {
+        range.baseVertex = static_cast<GLint>(vertices.size());
+        range.indexOffset = static_cast<GLintptr>(indices.size() * sizeof(uint16_t));
+        return vertices.size();
+    };
+    auto endModel = [&](MeshRange& range) {
+        range.indexCount = static_cast<GLsizei>(indices.size() - range.indexOffset / sizeof(uint16_t));
+    };
+
+    MeshRange& detailTree = m_meshes[KindTree][LodDetail];
+    size_t first = beginModel(detailTree);
+    appendMesh(kTrunkMesh, 1.0f, first, vertices, indices);
+    appendMesh(kFoliageMesh, 5.0f, first, vertices, indices);
+    endModel(detailTree);
+
+    MeshRange& farTree = m_meshes[KindTree][LodFar];
+    first = beginModel(farTree);
+    appendMesh(kFarTreeMesh, 4.5f, first, vertices, indices);
+    endModel(farTree);
+
+    MeshRange& detailRock = m_meshes[KindRock][LodDetail];
+    first = beginModel(detailRock);
+    appendMesh(kRockMesh, 0.8f, first, vertices, indices);
+    endModel(detailRock);
+
+    MeshRange& farRock = m_meshes[KindRock][LodFar];
+    first = beginModel(farRock);
+    appendMesh(kFarRockMesh, 0.8f, first, vertices, indices);
+    endModel(farRock);
+
+    m_vao = GLVertexArray::create("Vegetation");
+    m_vbo = GLBuffer::create("Vegetation");
+    m_ibo = GLBuffer::create("Vegetation");
+
+    glBindVertexArray(m_vao.id());
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo.id());
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VegetationVertex), vertices.data(), GL_STATIC_DRAW);
+    m_vbo.setStorage(vertices.size() * sizeof(VegetationVertex), "pos3 normal3 color3 float");
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo.id());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    m_ibo.setStorage(indices.size() * sizeof(uint16_t), "u16 indices");
+    telemetry::add(telemetry::Counter::BytesUploaded, vertices.size() * sizeof(VegetationVertex) + indices.size() * sizeof(uint16_t));
+
+    for (const mesh::VertexAttribute& attribute : mesh::VertexFormat<VegetationVertex>::attributes) {
+        glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, sizeof(VegetationVertex), (void*)attribute.offset);
+        glEnableVertexAttribArray(attribute.location);
+    }
+
+    // Instance attributes; their pointers are set per tile in draw().
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    glEnableVertexAttribArray(4);
+    glVertexAttribDivisor(4, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void Vegetation::setSun(const glm::vec3& direction, const glm::vec3& color) {
+    m_sunDirection = glm::normalize(direction);
+    m_sunColor = color;
+}
+
+bool Vegetation::generate(const Heightfield& heightfield, const ScatterRules& rules, const char* cachePath) {
+    m_tiles.clear();
+    m_instanceCount = 0;
+    if (!heightfield.isValid()) return false;
+
+    const int tilesX = (heightfield.width() - 1 + kTileTexels - 1) / kTileTexels;
+    const int tilesZ = (heightfield.depth() - 1 + kTileTexels - 1) / kTileTexels;
+
+    uint64_t key = heightfield.contentHash();
+    const float ruleValues[] = { rules.seaLevel, rules.sandTop, rules.grassTop, rules.slopeRockStart,
+                                 rules.treeSpacing, rules.treeDensity, rules.rockSpacing, rules.rockDensity };
+    key = fnv1a(ruleValues, sizeof(ruleValues), key);
+    key = fnv1a(&rules.seed, sizeof(rules.seed), key);
+    const int layout[] = { kTileTexels, static_cast<int>(kCacheVersion), static_cast<int>(sizeof(Instance)) };
+    key = fnv1a(layout, sizeof(layout), key);
+
+    auto start = std::chrono::steady_clock::now();
+    bool cached = cachePath && loadCache(cachePath, key) && m_tiles.size() == static_cast<size_t>(tilesX) * tilesZ;
+    if (!cached) {
+        scatterTiles(heightfield, rules, tilesX, tilesZ);
+        if (cachePath) writeCache(cachePath, key);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (const Tile& tile : m_tiles) {
+        m_instanceCount += tile.instances.size();
+    }
+    std::cout << "Vegetation: " << m_instanceCount << " instances in " << m_tiles.size() << " tiles ("
+              << (cached ? "loaded from cache" : "generated") << " in " << std::fixed << std::setprecision(1) << ms << " ms)" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    return m_instanceCount > 0;
+}
+
+void Vegetation::scatterTiles(const Heightfield& heightfield, const ScatterRules& rules, int tilesX, int tilesZ) {
+    m_tiles.clear();
+    m_tiles.resize(static_cast<size_t>(tilesX) * tilesZ);
+
+    // Tiles are independent; one job each keeps the uneven ones from holding up a whole range.
+    const int tileCount = tilesX * tilesZ;
+    JobSystem::instance().parallelFor("Vegetation tiles", tileCount, /*grain=*/1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            scatterTile(heightfield, rules, i % tilesX, i / tilesX, m_tiles[i]);
+        }
+    });
+}
+
+void Vegetation::scatterTile(const Heightfield& heightfield, const ScatterRules& rules, int tileX, int tileZ, Tile& tile) {
+    const int x0 = tileX * kTileTexels;
+    const int z0 = tileZ * kTileTexels;
+    const glm::vec3 tileMin = heightfield.positionAt(x0, z0);
+    const glm::vec3 tileMax = heightfield.positionAt(std::min(x0 + kTileTexels, heightfield.width() - 1),
+                                                     std::min(z0 + kTileTexels, heightfield.depth() - 1));
+    const float grassRamp = std::max((rules.grassTop - rules.sandTop) * 0.1f, 0.001f);
+
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+
+    for (int kind = 0; kind < KindCount; ++kind) {
+        const float spacing = (kind == KindTree) ? rules.treeSpacing : rules.rockSpacing;
+        const float radius = (kind == KindTree) ? kTreeRadius : kRockRadius;
+        const float height = (kind == KindTree) ? kTreeHeight : kRockHeight;
+
+        // Deterministic per tile and kind, so the result does not depend on thread scheduling.
+        const uint32_t ids[] = { rules.seed, static_cast<uint32_t>(tileX), static_cast<uint32_t>(tileZ), static_cast<uint32_t>(kind) };
+        std::mt19937 rng(static_cast<uint32_t>(fnv1a(ids, sizeof(ids))));
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        // Insetting every tile by half the spacing keeps the minimum distance across tile borders too.
+        const float inset = spacing * 0.5f;
+        poissonDisk(tileMin.x + inset, tileMin.z + inset, tileMax.x - inset, tileMax.z - inset, spacing, rng,
+            [&](float x, float z) {
+                float h = heightfield.sampleHeight(x, z);
+                if (h <= rules.seaLevel) return;
+                float slope = 1.0f - heightfield.sampleNormal(x, z).y;
+
+                float grass = heightBand(h, rules.sandTop, rules.grassTop, grassRamp);
+                float chance;
+                if (kind == KindTree) {
+                    chance = rules.treeDensity * grass * (1.0f - smoothStep(rules.slopeRockStart * 0.6f, rules.slopeRockStart, slope));
+                } else {
+                    float rocky = std::max(smoothStep(rules.slopeRockStart * 0.8f, rules.slopeRockStart * 1.2f, slope),
+                                           smoothStep(rules.grassTop - 10.0f, rules.grassTop + 10.0f, h));
+                    chance = rules.rockDensity * std::max(rocky, 0.1f * grass);
+                }
+                if (unit(rng) >= chance) return;
+
+                Instance instance;
+                instance.scale = (kind == KindTree) ? 0.8f + 0.6f * unit(rng) : 0.5f + unit(rng);
+                instance.x = x;
+                instance.y = h - 0.2f * instance.scale; // sink slightly so slopes don't show the base
+                instance.z = z;
+                instance.yaw = unit(rng) * 2.0f * mesh::kPi;
+                tile.instances.push_back(instance);
+                tile.count[kind]++;
+
+                float r = radius * instance.scale;
+                boundsMin = glm::min(boundsMin, glm::vec3(x - r, instance.y, z - r));
+                boundsMax = glm::max(boundsMax, glm::vec3(x + r, instance.y + height * instance.scale, z + r));
+            });
+    }
+
+    tile.bounds = tile.instances.empty() ? AABB{ glm::vec3(0.0f), glm::vec3(0.0f) } : AABB{ boundsMin, boundsMax };
+}
+
+bool Vegetation::loadCache(const char* path, uint64_t key) {
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    if (!stream.is_open()) return false;
+
+    VegetationCacheHeader header;
+    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+        header.key != key || header.instanceSize != sizeof(Instance)) {
+        std::cout << "Vegetation cache " << path << " is stale, regenerating." << std::endl;
+        return false;
+    }
+
+    m_tiles.resize(header.tileCount);
+    for (Tile& tile : m_tiles) {
+        float bounds[6];
+        stream.read(reinterpret_cast<char*>(bounds), sizeof(bounds));
+        stream.read(reinterpret_cast<char*>(tile.count), sizeof(tile.count));
+        if (!stream) break;
+        tile.bounds = { glm::vec3(bounds[0], bounds[1], bounds[2]), glm::vec3(bounds[3], bounds[4], bounds[5]) };
+        tile.instances.resize(static_cast<size_t>(tile.count[KindTree]) + tile.count[KindRock]);
+        stream.read(reinterpret_cast<char*>(tile.instances.data()), tile.instances.size() * sizeof(Instance));
+    }
+    if (!stream) {
+        std::cerr << "Vegetation cache " << path << " is truncated, regenerating." << std::endl;
+        m_tiles.clear();
+        return false;
+    }
+    return true;
+}
+
+void Vegetation::writeCache(const char* path, uint64_t key) const {
+    std::ofstream stream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        std::cerr << "Failed to write vegetation cache: " << path << std::endl;
+        return;
+    }
+
+    VegetationCacheHeader header;
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.key = key;
+    header.tileCount = static_cast<uint32_t>(m_tiles.size());
+    header.instanceSize = sizeof(Instance);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const Tile& tile : m_tiles) {
+        const float bounds[6] = { tile.bounds.min.x, tile.bounds.min.y, tile.bounds.min.z,
+                                  tile.bounds.max.x, tile.bounds.max.y, tile.bounds.max.z };
+        stream.write(reinterpret_cast<const char*>(bounds), sizeof(bounds));
+        stream.write(reinterpret_cast<const char*>(tile.count), sizeof(tile.count));
+        stream.write(reinterpret_cast<const char*>(tile.instances.data()), tile.instances.size() * sizeof(Instance));
+    }
+}
+
+void Vegetation::upload() {
+    for (Tile& tile : m_tiles) {
+        if (tile.instances.empty()) continue;
+
+        size_t bytes = tile.instances.size() * sizeof(Instance);
+        tile.buffer = GLBuffer::create("Vegetation");
+        glBindBuffer(GL_ARRAY_BUFFER, tile.buffer.id());
+        glBufferData(GL_ARRAY_BUFFER, bytes, tile.instances.data(), GL_STATIC_DRAW);
+        tile.buffer.setStorage(bytes, "instances pos3 scale yaw");
+        telemetry::add(telemetry::Counter::BytesUploaded, bytes);
+
+        // The GPU copy is all draw() needs.
+        std::vector<Instance>().swap(tile.instances);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Vegetation::draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, OcclusionCuller* culler) {
+    m_frameStats = VegetationStats();
+    if (!m_program || m_tiles.empty()) return;
+
+    const Frustum frustum(projection * view);
+    const float detailFadeStart = m_lod.detailDistance - m_lod.fadeBand;
+    const glm::vec4 lodFade[LodCount] = {
+        glm::vec4(-2.0f, -1.0f, detailFadeStart, m_lod.detailDistance),
+        glm::vec4(detailFadeStart, m_lod.detailDistance, m_lod.drawDistance - m_lod.fadeBand, m_lod.drawDistance),
+    };
+
+    glUseProgram(m_program.id());
+    glUniform3fv(m_sunDirLoc, 1, glm::value_ptr(m_sunDirection));
+    glUniform3fv(m_sunColorLoc, 1, glm::value_ptr(m_sunColor));
+    glBindVertexArray(m_vao.id());
+    telemetry::add(telemetry::Counter::StateChanges, 2);
+
+    for (const Tile& tile : m_tiles) {
+        if (!tile.buffer) continue;
+
+        // Distance range from the camera to the tile's box decides which LODs can appear in it.
+        glm::vec3 closest = glm::clamp(cameraPos, tile.bounds.min, tile.bounds.max);
+        glm::vec3 farthest(cameraPos.x < tile.bounds.center().x ? tile.bounds.max.x : tile.bounds.min.x,
+                           cameraPos.y < tile.bounds.center().y ? tile.bounds.max.y : tile.bounds.min.y,
+                           cameraPos.z < tile.bounds.center().z ? tile.bounds.max.z : tile.bounds.min.z);
+        float nearest = glm::length(closest - cameraPos);
+        float farthestDistance = glm::length(farthest - cameraPos);
+        const bool lodVisible[LodCount] = {
+            nearest < m_lod.detailDistance,
+            farthestDistance > detailFadeStart && nearest < m_lod.drawDistance,
+        };
+
+        if ((!lodVisible[LodDetail] && !lodVisible[LodFar]) || !frustum.intersects(tile.bounds) ||
+            (culler && !culler->isVisible(tile.bounds))) {
+            m_frameStats.tilesCulled++;
+            continue;
+        }
+        m_frameStats.tilesDrawn++;
+
+        glBindBuffer(GL_ARRAY_BUFFER, tile.buffer.id());
+        telemetry::add(telemetry::Counter::StateChanges);
+        size_t firstInstance = 0;
+        for (int kind = 0; kind < KindCount; ++kind) {
+            GLsizei count = static_cast<GLsizei>(tile.count[kind]);
+            if (count == 0) continue;
+
+            size_t base = firstInstance * sizeof(Instance);
+            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(base + offsetof(Instance, x)));
+            glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(base + offsetof(Instance, yaw)));
+
+            for (int lod = 0; lod < LodCount; ++lod) {
+                if (!lodVisible[lod]) continue;
+                const MeshRange& range = m_meshes[kind][lod];
+                glUniform4fv(m_fadeLoc, 1, glm::value_ptr(lodFade[lod]));
+                glUniform1i(m_ditherFlipLoc, lod == LodFar ? 1 : 0);
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_SHORT,
+                                                  (void*)range.indexOffset, count, range.baseVertex);
+                telemetry::countDraw(static_cast<uint64_t>(range.indexCount / 3) * count);
+                m_frameStats.drawCalls++;
+                m_frameStats.instancesDrawn += count;
+            }
+            firstInstance += count;
+        }
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    m_totalInstancesDrawn += m_frameStats.instancesDrawn;
+    m_totalDrawCalls += m_frameStats.drawCalls;
+    m_frames++;
+}
+
+void Vegetation::printStats() const {
+    if (m_frames == 0) return;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Vegetation: " << m_instanceCount << " instances in " << m_tiles.size() << " tiles, "
+              << (static_cast<double>(m_totalInstancesDrawn) / m_frames) << " instances and "
+              << (static_cast<double>(m_totalDrawCalls) / m_frames) << " draw calls per frame on average" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "AABB.hpp"
+#include "GLResource.hpp"
+
+class Heightfield;
+class OcclusionCuller;
+
+// Where props may grow. The bands mean the same as Island::setBlendParams, so the
+// same values should be passed to both; slope is 1 - normal.y.
+struct ScatterRules {
+    float seaLevel = 0.0f;
+    float sandTop = 30.0f;
+    float grassTop = 100.0f;
+    float slopeRockStart = 0.5f;
+
+    float treeSpacing = 6.0f;  // minimum distance between two trees, world units
+    float treeDensity = 0.8f;  // chance that a sample in the grass band becomes a tree
+    float rockSpacing = 10.0f;
+    float rockDensity = 0.6f;  // chance on rocky ground; a tenth of that on grass
+    uint32_t seed = 1;
+};
+
+// Distances from the camera, world units.
+struct VegetationLod {
+    float detailDistance = 250.0f; // full-detail meshes inside this, low-poly meshes outside
+    float fadeBand = 40.0f;        // width of the dithered cross-fade at each transition
+    float drawDistance = 1200.0f;  // instances have faded out completely here
+};
+
+struct VegetationStats {
+    uint32_t tilesDrawn = 0;
+    uint32_t tilesCulled = 0;
+    uint32_t drawCalls = 0;
+    uint64_t instancesDrawn = 0;
+};
+
+// Trees and rocks scattered over the island.
+// Placement is Poisson-disk sampled per terrain tile, with tiles generated in parallel and the
+// result cached on disk. Each tile owns a static instance buffer; at draw time whole tiles are
+// frustum/occlusion culled and drawn with one instanced call per prop kind and LOD.
+class Vegetation {
+public:
+    // Tile edge length in heightfield texels.
+    static constexpr int kTileTexels = 128;
+
+    Vegetation();
+    ~Vegetation();
+
+    Vegetation(const Vegetation&) = delete;
+    Vegetation& operator=(const Vegetation&) = delete;
+
+    // Loads placements from cachePath if it was built from the same heightfield and rules,
+    // otherwise scatters them and rewrites the cache. Returns false if nothing could be placed.
+    // Makes no GL calls, so it may run on a job; upload() then creates the buffers.
+    bool generate(const Heightfield& heightfield, const ScatterRules& rules, const char* cachePath);
+    // One instance buffer per tile; the CPU copies are released. GL thread only.
+    void upload();
+
+    void setLod(const VegetationLod& lod) { m_lod = lod; }
+    void setSun(const glm::vec3& direction, const glm::vec3& color);
+
+    // culler may be null; if given, its beginFrame() must already have been called this frame.
+    void draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, OcclusionCuller* culler);
+
+    uint64_t instanceCount() const { return m_instanceCount; }
+    const VegetationStats& frameStats() const { return m_frameStats; }
+    void printStats() const;
+
+private:
+    enum Kind { KindTree, KindRock, KindCount };
+    enum Lod { LodDetail, LodFar, LodCount };
+
+    // Per-instance vertex attributes: position and uniform scale, then rotation about Y.
+    struct Instance {
+        float x, y, z, scale;
+        float yaw;
+    };
+
+    struct Tile {
+        AABB bounds;
+        uint32_t count[KindCount] = {};
+        std::vector<Instance> instances; // all trees, then all rocks; released after upload
+        GLBuffer buffer;
+    };
+
+    struct MeshRange {
+        GLsizei indexCount = 0;
+        GLintptr indexOffset = 0;
+        GLint baseVertex = 0;
+    };
+
+    GLProgram m_program;
+    GLint m_fadeLoc = -1;
+    GLint m_ditherFlipLoc = -1;
+    GLint m_sunDirLoc = -1;
+    GLint m_sunColorLoc = -1;
+
+    GLVertexArray m_vao;
+    GLBuffer m_vbo;
+    GLBuffer m_ibo;
+    MeshRange m_meshes[KindCount][LodCount];
+
+    std::vector<Tile> m_tiles;
+    uint64_t m_instanceCount = 0;
+    VegetationLod m_lod;
+    glm::vec3 m_sunDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 m_sunColor = glm::vec3(1.0f);
+
+    VegetationStats m_frameStats;
+    uint64_t m_totalInstancesDrawn = 0;
+    uint64_t m_totalDrawCalls = 0;
+    uint32_t m_frames = 0;
+
+    void createMeshes();
+    void scatterTiles(const Heightfield& heightfield, const ScatterRules& rules, int tilesX, int tilesZ);
+    static void scatterTile(const Heightfield& heightfield, const ScatterRules& rules, int tileX, int tileZ, Tile& tile);
+    bool loadCache(const char* path, uint64_t key);
+    void writeCache(const char* path, uint64_t key) const;
+};
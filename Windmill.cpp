@@ -1,15 +1,18 @@
 #include "Windmill.hpp"
+#include "CameraUniforms.hpp"
+#include "MeshPrimitives.hpp"
+#include "Telemetry.hpp"
+#include "AssetBundle.hpp"
+#include <cstring>
 #include <iostream>
-#include <vector>
 #include <GL/glew.h>
 #include <stb_image.h>
 
 
 // Function to load a texture
-GLuint loadTexture(const char* path) {
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+GLTexture loadTexture(const char* path, const char* owner) {
+    GLTexture texture = GLTexture::create(owner);
+    glBindTexture(GL_TEXTURE_2D, texture.id());
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -17,7 +20,7 @@ GLuint loadTexture(const char* path) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     int width, height, nrChannels;
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
+    unsigned char* data = loadImage(path, &width, &height, &nrChannels, 0);
     if (data) {
         GLenum format;
         if (nrChannels == 1) format = GL_RED;
@@ -25,247 +28,149 @@ GLuint loadTexture(const char* path) {
         else if (nrChannels == 4) format = GL_RGBA;
 
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        telemetry::add(telemetry::Counter::BytesUploaded, static_cast<uint64_t>(width) * height * nrChannels);
         glGenerateMipmap(GL_TEXTURE_2D);
-        std::cout << "Texture loaded: " << path << " (ID: " << textureID << ", " << width << "x" << height << "px)" << std::endl;
+        texture.setStorage(glTextureBytes(format, width, height, 1, true), "2D mipmapped");
+        std::cout << "Texture loaded: " << path << " (ID: " << texture.id() << ", " << width << "x" << height << "px)" << std::endl;
     } else {
         std::cerr << "Failed to load texture: " << path << std::endl;
     }
     stbi_image_free(data);
-    return textureID;
+    return texture;
 }
 
 
-// Helper function to create vertex data for a colored cube
-std::vector<float> createCubeVertices(glm::vec3 color) {
-    return {
-        // positions          // colors          // texture coords
-        // Back face
-        -0.5f, -0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 0.0f,
-         0.5f, -0.5f, -0.5f,  color.x, color.y, color.z,  2.0f, 0.0f,
-         0.5f,  0.5f, -0.5f,  color.x, color.y, color.z,  2.0f, 1.0f,
-         0.5f,  0.5f, -0.5f,  color.x, color.y, color.z,  2.0f, 1.0f,
-        -0.5f,  0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 0.0f,
-
-        // Front face
-        -0.5f, -0.5f,  0.5f,  color.x, color.y, color.z,  0.0f, 0.0f,
-         0.5f, -0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 1.0f,
-         0.5f,  0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 1.0f,
-        -0.5f,  0.5f,  0.5f,  color.x, color.y, color.z,  0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  color.x, color.y, color.z,  0.0f, 0.0f,
-
-        // Left Face
-        -0.5f,  0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  color.x, color.y, color.z,  2.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  color.x, color.y, color.z,  0.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 0.0f,
-
-        // Right Face
-         0.5f,  0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 0.0f,
-         0.5f,  0.5f, -0.5f,  color.x, color.y, color.z,  2.0f, 1.0f,
-         0.5f, -0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 1.0f,
-         0.5f, -0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 1.0f,
-         0.5f, -0.5f,  0.5f,  color.x, color.y, color.z,  0.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 0.0f,
-
-        // Bottom Face
-        -0.5f, -0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 2.0f,
-         0.5f, -0.5f, -0.5f,  color.x, color.y, color.z,  2.0f, 2.0f,
-         0.5f, -0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 0.0f,
-         0.5f, -0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 0.0f,
-        -0.5f, -0.5f,  0.5f,  color.x, color.y, color.z,  0.0f, 0.0f,
-        -0.5f, -0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 2.0f,
-
-        // Top Face
-        -0.5f,  0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 1.0f,
-         0.5f,  0.5f, -0.5f,  color.x, color.y, color.z,  2.0f, 1.0f,
-         0.5f,  0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 0.0f,
-         0.5f,  0.5f,  0.5f,  color.x, color.y, color.z,  2.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  color.x, color.y, color.z,  0.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  color.x, color.y, color.z,  0.0f, 1.0f
-    };
-}
+// Part geometry, generated at compile time into static storage.
+using WindmillVertex = mesh::PosColorUV;
 
-// Helper function to create vertex data for a colored blade
-std::vector<float> createBladeVertices(glm::vec3 color) {
-    return {
-        // positions          // colors          // texture coords
-        -0.05f, -0.5f, 0.0f,  color.x, color.y, color.z,  0.0f, 0.0f,
-         0.05f, -0.5f, 0.0f,  color.x, color.y, color.z,  1.0f, 0.0f,
-         0.05f,  0.5f, 0.0f,  color.x, color.y, color.z,  1.0f, 1.0f,
-
-        -0.05f, -0.5f, 0.0f,  color.x, color.y, color.z,  0.0f, 0.0f,
-         0.05f,  0.5f, 0.0f,  color.x, color.y, color.z,  1.0f, 1.0f,
-        -0.05f,  0.5f, 0.0f,  color.x, color.y, color.z,  0.0f, 1.0f
-    };
-}
+static constexpr auto kBaseMesh = mesh::box<WindmillVertex>({
+    /*size=*/{ 3.0f, 15.0f, 3.0f }, /*color=*/{ 0.6f, 0.4f, 0.2f },
+    /*sideUV=*/{ 2.0f, 5.0f }, /*bottomUV=*/{ 2.0f, 2.0f }, /*topUV=*/{ 2.0f, 1.0f } });
+
+static constexpr auto kHeadMesh = mesh::box<WindmillVertex>({
+    /*size=*/{ 1.0f, 1.0f, 1.0f }, /*color=*/{ 0.7f, 0.7f, 0.7f },
+    /*sideUV=*/{ 2.0f, 1.0f }, /*bottomUV=*/{ 2.0f, 2.0f }, /*topUV=*/{ 2.0f, 1.0f } });
+
+static constexpr auto kBladeMesh = mesh::blade<WindmillVertex>(0.1f, 1.0f, { 0.5f, 0.5f, 0.5f });
+
+static constexpr size_t kTotalVertices = kBaseMesh.kVertexCount + kHeadMesh.kVertexCount + kBladeMesh.kVertexCount;
+static constexpr size_t kTotalIndices = kBaseMesh.kIndexCount + kHeadMesh.kIndexCount + kBladeMesh.kIndexCount;
 
 
 Windmill::Windmill()
     : m_shaderProgram(0),
-      m_baseVAO(0), m_baseVBO(0),
-      m_headVAO(0), m_headVBO(0),
-      m_bladesVAO(0), m_bladesVBO(0),
-      m_baseTextureID(0), m_whiteTextureID(0)
+      m_position(-625.73f, 53.98f, -350.15f),
+      m_scale(4.0f)
 {
 }
 
-Windmill::~Windmill() {
-    glDeleteVertexArrays(1, &m_baseVAO);
-    glDeleteBuffers(1, &m_baseVBO);
-    glDeleteVertexArrays(1, &m_headVAO);
-    glDeleteBuffers(1, &m_headVBO);
-    glDeleteVertexArrays(1, &m_bladesVAO);
-    glDeleteBuffers(1, &m_bladesVBO);
-    glDeleteTextures(1, &m_baseTextureID);
-    glDeleteTextures(1, &m_whiteTextureID);
-}
-
-void Windmill::setupPart(GLuint& vao, GLuint& vbo, const std::vector<float>& vertices) {
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-    GLsizei stride = 8 * sizeof(float);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+Windmill::~Windmill() = default;
+
+template <typename Mesh>
+Windmill::MeshRange Windmill::uploadPart(const Mesh& part, size_t& vertexCursor, size_t& indexCursor) {
+    MeshRange range;
+    range.indexCount = static_cast<GLsizei>(part.kIndexCount);
+    range.indexOffset = static_cast<GLintptr>(indexCursor * sizeof(uint16_t));
+    range.baseVertex = static_cast<GLint>(vertexCursor);
+
+    glBufferSubData(GL_ARRAY_BUFFER, vertexCursor * sizeof(typename Mesh::Vertex), sizeof(part.vertices), part.vertices.data());
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexCursor * sizeof(uint16_t), sizeof(part.indices), part.indices.data());
+    vertexCursor += part.kVertexCount;
+    indexCursor += part.kIndexCount;
+    telemetry::add(telemetry::Counter::BytesUploaded, sizeof(part.vertices) + sizeof(part.indices));
+    return range;
 }
 
 void Windmill::setup(GLuint shaderProgram) {
     m_shaderProgram = shaderProgram;
+    CameraUniforms::setupProgram(m_shaderProgram);
+    m_textureSamplerLoc = glGetUniformLocation(m_shaderProgram, "textureSampler");
+    m_fadeLoc = glGetUniformLocation(m_shaderProgram, "fade");
+    GLuint objectBlock = glGetUniformBlockIndex(m_shaderProgram, "ObjectBlock");
+    if (objectBlock != GL_INVALID_INDEX) {
+        glUniformBlockBinding(m_shaderProgram, objectBlock, kObjectBlockBinding);
+    } else {
+        std::cerr << "Windmill shader has no ObjectBlock uniform block." << std::endl;
+    }
 
     // --- Load Textures ---
-    m_baseTextureID = loadTexture("assets/bricks.jpg");
+    m_baseTexture = loadTexture("assets/bricks.jpg", "Windmill");
 
-    glGenTextures(1, &m_whiteTextureID);
-    glBindTexture(GL_TEXTURE_2D, m_whiteTextureID);
+    m_whiteTexture = GLTexture::create("Windmill");
+    glBindTexture(GL_TEXTURE_2D, m_whiteTexture.id());
     unsigned char whitePixel[] = { 255, 255, 255, 255 };
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
+    m_whiteTexture.setStorage(sizeof(whitePixel), "RGBA8");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    std::cout << "White texture created (ID: " << m_whiteTextureID << ")" << std::endl;
-
-
-    float baseWidthDepth = 3.0f;
-    float baseHeight = 15.0f;
-    glm::vec3 baseColor = glm::vec3(0.6f, 0.4f, 0.2f);
-
-    std::vector<float> baseVertices = {
-        // positions                                  // colors          // texture coords (U, V)
-        // Back face (Z = -baseWidthDepth/2)
-        -baseWidthDepth/2.0f, -baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 0.0f,
-         baseWidthDepth/2.0f, -baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 0.0f,
-         baseWidthDepth/2.0f,  baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 5.0f,
-         baseWidthDepth/2.0f,  baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 5.0f,
-        -baseWidthDepth/2.0f,  baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 5.0f,
-        -baseWidthDepth/2.0f, -baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 0.0f,
-
-        // Front face (Z = baseWidthDepth/2)
-        -baseWidthDepth/2.0f, -baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 0.0f,
-         baseWidthDepth/2.0f, -baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 0.0f,
-         baseWidthDepth/2.0f,  baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 5.0f,
-         baseWidthDepth/2.0f,  baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 5.0f,
-        -baseWidthDepth/2.0f,  baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 5.0f,
-        -baseWidthDepth/2.0f, -baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 0.0f,
-
-        // Left face (X = -baseWidthDepth/2)
-        -baseWidthDepth/2.0f,  baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 0.0f,
-        -baseWidthDepth/2.0f,  baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 5.0f,
-        -baseWidthDepth/2.0f, -baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 5.0f,
-        -baseWidthDepth/2.0f, -baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 5.0f,
-        -baseWidthDepth/2.0f, -baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 0.0f,
-        -baseWidthDepth/2.0f,  baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 0.0f,
-
-        // Right face (X = baseWidthDepth/2)
-         baseWidthDepth/2.0f,  baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 0.0f,
-         baseWidthDepth/2.0f,  baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 5.0f,
-         baseWidthDepth/2.0f, -baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 5.0f,
-         baseWidthDepth/2.0f, -baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 5.0f,
-         baseWidthDepth/2.0f, -baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 0.0f,
-         baseWidthDepth/2.0f,  baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 0.0f,
-
-        // Bottom face (Y = -baseHeight/2)
-        -baseWidthDepth/2.0f, -baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 2.0f,
-         baseWidthDepth/2.0f, -baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 2.0f,
-         baseWidthDepth/2.0f, -baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 0.0f,
-         baseWidthDepth/2.0f, -baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 0.0f,
-        -baseWidthDepth/2.0f, -baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 0.0f,
-        -baseWidthDepth/2.0f, -baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 2.0f,
-
-        // Top face (Y = baseHeight/2)
-        -baseWidthDepth/2.0f,  baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 1.0f,
-         baseWidthDepth/2.0f,  baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 1.0f,
-         baseWidthDepth/2.0f,  baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 0.0f,
-         baseWidthDepth/2.0f,  baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  2.0f, 0.0f,
-        -baseWidthDepth/2.0f,  baseHeight/2.0f,  baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 0.0f,
-        -baseWidthDepth/2.0f,  baseHeight/2.0f, -baseWidthDepth/2.0f,  baseColor.x, baseColor.y, baseColor.z,  0.0f, 1.0f
-    };
-    setupPart(m_baseVAO, m_baseVBO, baseVertices);
-
-
-    std::vector<float> headVertices = createCubeVertices(glm::vec3(0.7f, 0.7f, 0.7f));
-    setupPart(m_headVAO, m_headVBO, headVertices);
+    std::cout << "White texture created (ID: " << m_whiteTexture.id() << ")" << std::endl;
+
+
+    // --- Geometry ---
+    // All parts share one vertex and one index buffer; draws select a part with a base vertex.
+    m_vao = GLVertexArray::create("Windmill");
+    m_vbo = GLBuffer::create("Windmill");
+    m_ibo = GLBuffer::create("Windmill");
+
+    glBindVertexArray(m_vao.id());
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo.id());
+    glBufferData(GL_ARRAY_BUFFER, kTotalVertices * sizeof(WindmillVertex), nullptr, GL_STATIC_DRAW);
+    m_vbo.setStorage(kTotalVertices * sizeof(WindmillVertex), "pos3 color3 uv2 float");
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo.id());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, kTotalIndices * sizeof(uint16_t), nullptr, GL_STATIC_DRAW);
+    m_ibo.setStorage(kTotalIndices * sizeof(uint16_t), "u16 indices");
+
+    size_t vertexCursor = 0;
+    size_t indexCursor = 0;
+    m_baseRange = uploadPart(kBaseMesh, vertexCursor, indexCursor);
+    m_headRange = uploadPart(kHeadMesh, vertexCursor, indexCursor);
+    m_bladeRange = uploadPart(kBladeMesh, vertexCursor, indexCursor);
+
+    for (const mesh::VertexAttribute& attribute : mesh::VertexFormat<WindmillVertex>::attributes) {
+        glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, sizeof(WindmillVertex), (void*)attribute.offset);
+        glEnableVertexAttribArray(attribute.location);
+    }
 
-    std::vector<float> bladeVertices = createBladeVertices(glm::vec3(0.5f, 0.5f, 0.5f));
-    setupPart(m_bladesVAO, m_bladesVBO, bladeVertices);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     std::cout << "Windmill setup complete." << std::endl;
 }
 
-void Windmill::draw(const glm::mat4& view, const glm::mat4& projection, float currentTime) {
-    if (m_shaderProgram == 0) {
-        std::cerr << "Warning: Windmill shader program not set." << std::endl;
-        return;
-    }
-
-    glUseProgram(m_shaderProgram);
-
-    GLint modelLoc = glGetUniformLocation(m_shaderProgram, "model");
-    GLint viewLoc = glGetUniformLocation(m_shaderProgram, "view");
-    GLint projLoc = glGetUniformLocation(m_shaderProgram, "projection");
-    GLint textureSamplerLoc = glGetUniformLocation(m_shaderProgram, "textureSampler");
+AABB Windmill::worldBounds(const glm::vec3& position) const {
+    // In base-local units the tower spans y in [-7.5, 7.5]. The head is centered at y = 8.75 and
+    // scaled by (3, 2.5, 3); the blades reach 2.5 head units from a hub 1 unit in front of it,
+    // i.e. up to sqrt(7.5^2 + 3^2) ~= 8.1 horizontally and 8.75 + 6.25 = 15 vertically.
+    const glm::vec3 localMin(-8.5f, -7.5f, -8.5f);
+    const glm::vec3 localMax(8.5f, 15.0f, 8.5f);
+    return { position + localMin * m_scale, position + localMax * m_scale };
+}
 
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+GLsizei Windmill::indexCount() const {
+    return m_baseRange.indexCount + m_headRange.indexCount + (1 + kBladeCount) * m_bladeRange.indexCount;
+}
 
-    glActiveTexture(GL_TEXTURE0);
-    glUniform1i(textureSamplerLoc, 0);
+void Windmill::computePartTransforms(float currentTime, glm::mat4 (&parts)[kPartCount]) const {
+    computePartTransforms(headAngleAt(currentTime), bladeAngleAt(currentTime), parts);
+}
 
-    glDisable(GL_CULL_FACE);
+void Windmill::computePartTransforms(float headAngle, float bladeAngle, glm::mat4 (&parts)[kPartCount]) const {
+    computePartTransforms(m_position, m_scale, headAngle, bladeAngle, parts);
+}
 
+void Windmill::computePartTransforms(const glm::vec3& position, float scale, float headAngle, float bladeAngle,
+                                     glm::mat4 (&parts)[kPartCount]) {
     // --- Hierarchical Transformation ---
 
     glm::mat4 baseModel = glm::mat4(1.0f);
 
     float baseHeightLocal = 15.0f;
-    float windmillOverallScale = 4.0f;
-
-    glm::vec3 windmillPosition = glm::vec3(-625.73f, 53.98f, -350.15f);
-    baseModel = glm::translate(baseModel, windmillPosition);
-    baseModel = glm::scale(baseModel, glm::vec3(windmillOverallScale, windmillOverallScale, windmillOverallScale));
-
-    glBindTexture(GL_TEXTURE_2D, m_baseTextureID);
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(baseModel));
-    glBindVertexArray(m_baseVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    baseModel = glm::translate(baseModel, position);
+    baseModel = glm::scale(baseModel, glm::vec3(scale, scale, scale));
+    parts[PartBase] = baseModel;
 
 
     glm::mat4 headModel = glm::mat4(1.0f);
@@ -274,20 +179,13 @@ void Windmill::draw(const glm::mat4& view, const glm::mat4& projection, float cu
     float headTranslateY = (baseHeightLocal / 2.0f) + (headHeight / 2.0f);
     headModel = glm::translate(headModel, glm::vec3(0.0f, headTranslateY, 0.0f));
 
-    float headRotationAngle = currentTime * 0.2f;
-    headModel = glm::rotate(headModel, headRotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
+    headModel = glm::rotate(headModel, headAngle, glm::vec3(0.0f, 1.0f, 0.0f));
 
     float headWidthDepth = 3.0f;
     headModel = glm::scale(headModel, glm::vec3(headWidthDepth, headHeight, headWidthDepth));
 
     headModel = baseModel * headModel;
-
-    glBindTexture(GL_TEXTURE_2D, m_whiteTextureID);
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(headModel));
-    glBindVertexArray(m_headVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
+    parts[PartHead] = headModel;
 
 
     glm::mat4 bladesModel = glm::mat4(1.0f);
@@ -295,42 +193,95 @@ void Windmill::draw(const glm::mat4& view, const glm::mat4& projection, float cu
     float bladesTranslateZ = (headWidthDepth / 2.0f) - 0.5f;
     bladesModel = glm::translate(bladesModel, glm::vec3(0.0f, 0.0f, bladesTranslateZ));
 
-    float bladeRotationAngle = currentTime * 2.0f;
-    bladesModel = glm::rotate(bladesModel, bladeRotationAngle, glm::vec3(0.0f, 0.0f, 1.0f));
+    bladesModel = glm::rotate(bladesModel, bladeAngle, glm::vec3(0.0f, 0.0f, 1.0f));
 
     bladesModel = glm::scale(bladesModel, glm::vec3(0.5f, 0.5f, 0.5f));
 
     bladesModel = headModel * bladesModel;
+    parts[PartHub] = bladesModel;
 
-    glBindTexture(GL_TEXTURE_2D, m_whiteTextureID);
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(bladesModel));
-    glBindVertexArray(m_bladesVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-
-    int numBlades = 4;
     float bladeLength = 5.0f;
     float bladeWidth = 1.0f;
 
-    for (int i = 0; i < numBlades; ++i) {
+    for (int i = 0; i < kBladeCount; ++i) {
         glm::mat4 individualBladeModel = bladesModel;
 
-        float angleOffset = glm::radians(360.0f / numBlades * i);
+        float angleOffset = glm::radians(360.0f / kBladeCount * i);
         individualBladeModel = glm::rotate(individualBladeModel, angleOffset, glm::vec3(0.0f, 0.0f, 1.0f));
 
         individualBladeModel = glm::translate(individualBladeModel, glm::vec3(0.0f, bladeLength / 2.0f, 0.0f));
 
         individualBladeModel = glm::scale(individualBladeModel, glm::vec3(bladeWidth, bladeLength, 1.0f));
 
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(individualBladeModel));
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        parts[PartFirstBlade + i] = individualBladeModel;
     }
+}
+
+void Windmill::draw(const glm::vec3& position, float currentTime, StreamBuffer& objectStream, float fade) {
+    if (m_shaderProgram == 0) {
+        std::cerr << "Warning: Windmill shader program not set." << std::endl;
+        return;
+    }
+
+    glm::mat4 parts[kPartCount];
+    computePartTransforms(position, m_scale, headAngleAt(currentTime), bladeAngleAt(currentTime), parts);
+
+    glUseProgram(m_shaderProgram);
+    telemetry::add(telemetry::Counter::StateChanges);
+
+    glUniform1f(m_fadeLoc, fade);
+
+    glUniform1i(m_textureSamplerLoc, 0);
+
+    drawParts(m_shaderProgram, parts, objectStream);
 
-    glBindVertexArray(0);
     glUseProgram(0);
+}
 
-    GLenum err;
-    while ((err = glGetError()) != GL_NO_ERROR) {
-        std::cerr << "OpenGL error after windmill draw: " << err << std::endl;
+void Windmill::drawParts(GLuint program, const glm::mat4 (&parts)[kPartCount], StreamBuffer& objectStream) {
+    if (program != m_shaderProgram) {
+        GLuint objectBlock = glGetUniformBlockIndex(program, "ObjectBlock");
+        if (objectBlock == GL_INVALID_INDEX) return;
+        glUniformBlockBinding(program, objectBlock, kObjectBlockBinding);
     }
-}
\ No newline at end of file
+
+    // All part matrices go into the stream buffer up front; each draw then binds its slice.
+    StreamAllocation slots[kPartCount];
+    for (int i = 0; i < kPartCount; ++i) {
+        slots[i] = objectStream.allocateUniform(sizeof(glm::mat4));
+        if (!slots[i]) return;
+        std::memcpy(slots[i].data, glm::value_ptr(parts[i]), sizeof(glm::mat4));
+    }
+    objectStream.flush();
+
+    glActiveTexture(GL_TEXTURE0);
+
+    glDisable(GL_CULL_FACE);
+
+    auto drawPart = [&](int part, const MeshRange& range) {
+        glBindBufferRange(GL_UNIFORM_BUFFER, kObjectBlockBinding, objectStream.buffer(), slots[part].offset, slots[part].size);
+        glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_SHORT, (void*)range.indexOffset, range.baseVertex);
+        telemetry::add(telemetry::Counter::StateChanges);
+        telemetry::countDraw(range.indexCount / 3);
+    };
+
+    glBindVertexArray(m_vao.id());
+    telemetry::add(telemetry::Counter::StateChanges);
+
+    glBindTexture(GL_TEXTURE_2D, m_baseTexture.id());
+    telemetry::add(telemetry::Counter::TextureBinds);
+    drawPart(PartBase, m_baseRange);
+
+    glBindTexture(GL_TEXTURE_2D, m_whiteTexture.id());
+    telemetry::add(telemetry::Counter::TextureBinds);
+    drawPart(PartHead, m_headRange);
+
+    // The hub reuses the blade quad at half scale.
+    drawPart(PartHub, m_bladeRange);
+
+    for (int i = 0; i < kBladeCount; ++i) {
+        drawPart(PartFirstBlade + i, m_bladeRange);
+    }
+
+    glBindVertexArray(0);
+}
@@ -4,25 +4,90 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <vector> 
+
+#include "AABB.hpp"
+#include "GLResource.hpp"
+#include "StreamBuffer.hpp"
 
 class Windmill {
 public:
     Windmill();
     ~Windmill();
 
+    Windmill(const Windmill&) = delete;
+    Windmill& operator=(const Windmill&) = delete;
+    Windmill(Windmill&&) noexcept = default;
+    Windmill& operator=(Windmill&&) noexcept = default;
+
+    // Part order used by computePartTransforms.
+    enum Part { PartBase, PartHead, PartHub, PartFirstBlade };
+    static constexpr int kBladeCount = 4;
+    static constexpr int kPartCount = PartFirstBlade + kBladeCount;
+    // Uniform block binding point of the per-part model matrix.
+    static constexpr GLuint kObjectBlockBinding = 1;
+
     void setup(GLuint shaderProgram);
-    void draw(const glm::mat4& view, const glm::mat4& projection, float currentTime);
+    // Draws a copy of the windmill with its tower centered at position. Per-part model matrices
+    // are written into objectStream, which must be between beginFrame/endFrame. fade < 1 dithers
+    // the windmill out for LOD cross-fades. The camera comes from CameraUniforms. GL errors are
+    // left for the caller to check once per frame.
+    void draw(const glm::vec3& position, float currentTime, StreamBuffer& objectStream, float fade = 1.0f);
+    // Draws every part with `program`, which must take the windmill vertex layout and declare the
+    // ObjectBlock uniform block; all other uniforms are up to the caller.
+    void drawParts(GLuint program, const glm::mat4 (&parts)[kPartCount], StreamBuffer& objectStream);
+
+    // Animation angles (radians) at the given time.
+    static float headAngleAt(float currentTime) { return currentTime * 0.2f; }
+    static float bladeAngleAt(float currentTime) { return currentTime * 2.0f; }
+
+    // Model matrix of every part at the given time.
+    void computePartTransforms(float currentTime, glm::mat4 (&parts)[kPartCount]) const;
+    // Model matrix of every part for an explicit head yaw and blade rotation.
+    void computePartTransforms(float headAngle, float bladeAngle, glm::mat4 (&parts)[kPartCount]) const;
+    // The transform chain itself, for a windmill at position with the given scale. Needs no GL state.
+    static void computePartTransforms(const glm::vec3& position, float scale, float headAngle, float bladeAngle,
+                                      glm::mat4 (&parts)[kPartCount]);
+
+    // Position of the tower's center.
+    void setPosition(const glm::vec3& position) { m_position = position; }
+    const glm::vec3& position() const { return m_position; }
+    // Tower height below its center, in world units.
+    float baseHalfHeight() const { return 7.5f * m_scale; }
+
+    // Indices submitted by one draw(); every draw() issues kPartCount draw calls.
+    GLsizei indexCount() const;
+
+    // Conservative world-space bounds covering the tower, head and blades at any rotation.
+    AABB worldBounds() const { return worldBounds(m_position); }
+    // The same for a copy centered at position.
+    AABB worldBounds(const glm::vec3& position) const;
 
 private:
     GLuint m_shaderProgram;
+    GLint m_textureSamplerLoc = -1;
+    GLint m_fadeLoc = -1;
+
+    glm::vec3 m_position;
+    float m_scale;
+
+    // Indexed sub-mesh inside the shared vertex/index buffers.
+    struct MeshRange {
+        GLsizei indexCount = 0;
+        GLintptr indexOffset = 0;
+        GLint baseVertex = 0;
+    };
 
-    GLuint m_baseVAO, m_baseVBO;
-    GLuint m_headVAO, m_headVBO;
-    GLuint m_bladesVAO, m_bladesVBO;
+    GLVertexArray m_vao;
+    GLBuffer m_vbo;
+    GLBuffer m_ibo;
+    MeshRange m_baseRange;
+    MeshRange m_headRange;
+    MeshRange m_bladeRange;
 
-    GLuint m_baseTextureID;
-    GLuint m_whiteTextureID;
+    GLTexture m_baseTexture;
+    GLTexture m_whiteTexture;
 
-    void setupPart(GLuint& vao, GLuint& vbo, const std::vector<float>& vertices);
+    // Appends a compile-time mesh to the bound vertex/index buffers.
+    template <typename Mesh>
+    static MeshRange uploadPart(const Mesh& part, size_t& vertexCursor, size_t& indexCursor);
 };
\ No newline at end of file
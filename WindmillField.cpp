@@ -0,0 +1,151 @@
+#include "WindmillField.hpp"
+#include "FrameArena.hpp"
+#include "Frustum.hpp"
+#include "Heightfield.hpp"
+#include "OcclusionCuller.hpp"
+#include "Vegetation.hpp"
+#include "Windmill.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+static constexpr float kBladeCycle = 0.5f * 3.14159265358979f; // four blades repeat every quarter turn
+
+WindmillField::WindmillField(Windmill& windmill)
+    : m_windmill(windmill)
+{
+    m_sites.push_back({ windmill.position(), 0.0f });
+}
+
+void WindmillField::scatter(const Heightfield& heightfield, const ScatterRules& rules, int extra, float spacing, uint32_t seed) {
+    m_sites.resize(1);
+    if (!heightfield.isValid() || extra <= 0) return;
+
+    const glm::vec3 mapMin = heightfield.positionAt(0, 0);
+    const glm::vec3 mapMax = heightfield.positionAt(heightfield.width() - 1, heightfield.depth() - 1);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    // Rejection sampling: well inside the grass band, on slopes flat enough for a tower.
+    const int maxAttempts = extra * 200;
+    for (int attempt = 0; attempt < maxAttempts && static_cast<int>(m_sites.size()) < extra + 1; ++attempt) {
+        float x = mapMin.x + unit(rng) * (mapMax.x - mapMin.x);
+        float z = mapMin.z + unit(rng) * (mapMax.z - mapMin.z);
+        float h = heightfield.sampleHeight(x, z);
+        if (h < rules.sandTop + 5.0f || h > rules.grassTop) continue;
+        if (1.0f - heightfield.sampleNormal(x, z).y > rules.slopeRockStart * 0.5f) continue;
+
+        bool tooClose = std::any_of(m_sites.begin(), m_sites.end(), [&](const Site& site) {
+            float dx = site.position.x - x;
+            float dz = site.position.z - z;
+            return dx * dx + dz * dz < spacing * spacing;
+        });
+        if (tooClose) continue;
+
+        // Sunk a little so the tower base never floats on a slope.
+        glm::vec3 position(x, h + m_windmill.baseHalfHeight() - 2.0f, z);
+        m_sites.push_back({ position, unit(rng) * 100.0f });
+    }
+
+    std::cout << "Windmill field: " << m_sites.size() << " windmills" << std::endl;
+}
+
+bool WindmillField::bakeImpostor() {
+    // A private stream buffer large enough for every view of every frame in one go.
+    const size_t bytesPerDraw = Windmill::kPartCount * 256;
+    StreamBuffer bakeStream(bytesPerDraw * Impostor::kViewGrid * Impostor::kViewGrid * kImpostorFrames, "ImpostorBake");
+    bakeStream.beginFrame();
+
+    glm::mat4 parts[Windmill::kPartCount];
+    bool baked = m_impostor.bake(m_windmill.worldBounds(), kImpostorFrames, [&](GLuint program, int frame) {
+        float bladeAngle = kBladeCycle * frame / kImpostorFrames;
+        m_windmill.computePartTransforms(/*headAngle=*/0.0f, bladeAngle, parts);
+        m_windmill.drawParts(program, parts, bakeStream);
+    });
+
+    bakeStream.endFrame();
+    return baked;
+}
+
+void WindmillField::setImpostorDistance(float distance, float fadeBand) {
+    m_impostorDistance = distance;
+    m_fadeBand = std::max(fadeBand, 0.001f);
+}
+
+void WindmillField::draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, float currentTime,
+                         StreamBuffer& stream, OcclusionCuller* culler) {
+    m_frameStats = WindmillFieldStats();
+    m_impostor.resetFrameStats();
+
+    const Frustum frustum(projection * view);
+    const float fadeStart = m_impostorDistance - m_fadeBand;
+    const bool useImpostors = m_impostor.isBaked();
+
+    ImpostorInstance* impostors = frameArena().allocateArray<ImpostorInstance>(m_sites.size());
+    GLsizei impostorCount = 0;
+
+    for (const Site& site : m_sites) {
+        AABB bounds = m_windmill.worldBounds(site.position);
+        if (!frustum.intersects(bounds) || (culler && !culler->isVisible(bounds))) {
+            m_frameStats.culled++;
+            continue;
+        }
+
+        float time = currentTime + site.timeOffset;
+        float distance = glm::length(bounds.center() - cameraPos);
+        float meshFade = useImpostors ? 1.0f - std::clamp((distance - fadeStart) / m_fadeBand, 0.0f, 1.0f) : 1.0f;
+
+        if (meshFade > 0.0f) {
+            m_windmill.draw(site.position, time, stream, meshFade);
+            m_frameStats.meshInstances++;
+            m_frameStats.drawCalls += Windmill::kPartCount;
+            m_frameStats.vertices += m_windmill.indexCount();
+        }
+        if (meshFade < 1.0f && impostors) {
+            float phase = std::fmod(Windmill::bladeAngleAt(time), kBladeCycle) / kBladeCycle;
+            impostors[impostorCount++] = { bounds.center(), Windmill::headAngleAt(time), phase, 1.0f - meshFade };
+        }
+    }
+
+    m_impostor.draw(impostors, impostorCount, stream);
+
+    // Checked once per frame, not per windmill.
+    GLenum err;
+    while ((err = glGetError()) != GL_NO_ERROR) {
+        std::cerr << "OpenGL error after windmill field draw: " << err << std::endl;
+    }
+
+    m_frameStats.impostorInstances = static_cast<uint32_t>(impostorCount);
+    m_frameStats.drawCalls += m_impostor.frameStats().drawCalls;
+    m_frameStats.vertices += 4ull * m_impostor.frameStats().instancesDrawn;
+
+    // What the same windmills would have cost drawn as meshes only.
+    uint32_t visible = static_cast<uint32_t>(m_sites.size()) - m_frameStats.culled;
+    m_totalAllMeshDrawCalls += static_cast<uint64_t>(visible) * Windmill::kPartCount;
+    m_totalAllMeshVertices += static_cast<uint64_t>(visible) * m_windmill.indexCount();
+    m_totalDrawCalls += m_frameStats.drawCalls;
+    m_totalVertices += m_frameStats.vertices;
+    m_totalImpostors += m_frameStats.impostorInstances;
+    m_frames++;
+}
+
+void WindmillField::printStats() const {
+    if (m_frames == 0) return;
+
+    double drawCalls = static_cast<double>(m_totalDrawCalls) / m_frames;
+    double allMeshDrawCalls = static_cast<double>(m_totalAllMeshDrawCalls) / m_frames;
+    double vertices = static_cast<double>(m_totalVertices) / m_frames;
+    double allMeshVertices = static_cast<double>(m_totalAllMeshVertices) / m_frames;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Windmill field: " << m_sites.size() << " windmills, " << (static_cast<double>(m_totalImpostors) / m_frames)
+              << " impostors per frame on average" << std::endl
+              << "  draw calls per frame: " << drawCalls << " (meshes only: " << allMeshDrawCalls
+              << ", saved " << (allMeshDrawCalls - drawCalls) << ")" << std::endl
+              << "  vertices per frame: " << vertices << " (meshes only: " << allMeshVertices
+              << ", saved " << (allMeshVertices - vertices) << ")" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+}
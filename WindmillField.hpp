@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Impostor.hpp"
+#include "StreamBuffer.hpp"
+
+class Heightfield;
+class OcclusionCuller;
+class Windmill;
+struct ScatterRules;
+
+struct WindmillFieldStats {
+    uint32_t meshInstances = 0;     // drawn with full geometry (including those cross-fading)
+    uint32_t impostorInstances = 0; // drawn as impostor quads (including those cross-fading)
+    uint32_t culled = 0;
+    uint32_t drawCalls = 0;
+    uint64_t vertices = 0;          // indices submitted for meshes, 4 per impostor quad
+};
+
+// Every windmill on the island, drawn with the one Windmill mesh near the camera and as
+// impostors beyond impostorDistance, dithered across a fadeBand-wide overlap.
+class WindmillField {
+public:
+    // Blade frames baked into the impostor, spread over one quarter turn (the blades' symmetry).
+    static constexpr int kImpostorFrames = 4;
+
+    explicit WindmillField(Windmill& windmill);
+
+    WindmillField(const WindmillField&) = delete;
+    WindmillField& operator=(const WindmillField&) = delete;
+
+    // Keeps the windmill where it stands and adds `extra` copies on gentle grassland, at least
+    // `spacing` apart. Placement is deterministic for a given seed.
+    void scatter(const Heightfield& heightfield, const ScatterRules& rules, int extra, float spacing, uint32_t seed = 7);
+
+    // Renders the impostor atlases offscreen; call once after Windmill::setup().
+    bool bakeImpostor();
+    void setImpostorDistance(float distance, float fadeBand);
+    Impostor& impostor() { return m_impostor; }
+
+    // stream must be between beginFrame/endFrame; culler may be null.
+    void draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, float currentTime,
+              StreamBuffer& stream, OcclusionCuller* culler);
+
+    size_t size() const { return m_sites.size(); }
+    // Tower center of the index-th windmill; index 0 is the original one.
+    const glm::vec3& sitePosition(size_t index) const { return m_sites[index].position; }
+    const WindmillFieldStats& frameStats() const { return m_frameStats; }
+    void printStats() const;
+
+private:
+    struct Site {
+        glm::vec3 position;
+        float timeOffset; // desynchronizes the animation between windmills
+    };
+
+    Windmill& m_windmill;
+    Impostor m_impostor;
+    std::vector<Site> m_sites;
+    float m_impostorDistance = 500.0f;
+    float m_fadeBand = 50.0f;
+
+    WindmillFieldStats m_frameStats;
+    uint64_t m_totalDrawCalls = 0;
+    uint64_t m_totalVertices = 0;
+    uint64_t m_totalAllMeshDrawCalls = 0;
+    uint64_t m_totalAllMeshVertices = 0;
+    uint64_t m_totalImpostors = 0;
+    uint32_t m_frames = 0;
+};
@@ -1,10 +1,16 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <fstream>
-#include <sstream>
 #include <iomanip>
+#include <optional>
+#include <random>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -17,6 +23,29 @@
 #include "Skybox.hpp"
 #include "Camera.hpp"
 #include "Windmill.hpp"
+#include "Heightfield.hpp"
+#include "OcclusionCuller.hpp"
+#include "DynamicResolution.hpp"
+#include "GLResource.hpp"
+#include "FrameArena.hpp"
+#include "AllocationCounter.hpp"
+#include "StreamBuffer.hpp"
+#include "Vegetation.hpp"
+#include "WindmillField.hpp"
+#include "Telemetry.hpp"
+#include "ClusteredLighting.hpp"
+#include "LightBenchmark.hpp"
+#include "HeightTerrain.hpp"
+#include "HorizonMap.hpp"
+#include "FrameCapture.hpp"
+#include "ShaderUtils.hpp"
+#include "AssetBundle.hpp"
+#include "RenderGraph.hpp"
+#include "AntiAliasing.hpp"
+#include "CameraUniforms.hpp"
+#include "FramePacer.hpp"
+#include "IdleMode.hpp"
+#include "JobSystem.hpp"
 
 #define GL_CHECK_ERROR() \
     do { \
@@ -26,54 +55,97 @@
         } \
     } while (0)
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+// Returns a whole text file as a NUL-terminated string: straight from the mounted asset bundle
+// when it holds the file, otherwise read into the arena. Returns nullptr on failure.
+static const char* readTextFile(LinearArena& arena, const char* path) {
+    std::span<const std::byte> bundled = AssetBundle::instance().find(path);
+    if (!bundled.empty()) {
+        return reinterpret_cast<const char*>(bundled.data());
+    }
 
-    GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-    GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+    std::ifstream stream(path, std::ios::in | std::ios::binary);
+    if (!stream.is_open()) {
+        return nullptr;
+    }
+    stream.seekg(0, std::ios::end);
+    std::streamoff size = stream.tellg();
+    stream.seekg(0, std::ios::beg);
+    if (size < 0 || !stream) {
+        std::cerr << "Failed to read file: " << path << std::endl;
+        return nullptr;
+    }
 
-    std::string VertexShaderCode;
-    std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-    if(VertexShaderStream.is_open()){
-        std::stringstream sstr;
-        sstr << VertexShaderStream.rdbuf();
-        VertexShaderCode = sstr.str();
-        VertexShaderStream.close();
-    }else{
-        return 0;
+    char* text = arena.allocateArray<char>(static_cast<size_t>(size) + 1);
+    if (!text) {
+        return nullptr;
+    }
+    stream.read(text, size);
+    text[stream.gcount()] = '\0';
+    return text;
+}
+
+// Prints a shader's or program's info log. The log goes in the arena; if it does not fit,
+// only its size is reported.
+static void printInfoLog(LinearArena& arena, GLuint id, bool program, int length) {
+    char* log = arena.allocateArray<char>(static_cast<size_t>(length) + 1);
+    if (!log) {
+        std::cerr << "(" << length << " byte info log does not fit in the scratch arena)" << std::endl;
+        return;
+    }
+    if (program) {
+        glGetProgramInfoLog(id, length, NULL, log);
+    } else {
+        glGetShaderInfoLog(id, length, NULL, log);
     }
+    log[length] = '\0';
+    std::cerr << log << std::endl;
+}
+
+// fragment_library, if given, is spliced into the fragment shader after its #version line.
+GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path, const char * fragment_library = nullptr){
 
-    std::string FragmentShaderCode;
-    std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-    if(FragmentShaderStream.is_open()){
-        std::stringstream sstr;
-        sstr << FragmentShaderStream.rdbuf();
-        FragmentShaderCode = sstr.str();
-        FragmentShaderStream.close();
+    // Sources and info logs only live for the duration of this call.
+    LinearArena& arena = scratchArena();
+    ArenaScope scratchScope(arena);
+
+    const char* VertexSourcePointer = readTextFile(arena, vertex_file_path);
+    if (!VertexSourcePointer) {
+        return 0;
+    }
+    const char* FragmentSourcePointer = readTextFile(arena, fragment_file_path);
+    if (!FragmentSourcePointer) {
+        FragmentSourcePointer = "";
+    }
+    std::string FragmentWithLibrary;
+    if (fragment_library) {
+        FragmentWithLibrary = withShaderLibrary(FragmentSourcePointer, fragment_library);
+        FragmentSourcePointer = FragmentWithLibrary.c_str();
     }
 
+    GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+    GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+
     GLint Result = GL_FALSE;
     int InfoLogLength;
 
-    char const * VertexSourcePointer = VertexShaderCode.c_str();
     glShaderSource(VertexShaderID, 1, &VertexSourcePointer , NULL);
     glCompileShader(VertexShaderID);
 
     glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
     glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-    if ( InfoLogLength > 0 ){
-        std::vector<char> VertexShaderErrorMessage(InfoLogLength+1);
-        glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
+    if ( !Result && InfoLogLength > 0 ){
+        std::cerr << "ERROR::SHADER::COMPILATION_FAILED " << vertex_file_path << std::endl;
+        printInfoLog(arena, VertexShaderID, false, InfoLogLength);
     }
 
-    char const * FragmentSourcePointer = FragmentShaderCode.c_str();
     glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer , NULL);
     glCompileShader(FragmentShaderID);
 
     glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
     glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-    if ( InfoLogLength > 0 ){
-        std::vector<char> FragmentShaderErrorMessage(InfoLogLength+1);
-        glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
+    if ( !Result && InfoLogLength > 0 ){
+        std::cerr << "ERROR::SHADER::COMPILATION_FAILED " << fragment_file_path << std::endl;
+        printInfoLog(arena, FragmentShaderID, false, InfoLogLength);
     }
 
     GLuint ProgramID = glCreateProgram();
@@ -83,9 +155,9 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 
     glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
     glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-    if ( InfoLogLength > 0 ){
-        std::vector<char> ProgramErrorMessage(InfoLogLength+1);
-        glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
+    if ( !Result && InfoLogLength > 0 ){
+        std::cerr << "ERROR::PROGRAM::LINKING_FAILED" << std::endl;
+        printInfoLog(arena, ProgramID, true, InfoLogLength);
     }
 
     glDetachShader(ProgramID, VertexShaderID);
@@ -106,9 +178,6 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-Windmill windmill;
-GLuint windmillShaderProgram;
-
 
 static void glfw_error_cb(int code, const char* desc) {
     std::fprintf(stderr, "GLFW error %d: %s\n", code, desc ? desc : "(null)");
@@ -118,6 +187,14 @@ static void framebuffer_size_cb(GLFWwindow*, int w, int h) {
     glViewport(0, 0, w, h);
 }
 
+// True on the frame the key goes down.
+static bool keyPressed(GLFWwindow* window, int key, bool& wasDown) {
+    bool down = glfwGetKey(window, key) == GLFW_PRESS;
+    bool pressed = down && !wasDown;
+    wasDown = down;
+    return pressed;
+}
+
 void processInput(GLFWwindow *window)
 {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -140,6 +217,11 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(RIGHT, deltaTime);
 
     camera.MovementSpeed = currentCameraSpeed;
+
+    // F2 prints the live GPU memory report.
+    static bool reportKeyWasDown = false;
+    if (keyPressed(window, GLFW_KEY_F2, reportKeyWasDown))
+        GpuMemoryRegistry::instance().printReport();
 }
 
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
@@ -169,34 +251,88 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 }
 
 
-int main() {
-    glfwSetErrorCallback(glfw_error_cb);
-    if (!glfwInit()) {
-        return 1;
+// Local lights for the island: a lamp by the door of every windmill, then warm clusters of
+// lights on flat grassland standing in for villages. The first `count` lights make a
+// representative subset for any smaller count.
+static std::vector<PointLight> placeIslandLights(const Heightfield& heightfield, const ScatterRules& rules,
+                                                 const WindmillField& windmills, float towerHalfHeight,
+                                                 size_t count, uint32_t seed = 11) {
+    std::vector<PointLight> lights;
+    lights.reserve(count);
+    for (size_t i = 0; i < windmills.size() && lights.size() < count; ++i) {
+        glm::vec3 lamp = windmills.sitePosition(i) + glm::vec3(0.0f, -0.5f * towerHalfHeight, 0.4f * towerHalfHeight);
+        lights.push_back({ lamp, 25.0f, glm::vec3(1.0f, 0.75f, 0.45f), 2.0f });
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(1280, 720, "Island Demo", nullptr, nullptr);
-    if (!window) {
-        return 1;
+    if (!heightfield.isValid()) return lights;
+
+    const glm::vec3 mapMin = heightfield.positionAt(0, 0);
+    const glm::vec3 mapMax = heightfield.positionAt(heightfield.width() - 1, heightfield.depth() - 1);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    const int kLightsPerVillage = 32;
+    const float kVillageRadius = 60.0f;
+    glm::vec2 village(0.0f);
+    int villageLights = kLightsPerVillage;
+    for (int attempt = 0; lights.size() < count && attempt < static_cast<int>(count) * 200; ++attempt) {
+        glm::vec2 candidate;
+        if (villageLights >= kLightsPerVillage) {
+            candidate = glm::vec2(mapMin.x + unit(rng) * (mapMax.x - mapMin.x), mapMin.z + unit(rng) * (mapMax.z - mapMin.z));
+        } else {
+            float angle = unit(rng) * 6.2831853f;
+            float distance = kVillageRadius * std::sqrt(unit(rng));
+            candidate = village + glm::vec2(std::cos(angle), std::sin(angle)) * distance;
+        }
+        float h = heightfield.sampleHeight(candidate.x, candidate.y);
+        if (h < rules.sandTop || h > rules.grassTop) continue;
+        if (1.0f - heightfield.sampleNormal(candidate.x, candidate.y).y > rules.slopeRockStart * 0.5f) continue;
+
+        if (villageLights >= kLightsPerVillage) {
+            village = candidate;
+            villageLights = 0;
+        }
+        glm::vec3 color(1.0f, 0.55f + 0.3f * unit(rng), 0.25f + 0.3f * unit(rng));
+        lights.push_back({ glm::vec3(candidate.x, h + 4.0f, candidate.y), 14.0f + 10.0f * unit(rng), color, 1.5f });
+        villageLights++;
     }
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_cb);
-
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-
+    return lights;
+}
 
-    glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
-        return 1;
+// Command-line choices that shape the scene.
+struct SceneOptions {
+    bool lightBenchmark = false; // step through light counts and report frame times, then exit
+    bool heightTerrain = false;  // draw the terrain from the height texture instead of the Island mesh
+    bool headless = false;       // hidden window, fixed time step, frames read from the offscreen target
+    uint64_t frameLimit = 0;     // stop after this many frames; 0 runs until the window closes
+    std::string capturePath;     // record from the first frame: *.y4m, *.rgba, or a PNG directory
+    bool dumpRenderGraph = false; // print the compiled render graph once it first runs
+    AntiAliasingMode antiAliasing = AntiAliasingMode::Fxaa;
+    FramePacingConfig pacing;
+    IdleConfig idle;
+    std::chrono::steady_clock::time_point launchTime; // start of main(), for the startup time report
+};
+
+// Picks the capture format from the output path's extension.
+static FrameCaptureConfig captureConfigFor(const std::string& path) {
+    auto endsWith = [&path](const char* suffix) {
+        size_t length = std::strlen(suffix);
+        return path.size() >= length && path.compare(path.size() - length, length, suffix) == 0;
+    };
+    FrameCaptureConfig config;
+    config.path = path;
+    if (endsWith(".y4m")) {
+        config.format = CaptureFormat::Y4m;
+    } else if (endsWith(".rgba") || endsWith(".raw")) {
+        config.format = CaptureFormat::Raw;
+    } else {
+        config.format = CaptureFormat::Png;
     }
-    glGetError();
+    return config;
+}
 
+// Sets up the scene and runs the frame loop. All GL resources are owned by locals here,
+// so they are released before the context is destroyed.
+static int runScene(GLFWwindow* window, const SceneOptions& options) {
     glEnable(GL_DEPTH_TEST);
     GL_CHECK_ERROR();
     glCullFace(GL_BACK);
@@ -204,41 +340,54 @@ int main() {
     glFrontFace(GL_CCW);
     GL_CHECK_ERROR();
 
-    windmillShaderProgram = LoadShaders("shaders/SimpleColor.vert", "shaders/SimpleColor.frag");
-    if (windmillShaderProgram == 0) {
-        glfwDestroyWindow(window);
-        glfwTerminate();
+    std::string windmillLibrary = std::string(ClusteredLighting::shaderLibrary()) + ditherShaderLibrary();
+    GLProgram windmillShaderProgram = GLProgram::adopt(LoadShaders("shaders/SimpleColor.vert", "shaders/SimpleColor.frag",
+                                                                   windmillLibrary.c_str()), "Windmill");
+    if (!windmillShaderProgram) {
         return -1;
     }
-    windmill.setup(windmillShaderProgram);
-
-    Island island("assets/heightmap.png", /*heightScale=*/350.0f, /*gridScale=*/1.5f, /*center=*/true, /*sampleStep=*/1);
-    GL_CHECK_ERROR();
-
-    if (!island.isValid()) {
-        return 1;
-    }
-
-    if (!island.setTextures("assets/sand.png",
-                            "assets/grass.png",
-                            "assets/rock.png")) {
-        return 1;
-    }
-    GL_CHECK_ERROR();
+    ClusteredLighting::setupProgram(windmillShaderProgram.id());
+    Windmill windmill;
+    windmill.setup(windmillShaderProgram.id());
 
-    island.setBlendParams(/*seaLevel=*/0.0f, /*sandTop=*/30.0f, /*grassTop=*/100.0f, /*slopeRockStart=*/0.50f);
-    island.setTiling(4.0f, 6.0f, 8.0f);
+    // The same height/slope bands drive both the terrain blend and where props grow.
+    ScatterRules scatterRules;
+    scatterRules.seaLevel = 0.0f;
+    scatterRules.sandTop = 30.0f;
+    scatterRules.grassTop = 100.0f;
+    scatterRules.slopeRockStart = 0.50f;
 
     SunLight sun;
     sun.direction = glm::normalize(glm::vec3(-0.7f, -1.0f, -0.2f));
     sun.color = glm::vec3(1.0f);
     sun.intensity = 1.0f;
-    island.setSun(sun);
 
+    // CPU copy of the terrain: a coarse version of it is the software occluder for the props,
+    // and the vegetation is scattered over the full-resolution one.
+    OcclusionCuller occlusionCuller;
+    Vegetation vegetation;
+    vegetation.setSun(sun.direction, sun.color * sun.intensity);
+    WindmillField windmillField(windmill);
+
+    // The benchmark steps through these light counts; a normal run uses kDefaultLightCount.
+    const std::vector<uint32_t> kBenchmarkLightCounts = { 0, 64, 256, 1024, 4096 };
+    const size_t kDefaultLightCount = 256;
+    std::vector<PointLight> islandLights;
+    std::optional<LightBenchmark> lightBenchmark;
+    if (options.lightBenchmark) {
+        lightBenchmark.emplace(kBenchmarkLightCounts);
+    }
+    ClusteredLighting clusteredLighting;
+    HeightTerrain heightTerrain;
+    HorizonMap horizonMap;
     Skybox skybox;
+    std::optional<Island> island;
     GL_CHECK_ERROR();
 
-    std::vector<std::string> skyboxFaces = {
+    // Startup as a task graph. The skybox faces and the heightfield decode on the workers, and
+    // everything scattered over the heightfield follows there, while the main thread builds the
+    // island mesh; each GL upload is a main-thread task that waits only on the data it uploads.
+    const char* const skyboxPaths[Skybox::kFaceCount] = {
         "assets/right.png",
         "assets/left.png",
         "assets/top.png",
@@ -246,51 +395,562 @@ int main() {
         "assets/front.png",
         "assets/back.png"
     };
+    Skybox::Face skyboxFaces[Skybox::kFaceCount];
+    Heightfield terrainHeights;
+    bool islandLoaded = false;
+    bool skyboxLoaded = false;
+
+    TaskGraph startup;
+    startup.add("Island mesh", [&] {
+        island.emplace("assets/heightmap.png", /*heightScale=*/350.0f, /*gridScale=*/1.5f, /*center=*/true, /*sampleStep=*/1);
+        if (!island->isValid() || !island->setTextures("assets/sand.png", "assets/grass.png", "assets/rock.png")) {
+            return;
+        }
+        island->setBlendParams(scatterRules.seaLevel, scatterRules.sandTop, scatterRules.grassTop, scatterRules.slopeRockStart);
+        island->setTiling(4.0f, 6.0f, 8.0f);
+        island->setSun(sun);
+        islandLoaded = true;
+        GL_CHECK_ERROR();
+    }, JobAffinity::MainThread);
+
+    TaskGraph::TaskId skyboxUpload = startup.add("Skybox upload", [&] {
+        skyboxLoaded = skybox.upload(skyboxFaces);
+        GL_CHECK_ERROR();
+    }, JobAffinity::MainThread);
+    for (int i = 0; i < Skybox::kFaceCount; ++i) {
+        TaskGraph::TaskId decode = startup.add("Skybox face decode", [&, i] { skyboxFaces[i].decode(skyboxPaths[i]); });
+        startup.precede(decode, skyboxUpload);
+    }
+
+    TaskGraph::TaskId heights = startup.add("Heightfield decode", [&] {
+        terrainHeights = Heightfield("assets/heightmap.png", /*heightScale=*/350.0f, /*gridScale=*/1.5f, /*center=*/true);
+    });
+    TaskGraph::TaskId occluder = startup.add("Occluder mesh", [&] {
+        if (terrainHeights.isValid()) occlusionCuller.setOccluder(terrainHeights, /*step=*/16);
+    });
+    startup.precede(heights, occluder);
+
+    TaskGraph::TaskId vegetationScatter = startup.add("Vegetation scatter", [&] {
+        vegetation.generate(terrainHeights, scatterRules, "vegetation_cache.bin");
+    });
+    TaskGraph::TaskId vegetationUpload = startup.add("Vegetation upload", [&] { vegetation.upload(); }, JobAffinity::MainThread);
+    startup.precede(heights, vegetationScatter);
+    startup.precede(vegetationScatter, vegetationUpload);
+
+    // Lamps stand by the windmill doors, so the lights wait for the windmills.
+    TaskGraph::TaskId windmillScatter = startup.add("Windmill scatter", [&] {
+        if (terrainHeights.isValid()) windmillField.scatter(terrainHeights, scatterRules, /*extra=*/48, /*spacing=*/80.0f);
+    });
+    TaskGraph::TaskId lightPlacement = startup.add("Light placement", [&] {
+        size_t lightCount = options.lightBenchmark ? kBenchmarkLightCounts.back() : kDefaultLightCount;
+        islandLights = placeIslandLights(terrainHeights, scatterRules, windmillField, windmill.baseHalfHeight(), lightCount);
+    });
+    TaskGraph::TaskId lightUpload = startup.add("Light upload", [&] {
+        clusteredLighting.setLights(islandLights.data(),
+                                    lightBenchmark ? std::min<size_t>(lightBenchmark->lightCount(), islandLights.size()) : islandLights.size());
+        GL_CHECK_ERROR();
+    }, JobAffinity::MainThread);
+    startup.precede(heights, windmillScatter);
+    startup.precede(windmillScatter, lightPlacement);
+    startup.precede(lightPlacement, lightUpload);
+
+    // Distant windmills are drawn as impostors baked from the mesh.
+    startup.add("Impostor bake", [&] {
+        windmillField.bakeImpostor();
+        windmillField.setImpostorDistance(/*distance=*/500.0f, /*fadeBand=*/50.0f);
+        GL_CHECK_ERROR();
+    }, JobAffinity::MainThread);
+
+    if (options.heightTerrain) {
+        TaskGraph::TaskId horizonBake = startup.add("Horizon bake", [&] {
+            horizonMap.build(terrainHeights, "horizon_cache.bin");
+        });
+        TaskGraph::TaskId terrainUpload = startup.add("Height terrain upload", [&] {
+            if (!terrainHeights.isValid() || !heightTerrain.build(terrainHeights)) return;
+            heightTerrain.setBlendParams(scatterRules.seaLevel, scatterRules.sandTop, scatterRules.grassTop, scatterRules.slopeRockStart);
+            heightTerrain.setSun(sun.direction, sun.color * sun.intensity);
+            horizonMap.upload();
+            if (horizonMap.isValid()) {
+                heightTerrain.setHorizonMap(&horizonMap);
+            }
+            heightTerrain.printMemoryReport();
+            GL_CHECK_ERROR();
+        }, JobAffinity::MainThread);
+        startup.precede(heights, horizonBake);
+        startup.precede(horizonBake, terrainUpload);
+    }
+
+    startup.run();
+    startup.wait();
+    // The heights were only needed to build from.
+    terrainHeights = Heightfield();
 
-    if (!skybox.load(skyboxFaces)) {
+    if (!islandLoaded) {
+        return 1;
+    }
+    if (!skyboxLoaded) {
         return -1;
     }
+
+    // The scene renders offscreen at a scale driven by GPU frame time, then gets upscaled to the window.
+    DynamicResolutionConfig dynresConfig;
+    dynresConfig.minScale = 0.5f;
+    dynresConfig.maxScale = 1.0f;
+    dynresConfig.targetFrameMs = 1000.0f / 60.0f * 0.9f;
+    if (options.lightBenchmark || options.headless) {
+        // Every benchmark step renders the same pixel count, and every captured frame has the same size.
+        dynresConfig.minScale = dynresConfig.maxScale;
+    }
+    DynamicResolution dynamicResolution(dynresConfig);
+    GL_CHECK_ERROR();
+
+    // F5 cycles vsync, F6 the frames in flight, F7 toggles late latching of the camera.
+    FramePacer framePacer(options.pacing);
+    bool swapKeyWasDown = false;
+    bool framesInFlightKeyWasDown = false;
+    bool lateLatchKeyWasDown = false;
+
+    // Post-process AA between the scene and the upscale; F4 cycles off / FXAA / TAA.
+    AntiAliasing antiAliasing(options.antiAliasing);
+    bool antiAliasingKeyWasDown = false;
+    GL_CHECK_ERROR();
+
+    // A still camera caches the sky, terrain and vegetation and redraws only the windmills, at a reduced rate.
+    IdleMode idleMode(options.idle);
     GL_CHECK_ERROR();
 
+    // Per-frame uniforms and dynamic data.
+    StreamBuffer frameStream(size_t(256) << 10, "FrameStream");
+
+    // F12 saves a screenshot; F9 starts/stops recording to --capture's path.
+    FrameCapture frameCapture(captureConfigFor(options.capturePath));
+    frameCapture.setRecording(frameCapture.isOpen());
+    bool screenshotKeyWasDown = false;
+    bool recordKeyWasDown = false;
+
+    GpuMemoryRegistry::instance().setBudget(size_t(512) << 20);
+    GpuMemoryRegistry::instance().printReport();
+
+    // After a short warm-up the render loop must not touch the heap; see AllocationCounter.hpp.
+    const uint64_t kAllocationWarmupFrames = 120;
+    AllocationGuard frameAllocations;
+    uint64_t frameIndex = 0;
+
+    // Per-frame values the passes below read.
+    int w = 0, h = 0;
+    float currentFrame = 0.0f;
+    glm::mat4 view(1.0f);
+    glm::mat4 unjitteredProj(1.0f);
+    glm::mat4 proj(1.0f);            // jittered while TAA is on
+    glm::mat4 viewProjection(1.0f);  // never jittered
+
+    // The frame as a render graph. The scene target and the FXAA output are transients the graph
+    // allocates and may alias; TAA's output is its history, which outlives the frame, so it is
+    // imported. Passes differ per anti-aliasing mode, so a mode change declares the graph again.
+    RenderGraph renderGraph;
+    RenderGraphResource backbuffer, clusterData, sceneColor, sceneDepth, taaHistory, antiAliased;
+    auto declareRenderGraph = [&]() {
+        const AntiAliasingMode mode = antiAliasing.mode();
+        renderGraph.reset();
+        backbuffer = renderGraph.importBackbuffer("Backbuffer");
+        // The cluster UBO goes through the frame stream; the light data textures are rebound by update().
+        clusterData = renderGraph.importBuffer("LightClusters", frameStream.buffer());
+        taaHistory = mode == AntiAliasingMode::Taa ? renderGraph.importTexture("TaaHistory", 0, 0, 0, GL_RGBA8)
+                                                   : RenderGraphResource{};
+
+        renderGraph.addPass("LightClusters",
+            [&](RenderGraph::PassBuilder& pass) { pass.write(clusterData); },
+            [&](const RenderGraph::PassContext&) {
+                clusteredLighting.update(view, proj, dynamicResolution.renderWidth(), dynamicResolution.renderHeight(), frameStream);
+                GL_CHECK_ERROR();
+            });
+        renderGraph.addPass("Scene",
+            [&](RenderGraph::PassBuilder& pass) {
+                pass.read(clusterData);
+                sceneColor = pass.create("SceneColor", { GL_RGBA8 });
+                sceneDepth = pass.create("SceneDepth", { GL_DEPTH_COMPONENT24 });
+            },
+            [&](const RenderGraph::PassContext& context) {
+                if (framePacer.lateLatch()) {
+                    // Mouse motion since the frame started turns the camera once more before the draws
+                    // read it. The occluder and light clusters keep the earlier view; the difference is
+                    // a fraction of a frame of motion.
+                    glfwPollEvents();
+                    framePacer.markInputSampled();
+                    view = camera.GetViewMatrix();
+                    viewProjection = unjitteredProj * view;
+                }
+                CameraUniforms::latch(view, proj, camera.Position, frameStream);
+
+                // Only the part of the target at this frame's scale is drawn.
+                glViewport(0, 0, dynamicResolution.renderWidth(), dynamicResolution.renderHeight());
+                if (idleMode.beginScene(view, unjitteredProj, dynamicResolution.renderWidth(), dynamicResolution.renderHeight(),
+                                        dynamicResolution.targetWidth(), dynamicResolution.targetHeight())) {
+                    idleMode.restoreStaticLayers(context.framebuffer(sceneColor));
+                    GL_CHECK_ERROR();
+                } else {
+                    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    GL_CHECK_ERROR();
+
+                    skybox.draw();
+                    GL_CHECK_ERROR();
+
+                    if (heightTerrain.isValid()) {
+                        heightTerrain.draw(view, proj, frameStream);
+                    } else {
+                        island->draw(view, proj, camera.Position);
+                    }
+                    GL_CHECK_ERROR();
+
+                    vegetation.draw(view, proj, camera.Position, &occlusionCuller);
+                    GL_CHECK_ERROR();
+
+                    idleMode.staticLayersDrawn(context.framebuffer(sceneColor));
+                    GL_CHECK_ERROR();
+                }
+
+                windmillField.draw(view, proj, camera.Position, currentFrame, frameStream, &occlusionCuller);
+                GL_CHECK_ERROR();
+
+                occlusionCuller.endFrame();
+            });
+        if (mode == AntiAliasingMode::Off) {
+            antiAliased = sceneColor;
+        } else {
+            renderGraph.addPass("AntiAliasing",
+                [&, mode](RenderGraph::PassBuilder& pass) {
+                    pass.read(sceneColor);
+                    if (mode == AntiAliasingMode::Taa) {
+                        pass.read(sceneDepth);
+                        antiAliased = pass.write(taaHistory);
+                    } else {
+                        antiAliased = pass.create("FxaaOutput", { GL_RGBA8 });
+                    }
+                },
+                [&](const RenderGraph::PassContext& context) {
+                    antiAliasing.resolve(context.resource(sceneColor), context.resource(sceneDepth),
+                                         dynamicResolution.renderWidth(), dynamicResolution.renderHeight(), viewProjection,
+                                         context.framebuffer(antiAliased));
+                    GL_CHECK_ERROR();
+                });
+        }
+        renderGraph.addPass("Present",
+            [&](RenderGraph::PassBuilder& pass) {
+                pass.read(antiAliased);
+                pass.write(backbuffer);
+            },
+            [&](const RenderGraph::PassContext& context) {
+                dynamicResolution.present(w, h, context.resource(antiAliased));
+                GL_CHECK_ERROR();
+            });
+        renderGraph.addPass("Capture",
+            [&](RenderGraph::PassBuilder& pass) {
+                pass.read(options.headless ? antiAliased : backbuffer);
+                pass.setSideEffect();
+            },
+            [&](const RenderGraph::PassContext& context) {
+                // The hidden window of a headless run may have no pixels of its own; read the scene target instead.
+                if (options.headless) {
+                    frameCapture.capture(context.framebuffer(antiAliased), 0, 0, dynamicResolution.renderWidth(),
+                                         dynamicResolution.renderHeight(), frameIndex);
+                } else {
+                    frameCapture.capture(0, 0, 0, w, h, frameIndex);
+                }
+                GL_CHECK_ERROR();
+            });
+    };
+    declareRenderGraph();
+    bool renderGraphPrinted = !options.dumpRenderGraph;
 
     while (!glfwWindowShouldClose(window)) {
-        float currentFrame = static_cast<float>(glfwGetTime());
+        // Idle frames sleep until the next animation tick; any input wakes the loop at once.
+        bool idleWait = idleMode.isIdle();
+        idleMode.waitForNextTick();
+
+        // A headless run advances a fixed 1/60 s per frame, so captures play back at real speed.
+        currentFrame = options.headless ? frameIndex / 60.0f : static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        if (idleWait) {
+            // A key that ends a long idle wait moves the camera by one frame, not by the whole wait.
+            deltaTime = std::min(deltaTime, 1.0f / 30.0f);
+        }
 
-        processInput(window);
-
+        // Block on the GPU first, then read input: it is then at most framesInFlight frames from the screen.
+        framePacer.waitForFrameSlot();
         glfwPollEvents();
+        processInput(window);
+        framePacer.markInputSampled();
         GL_CHECK_ERROR();
 
-        int w, h;
+        if (keyPressed(window, GLFW_KEY_F12, screenshotKeyWasDown)) {
+            frameCapture.requestScreenshot();
+        }
+        if (keyPressed(window, GLFW_KEY_F9, recordKeyWasDown) && frameCapture.isOpen()) {
+            frameCapture.setRecording(!frameCapture.isRecording());
+            std::cout << (frameCapture.isRecording() ? "Recording to " : "Recording paused: ") << options.capturePath << std::endl;
+        }
+        if (keyPressed(window, GLFW_KEY_F4, antiAliasingKeyWasDown)) {
+            antiAliasing.cycleMode();
+            declareRenderGraph();
+            renderGraphPrinted = !options.dumpRenderGraph;
+        }
+        if (keyPressed(window, GLFW_KEY_F5, swapKeyWasDown)) {
+            framePacer.cycleSwapMode();
+        }
+        if (keyPressed(window, GLFW_KEY_F6, framesInFlightKeyWasDown)) {
+            framePacer.cycleFramesInFlight();
+        }
+        if (keyPressed(window, GLFW_KEY_F7, lateLatchKeyWasDown)) {
+            framePacer.setLateLatch(!framePacer.lateLatch());
+        }
+
+        // Everything that may allocate happens here, before the no-allocation part of the frame:
+        // TAA history and the graph's transients follow the target size, and a mode change above
+        // recompiles the graph. Capture slots grow too; a readback is collected a frame or more
+        // after it was taken, by which time this has seen its size.
         glfwGetFramebufferSize(window, &w, &h);
-        glViewport(0, 0, w, h);
+        dynamicResolution.resize(w, h);
+        const int targetWidth = dynamicResolution.targetWidth();
+        const int targetHeight = dynamicResolution.targetHeight();
+        antiAliasing.beginFrame(targetWidth, targetHeight);
+        frameCapture.reserve(std::max(w, targetWidth), std::max(h, targetHeight));
+        renderGraph.setReferenceSize(targetWidth, targetHeight);
+        renderGraph.updateImport(backbuffer, 0, w, h);
+        if (taaHistory) {
+            // TAA swaps history targets every frame; the graph only looks the framebuffer up when it runs.
+            renderGraph.updateImport(taaHistory, antiAliasing.outputTexture(), targetWidth, targetHeight,
+                                     antiAliasing.outputFramebuffer());
+        }
+        if (renderGraph.isDirty()) renderGraph.compile();
         GL_CHECK_ERROR();
 
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        frameArena().beginFrame();
+        frameAllocations.begin();
+        frameStream.beginFrame();
+        frameCapture.poll();
+
+        // Picks this frame's scale and starts the GPU timer. The cheap idle frames would otherwise
+        // raise the scale, change the render size and end idling.
+        dynamicResolution.setHold(idleMode.isSettling());
+        dynamicResolution.beginScene();
         GL_CHECK_ERROR();
 
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 proj = glm::perspective(glm::radians(camera.Zoom), (float)w / (float)h, 0.1f, 4000.0f);
+        view = camera.GetViewMatrix();
+        unjitteredProj = glm::perspective(glm::radians(camera.Zoom), (float)w / (float)h, 0.1f, 4000.0f);
+        viewProjection = unjitteredProj * view;
+        // The jitter holds while the view is still, so cached layers and fresh windmills line up.
+        proj = antiAliasing.jitter(unjitteredProj, dynamicResolution.renderWidth(), dynamicResolution.renderHeight(),
+                                   idleMode.isSettling());
+
+        // Rasterize the terrain occluder on the worker while the GPU draws the sky and terrain.
+        occlusionCuller.beginFrame(viewProjection);
+
+        idleMode.beginFrameTiming();
+        renderGraph.execute();
+        idleMode.endFrameTiming();
+        frameStream.endFrame();
+        if (!renderGraphPrinted) {
+            renderGraph.printCompiled();
+            renderGraphPrinted = true;
+        }
+
+        if (frameIndex++ >= kAllocationWarmupFrames) {
+            frameAllocations.end("render loop", frameIndex);
+        }
+
+        Telemetry::instance().endFrame(deltaTime * 1000.0);
+
+        if (lightBenchmark && lightBenchmark->recordFrame(deltaTime * 1000.0, clusteredLighting.frameStats().buildMs,
+                                                          dynamicResolution.lastGpuMs())) {
+            if (lightBenchmark->finished()) {
+                glfwSetWindowShouldClose(window, true);
+            } else {
+                clusteredLighting.setLights(islandLights.data(), std::min<size_t>(lightBenchmark->lightCount(), islandLights.size()));
+            }
+        }
 
-        skybox.draw(view, proj);
+        glfwSwapBuffers(window);
+        framePacer.endFrame();
         GL_CHECK_ERROR();
 
-        island.draw(view, proj, camera.Position);
-        GL_CHECK_ERROR();
+        if (frameIndex == 1) {
+            // Startup ends when the first frame is on screen. Measure cold starts after
+            // `sync; echo 3 > /proc/sys/vm/drop_caches`, with and without --no-bundle.
+            glFinish();
+            double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - options.launchTime).count();
+            std::cout << "Startup: " << std::fixed << std::setprecision(1) << startupMs << " ms to first frame ("
+                      << (AssetBundle::instance().isMounted() ? "asset bundle" : "loose files") << ")" << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+        }
+
+        if (options.frameLimit > 0 && frameIndex >= options.frameLimit) {
+            glfwSetWindowShouldClose(window, true);
+        }
+    }
 
-        windmill.draw(view, proj, currentFrame);
-        GL_CHECK_ERROR();
+    frameCapture.finish();
+
+    occlusionCuller.printStats();
+    clusteredLighting.printStats();
+    vegetation.printStats();
+    windmillField.printStats();
+    dynamicResolution.printStats();
+    dynamicResolution.writeHistory("scale_history.csv");
+    antiAliasing.printStats();
+    framePacer.printStats();
+    framePacer.writeHistory("latency_history.csv");
+    idleMode.printStats();
+    frameStream.printStats();
+    frameCapture.printStats();
+    JobSystem::instance().printStats();
+
+    if (lightBenchmark) {
+        lightBenchmark->printResults();
+        lightBenchmark->writeCsv("light_benchmark.csv");
+    }
 
-        glfwSwapBuffers(window);
-        GL_CHECK_ERROR();
+    GpuMemoryRegistry::instance().printReport();
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    // --telemetry-socket <path> serves live counters; --telemetry-csv <path> logs them per frame.
+    // --light-benchmark measures frame time against the number of local lights, then exits.
+    // --height-terrain draws the terrain from a height texture with no vertex buffer.
+    // --capture <path> records every frame (.y4m video, .rgba raw frames, else a PNG directory);
+    // --headless renders without showing the window; --frames <n> exits after n frames.
+    // --dump-render-graph prints the compiled frame: pass order, culled passes, transient memory.
+    // --aa off|fxaa|taa picks the post-process anti-aliasing (default fxaa); F4 cycles it while running.
+    // --vsync off|on|adaptive, --frames-in-flight <1-3> and --no-late-latch set the frame pacing;
+    // --low-latency is one frame in flight with late latching.
+    // --idle-fps <hz> sets the animation rate while the camera is still (0 redraws only on input); --no-idle disables idling.
+    // --job-timeline <path> records every job, startup included, as a Chrome trace (chrome://tracing).
+    // --bundle <path> loads assets from a packed bundle (default island.pak when present); --no-bundle reads loose files.
+    SceneOptions options;
+    options.launchTime = std::chrono::steady_clock::now();
+    const char* bundlePath = "island.pak";
+    const char* jobTimelinePath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        // If argv[i] is flag, returns the argument after it and steps past it. A flag given as
+        // the last argument is reported here rather than as unknown.
+        bool missingValue = false;
+        auto flagValue = [&](const char* flag) -> const char* {
+            if (std::strcmp(argv[i], flag) != 0) return nullptr;
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << flag << std::endl;
+                missingValue = true;
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char* value = nullptr;
+
+        if ((value = flagValue("--telemetry-socket"))) {
+            Telemetry::instance().startServer(value);
+        } else if ((value = flagValue("--telemetry-csv"))) {
+            Telemetry::instance().openCsv(value);
+        } else if (std::strcmp(argv[i], "--light-benchmark") == 0) {
+            options.lightBenchmark = true;
+        } else if (std::strcmp(argv[i], "--height-terrain") == 0) {
+            options.heightTerrain = true;
+        } else if ((value = flagValue("--capture"))) {
+            options.capturePath = value;
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            options.headless = true;
+        } else if ((value = flagValue("--frames"))) {
+            options.frameLimit = std::strtoull(value, nullptr, 10);
+        } else if ((value = flagValue("--bundle"))) {
+            bundlePath = value;
+        } else if (std::strcmp(argv[i], "--no-bundle") == 0) {
+            bundlePath = nullptr;
+        } else if (std::strcmp(argv[i], "--dump-render-graph") == 0) {
+            options.dumpRenderGraph = true;
+        } else if ((value = flagValue("--aa"))) {
+            if (!parseAntiAliasingMode(value, options.antiAliasing)) {
+                std::cerr << "Unknown anti-aliasing mode: " << argv[i] << " (off, fxaa or taa)" << std::endl;
+            }
+        } else if ((value = flagValue("--vsync"))) {
+            if (!parseSwapMode(value, options.pacing.swapMode)) {
+                std::cerr << "Unknown vsync mode: " << argv[i] << " (off, on or adaptive)" << std::endl;
+            }
+        } else if ((value = flagValue("--frames-in-flight"))) {
+            options.pacing.framesInFlight = std::atoi(value);
+        } else if (std::strcmp(argv[i], "--no-late-latch") == 0) {
+            options.pacing.lateLatch = false;
+        } else if (std::strcmp(argv[i], "--low-latency") == 0) {
+            options.pacing.framesInFlight = 1;
+            options.pacing.lateLatch = true;
+        } else if ((value = flagValue("--idle-fps"))) {
+            options.idle.animationHz = static_cast<float>(std::atof(value));
+        } else if (std::strcmp(argv[i], "--no-idle") == 0) {
+            options.idle.enabled = false;
+        } else if ((value = flagValue("--job-timeline"))) {
+            jobTimelinePath = value;
+        } else if (!missingValue) {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+        }
     }
 
-    glDeleteProgram(windmillShaderProgram);
+    // Map the bundle and start reading it in load order while the window and context come up.
+    if (bundlePath && AssetBundle::instance().mount(bundlePath)) {
+        AssetBundle::instance().prefetch(bundle_format::kLoadOrder);
+    }
+
+    glfwSetErrorCallback(glfw_error_cb);
+    if (!glfwInit()) {
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (options.headless) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
+    GLFWwindow* window = glfwCreateWindow(1280, 720, "Island Demo", nullptr, nullptr);
+    if (!window) {
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    // The benchmark and headless runs need uncapped frame times and a camera that stays where it starts.
+    if (options.lightBenchmark || options.headless) {
+        options.pacing.swapMode = SwapMode::Immediate;
+        options.idle.enabled = false;
+    }
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_cb);
+
+    if (!options.lightBenchmark && !options.headless) {
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+    }
+
+
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        return 1;
+    }
+    glGetError();
+
+    // This thread owns the context, so it is the job system's main thread.
+    JobSystem::instance().setTracing(jobTimelinePath != nullptr);
+    JobSystem::instance().start();
+
+    int result = runScene(window, options);
+
+    if (jobTimelinePath) {
+        JobSystem::instance().writeTimeline(jobTimelinePath);
+    }
+    JobSystem::instance().stop();
+
+    // Everything created through GLHandle is gone by now; anything left is a leak.
+    GpuMemoryRegistry::instance().reportLeaks();
+
+    Telemetry::instance().stopServer();
 
     glfwDestroyWindow(window);
     glfwTerminate();
-    return 0;
+    return result;
 }
\ No newline at end of file
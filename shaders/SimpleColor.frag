@@ -1,13 +1,26 @@
 #version 330 core
+// clusteredPointLights() and ditherThreshold() are spliced in after the #version line by the
+// loader (see ClusteredLighting::shaderLibrary() and ditherShaderLibrary()).
 out vec4 FragColor;
 
 in vec3 vColor;
 in vec2 vTexCoord;
+in vec3 vWorldPos;
+in float vViewDepth;
 
 uniform sampler2D textureSampler;
+uniform float fade = 1.0; // < 1 while cross-fading to the impostor
 
 void main()
 {
+    // Screen-door fade; the impostor covers exactly the discarded pixels.
+    if (ditherThreshold() >= fade) discard;
+
     // Sample the texture and multiply by the vertex color
-    FragColor = texture(textureSampler, vTexCoord) * vec4(vColor, 1.0);
-}
\ No newline at end of file
+    vec4 base = texture(textureSampler, vTexCoord) * vec4(vColor, 1.0);
+
+    // The mesh has no normals; the flat face normal is enough for its boxes and blades.
+    vec3 normal = normalize(cross(dFdx(vWorldPos), dFdy(vWorldPos)));
+    vec3 lights = clusteredPointLights(vWorldPos, normal, vViewDepth);
+    FragColor = vec4(base.rgb * (1.0 + lights), base.a);
+}
@@ -5,14 +5,29 @@ layout (location = 2) in vec2 aTexCoord;
 
 out vec3 vColor;
 out vec2 vTexCoord;
+out vec3 vWorldPos;
+out float vViewDepth;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform ObjectBlock
+{
+    mat4 model;
+};
+// Bound by CameraUniforms::latch() at binding 0, the default, so every program using this shader reads it.
+layout (std140) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+};
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vec4 world = model * vec4(aPos, 1.0);
+    vec4 viewPos = view * world;
+    gl_Position = projection * viewPos;
+    vWorldPos = world.xyz;
+    vViewDepth = -viewPos.z;
     vColor = aColor;
     vTexCoord = aTexCoord;
 }
\ No newline at end of file